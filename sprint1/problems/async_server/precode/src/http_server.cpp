@@ -1,6 +1,558 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <new>
+#include <stdexcept>
 
-namespace http_server {}  // namespace http_server
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+#ifdef HTTP_SERVER_COUNT_HEAP_ALLOCATIONS
+
+// Количество вызовов глобального operator new в текущем потоке
+thread_local std::uint64_t thread_heap_allocations = 0;
+// Глубина вложенности HeapAllocationScope в текущем потоке
+thread_local int heap_allocation_scope_depth = 0;
+
+// Учитывает в SessionStats::heap_allocations вызовы operator new, сделанные за время жизни
+// объекта. Обработчики сессии вызывают друг друга напрямую, например, через net::dispatch,
+// поэтому учитывает только внешний объект
+class HeapAllocationScope {
+public:
+    HeapAllocationScope() noexcept
+        : start_{thread_heap_allocations} {
+        ++heap_allocation_scope_depth;
+    }
+
+    HeapAllocationScope(const HeapAllocationScope&) = delete;
+    HeapAllocationScope& operator=(const HeapAllocationScope&) = delete;
+
+    ~HeapAllocationScope() {
+        if (--heap_allocation_scope_depth == 0) {
+            GetSessionStats().heap_allocations.fetch_add(thread_heap_allocations - start_,
+                                                         std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::uint64_t start_;
+};
+
+#else
+
+// Без HTTP_SERVER_COUNT_HEAP_ALLOCATIONS operator new не заменён и обращения к куче не учитываются
+class HeapAllocationScope {
+public:
+    HeapAllocationScope() noexcept {
+    }
+
+    HeapAllocationScope(const HeapAllocationScope&) = delete;
+    HeapAllocationScope& operator=(const HeapAllocationScope&) = delete;
+};
+
+#endif
+
+class CountingMemoryResource final : public std::pmr::memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        auto& stats = GetSessionStats();
+        stats.upstream_allocations.fetch_add(1, std::memory_order_relaxed);
+        stats.upstream_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Закрепляет текущий поток за ядром процессора с номером cpu.
+// На платформах, где это не поддерживается, ничего не делает
+void PinCurrentThread(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        std::cerr << "Failed to pin thread to CPU "sv << cpu << std::endl;
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+}  // namespace
+
+void ReportError(beast::error_code ec, std::string_view what) {
+    std::cerr << what << ": "sv << ec.message() << std::endl;
+}
+
+SessionStats& GetSessionStats() noexcept {
+    static SessionStats stats;
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream& out, const SessionStats& stats) {
+    const auto load = [](const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    return out << "sessions: "sv << load(stats.sessions_created)
+               << ", requests: "sv << load(stats.requests_read)
+               << ", responses: "sv << load(stats.responses_written)
+               << ", pipelined: "sv << load(stats.pipelined_requests)
+               << ", upstream allocations: "sv << load(stats.upstream_allocations)
+               << " ("sv << load(stats.upstream_allocated_bytes) << " bytes)"sv
+               << ", heap allocations: "sv << load(stats.heap_allocations);
+}
+
+std::pmr::memory_resource* GetCountingMemoryResource() noexcept {
+    static CountingMemoryResource resource;
+    return &resource;
+}
+
+void EnableReusePort(tcp::acceptor& acceptor) {
+#ifdef SO_REUSEPORT
+    using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor.set_option(reuse_port(true));
+#else
+    (void)acceptor;
+    throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+}
+
+IoContextShards::IoContextShards(unsigned num_shards) {
+    num_shards = std::max(1u, num_shards);
+    shards_.reserve(num_shards);
+    for (unsigned i = 0; i < num_shards; ++i) {
+        // Подсказка 1 сообщает io_context, что его будет обслуживать единственный поток
+        shards_.emplace_back(std::make_unique<net::io_context>(1));
+    }
+}
+
+void IoContextShards::Run() {
+    const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::jthread> workers;
+    workers.reserve(shards_.size() - 1);
+    for (std::size_t i = 1; i < shards_.size(); ++i) {
+        workers.emplace_back([this, i, num_cpus] {
+            PinCurrentThread(static_cast<unsigned>(i % num_cpus));
+            shards_[i]->run();
+        });
+    }
+    PinCurrentThread(0);
+    shards_.front()->run();
+}
+
+void IoContextShards::Stop() {
+    for (auto& shard : shards_) {
+        shard->stop();
+    }
+}
+
+HandlerMemory::~HandlerMemory() {
+    for (std::size_t i = 0; i < num_blocks_; ++i) {
+        ::operator delete(blocks_[i].data.load(std::memory_order_relaxed));
+    }
+}
+
+void* HandlerMemory::Allocate(std::size_t size) {
+    // Выбирается наименьший свободный блок подходящего размера
+    Block* best = nullptr;
+    Block* free_block = nullptr;
+    for (std::size_t i = 0; i < num_blocks_; ++i) {
+        Block& block = blocks_[i];
+        if (block.in_use.load(std::memory_order_acquire)) {
+            continue;
+        }
+        free_block = &block;
+        if (block.size >= size && (!best || block.size < best->size)) {
+            best = &block;
+        }
+    }
+    if (!best) {
+        if (num_blocks_ < MAX_BLOCKS) {
+            best = &blocks_[num_blocks_++];
+        } else if (free_block) {
+            // Все блоки созданы, но ни один не подходит: свободный блок увеличивается
+            best = free_block;
+            ::operator delete(best->data.load(std::memory_order_relaxed));
+            best->data.store(nullptr, std::memory_order_relaxed);
+        } else {
+            return ::operator new(size);
+        }
+        best->size = size;
+        best->data.store(::operator new(size), std::memory_order_release);
+    }
+    best->in_use.store(true, std::memory_order_relaxed);
+    return best->data.load(std::memory_order_relaxed);
+}
+
+void HandlerMemory::Deallocate(void* p) noexcept {
+    for (Block& block : blocks_) {
+        if (block.data.load(std::memory_order_acquire) == p) {
+            block.in_use.store(false, std::memory_order_release);
+            return;
+        }
+    }
+    // Память выделена в куче, когда все блоки были заняты
+    ::operator delete(p);
+}
+
+template <typename Executor>
+SessionBase<Executor>::PipelineSlot::PipelineSlot(std::size_t arena_size)
+    : initial_block{std::make_unique<std::byte[]>(arena_size)}
+    , arena{initial_block.get(), arena_size, GetCountingMemoryResource()} {
+}
+
+template <typename Executor>
+SessionBase<Executor>::SessionBase(Socket&& socket, const SessionOptions& options)
+    : socket_(std::move(socket))
+    , buffer_(ArenaAllocator<char>{GetCountingMemoryResource()})
+    , timeout_(options.timeout)
+    , timer_(socket_.get_executor())
+    , drain_(options.drain) {
+    buffer_.reserve(options.read_buffer_size);
+    const std::size_t num_slots = std::max<std::size_t>(1, options.max_pipelined_requests);
+    slots_.reserve(num_slots);
+    for (std::size_t i = 0; i < num_slots; ++i) {
+        slots_.emplace_back(std::make_unique<PipelineSlot>(options.arena_size));
+    }
+    GetSessionStats().sessions_created.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename Executor>
+SessionBase<Executor>::~SessionBase() {
+    if (drain_) {
+        drain_->RemoveSession(this);
+    }
+}
+
+template <typename Executor>
+void SessionBase<Executor>::Run() {
+    if (drain_) {
+        drain_->AddSession(GetSharedThis());
+    }
+    // Вызываем метод Start, используя executor объекта socket_.
+    // Таким образом вся работа с socket_ будет выполняться, используя его executor
+    net::dispatch(socket_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::Start, GetSharedThis()));
+}
+
+template <typename Executor>
+void SessionBase<Executor>::Start() {
+    deadline_ = std::chrono::steady_clock::now() + timeout_;
+    timer_.expires_at(deadline_);
+    timer_.async_wait(Bind(&SessionBase::OnTimer));
+    Read();
+}
+
+template <typename Executor>
+void SessionBase<Executor>::Read() {
+    HeapAllocationScope heap_scope;
+    // Следующий запрос читается, только пока есть свободный слот конвейера.
+    // Иначе чтение возобновится после отправки самого старого ответа
+    if (reading_ || read_closed_ || closed_ || in_flight_ == slots_.size()) {
+        return;
+    }
+
+    PipelineSlot& slot = *slots_[(head_ + in_flight_) % slots_.size()];
+    const ArenaAllocator<char> alloc{&slot.arena};
+    slot.parser.emplace(std::piecewise_construct, std::make_tuple(alloc), std::make_tuple(alloc));
+
+    reading_ = true;
+    deadline_ = std::chrono::steady_clock::now() + timeout_;
+    // Считываем запрос из socket_, используя buffer_ для хранения считанных данных
+    http::async_read(socket_, buffer_, *slot.parser,
+                     // По окончании операции будет вызван метод OnRead
+                     Bind(&SessionBase::OnRead));
+}
+
+template <typename Executor>
+void SessionBase<Executor>::OnRead(beast::error_code ec,
+                                   [[maybe_unused]] std::size_t bytes_read) {
+    HeapAllocationScope heap_scope;
+    reading_ = false;
+    const std::size_t slot_index = (head_ + in_flight_) % slots_.size();
+
+    if (ec) {
+        // После любой ошибки чтения соединение больше не читается, иначе OnWrite
+        // возобновил бы чтение из неисправного сокета.
+        // end_of_stream - нормальная ситуация: клиент закрыл соединение.
+        // Ответы на уже прочитанные запросы всё равно отправляются
+        read_closed_ = true;
+        slots_[slot_index]->parser.reset();
+        if (ec != http::error::end_of_stream) {
+            ReportError(ec, "read"sv);
+        }
+        if (in_flight_ == 0) {
+            Close();
+        }
+        return;
+    }
+
+    auto& stats = GetSessionStats();
+    stats.requests_read.fetch_add(1, std::memory_order_relaxed);
+    if (in_flight_ > 0) {
+        stats.pipelined_requests.fetch_add(1, std::memory_order_relaxed);
+    }
+    ++in_flight_;
+
+    PipelineSlot& slot = *slots_[slot_index];
+    if (!slot.parser->keep_alive()) {
+        read_closed_ = true;
+    }
+    HandleRequest(slot.parser->release(), slot_index);
+
+    // Читаем следующий запрос, не дожидаясь отправки ответа на текущий
+    Read();
+}
+
+template <typename Executor>
+void SessionBase<Executor>::OnResponseReady(std::size_t slot_index) {
+    HeapAllocationScope heap_scope;
+    if (closed_) {
+        return;
+    }
+    slots_[slot_index]->response_ready = true;
+    WriteNextResponse();
+}
+
+template <typename Executor>
+void SessionBase<Executor>::WriteNextResponse() {
+    if (writing_ || in_flight_ == 0) {
+        return;
+    }
+    PipelineSlot& slot = *slots_[head_];
+    if (!slot.response_ready) {
+        // Ответ на самый старый запрос ещё не готов. Более новые ответы ждут своей очереди
+        return;
+    }
+    writing_ = true;
+    slot.write(*this, slot);
+}
+
+template <typename Executor>
+void SessionBase<Executor>::OnWrite(beast::error_code ec,
+                                    [[maybe_unused]] std::size_t bytes_written) {
+    HeapAllocationScope heap_scope;
+    writing_ = false;
+
+    PipelineSlot& slot = *slots_[head_];
+    const bool close = slot.close_after_write;
+    // Освобождаем ответ и парсер до сброса арены, в которой они размещены
+    slot.response.reset();
+    slot.parser.reset();
+    slot.write = nullptr;
+    slot.response_ready = false;
+    slot.close_after_write = false;
+    slot.arena.release();
+    head_ = (head_ + 1) % slots_.size();
+    --in_flight_;
+
+    if (ec) {
+        closed_ = true;
+        ReportError(ec, "write"sv);
+        // Ожидающее чтение завершится, а таймер больше не нужен
+        socket_.shutdown(tcp::socket::shutdown_both, ec);
+        timer_.cancel();
+        return;
+    }
+    GetSessionStats().responses_written.fetch_add(1, std::memory_order_relaxed);
+
+    if (close) {
+        // Семантика ответа требует закрыть соединение
+        return Close();
+    }
+
+    WriteNextResponse();
+    if (read_closed_ && in_flight_ == 0) {
+        return Close();
+    }
+    Read();
+}
+
+template <typename Executor>
+void SessionBase<Executor>::Drain() {
+    net::dispatch(socket_.get_executor(), [self = GetSharedThis()] {
+        HeapAllocationScope heap_scope;
+        self->read_closed_ = true;
+        if (self->closed_) {
+            return;
+        }
+        if (self->reading_) {
+            // Ожидающее чтение завершится с end_of_stream, и сессия закроется так же,
+            // как при закрытии соединения клиентом
+            beast::error_code ec;
+            self->socket_.shutdown(tcp::socket::shutdown_receive, ec);
+        } else if (self->in_flight_ == 0) {
+            self->Close();
+        }
+    });
+}
+
+template <typename Executor>
+void SessionBase<Executor>::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    beast::error_code ec;
+    // Ожидающее чтение конвейерного запроса удерживает сессию, а клиент может так и не
+    // закрыть свою сторону соединения. Поэтому закрывается и чтение: оно завершится
+    // с end_of_stream
+    socket_.shutdown(reading_ ? tcp::socket::shutdown_both : tcp::socket::shutdown_send, ec);
+    // Ожидающий таймер удерживает сессию
+    timer_.cancel();
+}
+
+template <typename Executor>
+void SessionBase<Executor>::OnTimer(sys::error_code ec) {
+    HeapAllocationScope heap_scope;
+    if (ec == net::error::operation_aborted || closed_) {
+        return;
+    }
+    if (std::chrono::steady_clock::now() < deadline_) {
+        // С момента запуска таймера началось чтение нового запроса
+        timer_.expires_at(deadline_);
+        timer_.async_wait(Bind(&SessionBase::OnTimer));
+        return;
+    }
+    ReportError(beast::error::timeout, "read"sv);
+    read_closed_ = true;
+    closed_ = true;
+    // Ожидающее чтение завершится с end_of_stream, а запись - с ошибкой
+    socket_.shutdown(tcp::socket::shutdown_both, ec);
+}
+
+void ServerDrain::Start(Callback on_drained) {
+    std::vector<Callback> listeners;
+    std::vector<std::shared_ptr<DrainableSession>> sessions;
+    Callback drained;
+    {
+        std::lock_guard lock{mutex_};
+        if (draining_) {
+            return;
+        }
+        draining_.store(true, std::memory_order_release);
+        listeners.swap(listeners_);
+        sessions.reserve(sessions_.size());
+        for (const auto& [ptr, weak_session] : sessions_) {
+            if (auto session = weak_session.lock()) {
+                sessions.push_back(std::move(session));
+            }
+        }
+        if (sessions_.empty()) {
+            drained = std::move(on_drained);
+        } else {
+            on_drained_ = std::move(on_drained);
+        }
+    }
+
+    // Обработчики вызываются без блокировки: сессия может быть удалена прямо здесь,
+    // когда будет освобождён последний указатель на неё
+    for (const auto& stop_accepting : listeners) {
+        stop_accepting();
+    }
+    for (const auto& session : sessions) {
+        session->Drain();
+    }
+    if (drained) {
+        drained();
+    }
+}
+
+std::size_t ServerDrain::GetSessionCount() const {
+    std::lock_guard lock{mutex_};
+    return sessions_.size();
+}
+
+void ServerDrain::AddListener(Callback stop_accepting) {
+    {
+        std::lock_guard lock{mutex_};
+        if (!draining_) {
+            listeners_.push_back(std::move(stop_accepting));
+            return;
+        }
+    }
+    stop_accepting();
+}
+
+void ServerDrain::AddSession(const std::shared_ptr<DrainableSession>& session) {
+    {
+        std::lock_guard lock{mutex_};
+        sessions_.emplace(session.get(), session);
+        if (!draining_) {
+            return;
+        }
+    }
+    // Соединение принято одновременно с началом завершения
+    session->Drain();
+}
+
+void ServerDrain::RemoveSession(const DrainableSession* session) {
+    Callback drained;
+    {
+        std::lock_guard lock{mutex_};
+        sessions_.erase(session);
+        if (draining_ && sessions_.empty()) {
+            drained = std::move(on_drained_);
+            on_drained_ = nullptr;
+        }
+    }
+    if (drained) {
+        drained();
+    }
+}
+
+template class SessionBase<ShardExecutor>;
+template class SessionBase<StrandExecutor>;
+
+}  // namespace http_server
+
+#ifdef HTTP_SERVER_COUNT_HEAP_ALLOCATIONS
+
+// Глобальные operator new и operator delete заменены, чтобы учитывать обращения сессий к куче.
+// Стандартные operator new[] и варианты с std::nothrow_t вызывают operator new(std::size_t),
+// а варианты с выравниванием не учитываются
+void* operator new(std::size_t size) {
+    ++http_server::thread_heap_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+// Память, выделенная заменённым operator new, получена от std::malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // HTTP_SERVER_COUNT_HEAP_ALLOCATIONS
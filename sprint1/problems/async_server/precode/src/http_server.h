@@ -3,10 +3,27 @@
 // boost.beast будет использовать std::string_view вместо boost::string_view
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace http_server {
 
@@ -14,24 +31,560 @@ namespace net = boost::asio;
 using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace http = beast::http;
+namespace sys = boost::system;
 
-class SessionBase {
-    // Напишите недостающий код, используя информацию из урока
+void ReportError(beast::error_code ec, std::string_view what);
+
+// Счётчики, общие для всех сессий сервера.
+// Парсер, запрос и ответ, созданный функцией MakeResponse, размещаются в арене слота
+// конвейера, поэтому upstream_allocations растёт, только когда арене не хватает начального
+// блока. heap_allocations учитывает все обращения к глобальному operator new из обработчиков
+// сессии, включая обработчик запросов и запуск асинхронных операций Asio и Beast.
+// Этот счётчик ведётся, только если сервер собран с HTTP_SERVER_COUNT_HEAP_ALLOCATIONS:
+// для него заменяется глобальный operator new всей программы
+struct SessionStats {
+    std::atomic<std::uint64_t> sessions_created{0};
+    std::atomic<std::uint64_t> requests_read{0};
+    std::atomic<std::uint64_t> responses_written{0};
+    // Запросы, прочитанные в то время, пока ответ на предыдущий запрос ещё не был отправлен
+    std::atomic<std::uint64_t> pipelined_requests{0};
+    // Обращения арен и буфера чтения к куче (арене не хватило начального блока)
+    std::atomic<std::uint64_t> upstream_allocations{0};
+    std::atomic<std::uint64_t> upstream_allocated_bytes{0};
+    // Вызовы operator new и operator new[] без выравнивания в обработчиках сессий
+    std::atomic<std::uint64_t> heap_allocations{0};
 };
 
-template <typename RequestHandler>
-class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
-	// Напишите недостающий код, используя информацию из урока
+SessionStats& GetSessionStats() noexcept;
+
+// Выводит значения счётчиков в одну строку
+std::ostream& operator<<(std::ostream& out, const SessionStats& stats);
+
+// Источник памяти, который выделяет память в куче и учитывает каждое выделение в SessionStats
+std::pmr::memory_resource* GetCountingMemoryResource() noexcept;
+
+// Сессия, которую ServerDrain может завершить независимо от типа её исполнителя
+class DrainableSession {
+public:
+    // Прекращает чтение новых запросов. Соединение закрывается после отправки ответов
+    // на уже прочитанные запросы. Метод можно вызывать из любого потока
+    virtual void Drain() = 0;
+
+protected:
+    ~DrainableSession() = default;
+};
+
+/*
+ * Плавное завершение работы сервера.
+ * После вызова Start Listener-ы перестают принимать соединения, а сессии дописывают
+ * ответы на уже прочитанные запросы и закрывают соединения, не читая новых запросов.
+ * Один объект разделяется всеми Listener-ами и сессиями сервера.
+ */
+class ServerDrain {
+public:
+    using Callback = std::function<void()>;
+
+    ServerDrain() = default;
+
+    ServerDrain(const ServerDrain&) = delete;
+    ServerDrain& operator=(const ServerDrain&) = delete;
+
+    // Начинает завершение. on_drained будет вызван однократно, в произвольном потоке,
+    // когда закроется последняя сессия
+    void Start(Callback on_drained);
+
+    bool IsDraining() const noexcept {
+        return draining_.load(std::memory_order_acquire);
+    }
+
+    std::size_t GetSessionCount() const;
+
+    // Регистрирует действие, прекращающее приём соединений Listener-ом
+    void AddListener(Callback stop_accepting);
+    void AddSession(const std::shared_ptr<DrainableSession>& session);
+    void RemoveSession(const DrainableSession* session);
+
+private:
+    mutable std::mutex mutex_;
+    std::atomic<bool> draining_{false};
+    std::vector<Callback> listeners_;
+    std::unordered_map<const DrainableSession*, std::weak_ptr<DrainableSession>> sessions_;
+    Callback on_drained_;
+};
+
+struct SessionOptions {
+    // Сколько запросов одного соединения могут одновременно находиться в обработке.
+    // При значении 1 сессия работает как классический keep-alive без конвейеризации
+    std::size_t max_pipelined_requests = 4;
+    // Размер начального блока арены, в которой размещаются запрос и ответ
+    std::size_t arena_size = 8 * 1024;
+    // Начальная ёмкость буфера чтения
+    std::size_t read_buffer_size = 8 * 1024;
+    std::chrono::steady_clock::duration timeout = std::chrono::seconds{30};
+    // Если задан, сессии и Listener-ы завершают работу по команде ServerDrain::Start
+    std::shared_ptr<ServerDrain> drain;
+};
+
+// Аллокатор, выделяющий память из memory_resource.
+// В отличие от std::pmr::polymorphic_allocator допускает присваивание, которого требует
+// http::basic_fields
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(std::pmr::memory_resource* resource) noexcept
+        : resource_{resource} {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : resource_{other.GetResource()} {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    std::pmr::memory_resource* GetResource() const noexcept {
+        return resource_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return resource_ == other.GetResource();
+    }
+
+private:
+    std::pmr::memory_resource* resource_;
+};
+
+/*
+ * Память для состояния асинхронных операций сессии.
+ * Asio и Beast выделяют состояние операции при каждом её запуске. HandlerMemory не возвращает
+ * освобождённые блоки в кучу, а выдаёт их следующим операциям, поэтому после первых запросов
+ * операции сессии перестают обращаться к куче.
+ * Блоки выделяются только в потоке, выполняющем обработчики сессии, а освобождаться могут
+ * в любом потоке io_context: Asio освобождает память операции до того, как передаст
+ * обработчик исполнителю сессии
+ */
+class HandlerMemory {
+public:
+    HandlerMemory() = default;
+
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    ~HandlerMemory();
+
+    void* Allocate(std::size_t size);
+    void Deallocate(void* p) noexcept;
+
+private:
+    struct Block {
+        std::atomic<void*> data{nullptr};
+        std::size_t size = 0;
+        std::atomic<bool> in_use{false};
+    };
+
+    // Одновременно у сессии запущены чтение и запись, каждая из которых состоит
+    // из нескольких вложенных операций
+    constexpr static std::size_t MAX_BLOCKS = 8;
+
+    std::array<Block, MAX_BLOCKS> blocks_;
+    // Изменяется только потоком, выделяющим блоки
+    std::size_t num_blocks_ = 0;
+};
+
+// Аллокатор, через который Asio и Beast размещают состояние операций в HandlerMemory
+template <typename T>
+class HandlerAllocator {
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& memory) noexcept
+        : memory_{&memory} {
+    }
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept
+        : memory_{other.GetMemory()} {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(memory_->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, [[maybe_unused]] std::size_t n) noexcept {
+        memory_->Deallocate(p);
+    }
+
+    HandlerMemory* GetMemory() const noexcept {
+        return memory_;
+    }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U>& other) const noexcept {
+        return memory_ == other.GetMemory();
+    }
+
+private:
+    HandlerMemory* memory_;
+};
+
+// Обработчик, с которым связан HandlerAllocator. Обработчик должен владеть сессией,
+// которой принадлежит memory, чтобы память пережила запущенную операцию
+template <typename Handler>
+class AllocatingHandler {
+public:
+    using allocator_type = HandlerAllocator<void>;
+
+    AllocatingHandler(HandlerMemory& memory, Handler handler)
+        : memory_{&memory}
+        , handler_{std::move(handler)} {
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type{*memory_};
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemory* memory_;
+    Handler handler_;
+};
+
+using RequestBody = http::basic_string_body<char, std::char_traits<char>, ArenaAllocator<char>>;
+using RequestFields = http::basic_fields<ArenaAllocator<char>>;
+// Запрос, заголовки и тело которого размещаются в арене сессии.
+// Память запроса действительна до тех пор, пока на него не будет отправлен ответ
+using Request = http::request<RequestBody, RequestFields>;
+using RequestParser = http::request_parser<RequestBody, ArenaAllocator<char>>;
+// Ответ, заголовки и тело которого размещаются в арене запроса
+using Response = http::response<RequestBody, RequestFields>;
+
+// Создаёт ответ на request в арене этого запроса
+inline Response MakeResponse(const Request& request, http::status status) {
+    Response response{std::piecewise_construct, std::make_tuple(request.body().get_allocator()),
+                      std::make_tuple(request.get_allocator())};
+    response.result(status);
+    response.version(request.version());
+    return response;
+}
+
+// Исполнитель соединения шарда: io_context шарда обслуживает единственный поток
+using ShardExecutor = net::io_context::executor_type;
+// Исполнитель соединения общего io_context. Конкретный тип strand, в отличие от
+// net::any_io_executor, копируется без обращения к куче
+using StrandExecutor = net::strand<ShardExecutor>;
+
+// Общая часть сессий. Реализована для исполнителей ShardExecutor и StrandExecutor
+template <typename Executor>
+class SessionBase : public DrainableSession {
+public:
+    using Socket = net::basic_stream_socket<tcp, Executor>;
+
+    SessionBase(const SessionBase&) = delete;
+    SessionBase& operator=(const SessionBase&) = delete;
+
+    void Run();
+
+    void Drain() override;
+
+protected:
+    SessionBase(Socket&& socket, const SessionOptions& options);
+
+    ~SessionBase();
+
+    // Отправляет ответ на запрос, прочитанный в слот slot_index.
+    // Ответы отправляются строго в порядке поступления запросов.
+    // Метод можно вызывать из любого потока
+    template <typename Body, typename Fields>
+    void Write(std::size_t slot_index, http::response<Body, Fields>&& response) {
+        using Message = http::response<Body, Fields>;
+
+        PipelineSlot& slot = *slots_[slot_index];
+        slot.close_after_write = response.need_eof();
+        // Ответ размещается в арене слота, поэтому не требует обращения к куче
+        slot.response = std::allocate_shared<Message>(
+            ArenaAllocator<Message>{&slot.arena}, std::move(response));
+        slot.write = [](SessionBase& session, PipelineSlot& s) {
+            http::async_write(session.socket_, *static_cast<Message*>(s.response.get()),
+                              session.Bind(&SessionBase::OnWrite));
+        };
+
+        net::dispatch(socket_.get_executor(), [self = GetSharedThis(), slot_index] {
+            self->OnResponseReady(slot_index);
+        });
+    }
+
+private:
+    // Слот конвейера. Хранит парсер запроса, ответ на запрос и арену, в которой они размещены.
+    // Слоты создаются один раз при создании сессии и переиспользуются для всех запросов
+    struct PipelineSlot {
+        explicit PipelineSlot(std::size_t arena_size);
+
+        std::unique_ptr<std::byte[]> initial_block;
+        std::pmr::monotonic_buffer_resource arena;
+        // Парсер хранится в слоте, чтобы http::async_read не выделял его в куче
+        std::optional<RequestParser> parser;
+        std::shared_ptr<void> response;
+        void (*write)(SessionBase& session, PipelineSlot& slot) = nullptr;
+        bool response_ready = false;
+        bool close_after_write = false;
+    };
+
+    void Start();
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void OnResponseReady(std::size_t slot_index);
+    void WriteNextResponse();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+    void Close();
+    void OnTimer(sys::error_code ec);
+
+    // Связывает метод сессии с сессией и памятью для состояния запускаемой операции
+    template <typename Method>
+    auto Bind(Method method) {
+        return AllocatingHandler{handler_memory_,
+                                 beast::bind_front_handler(method, GetSharedThis())};
+    }
+
+    virtual void HandleRequest(Request&& request, std::size_t slot_index) = 0;
+    virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
+
+    using Timer = net::basic_waitable_timer<std::chrono::steady_clock,
+                                            net::wait_traits<std::chrono::steady_clock>, Executor>;
+
+    Socket socket_;
+    beast::basic_flat_buffer<ArenaAllocator<char>> buffer_;
+    std::chrono::steady_clock::duration timeout_;
+    // Соединение закрывается, если к моменту deadline_ не начато чтение следующего запроса.
+    // Таймер не перезапускается при каждом чтении: сработав раньше срока, он ждёт до deadline_.
+    // Таймаут beast::tcp_stream запускал бы таймер на каждую операцию, обращаясь к куче
+    Timer timer_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::shared_ptr<ServerDrain> drain_;
+
+    std::vector<std::unique_ptr<PipelineSlot>> slots_;
+    // Слот самого старого запроса, ответ на который ещё не отправлен
+    std::size_t head_ = 0;
+    // Количество запросов, которые прочитаны, но ответ на которые ещё не отправлен
+    std::size_t in_flight_ = 0;
+    bool reading_ = false;
+    bool writing_ = false;
+    // Клиент закрыл соединение или попросил закрыть его после ответа
+    bool read_closed_ = false;
+    bool closed_ = false;
+    HandlerMemory handler_memory_;
+};
+
+template <typename Executor, typename RequestHandler>
+class Session : public SessionBase<Executor>,
+                public std::enable_shared_from_this<Session<Executor, RequestHandler>> {
+public:
+    template <typename Handler>
+    Session(typename SessionBase<Executor>::Socket&& socket, const SessionOptions& options,
+            Handler&& request_handler)
+        : SessionBase<Executor>(std::move(socket), options)
+        , request_handler_(std::forward<Handler>(request_handler)) {
+    }
+
+private:
+    void HandleRequest(Request&& request, std::size_t slot_index) override {
+        // Захват умного указателя на текущий объект Session в лямбде
+        // не даёт сессии исчезнуть до завершения асинхронной операции
+        request_handler_(std::move(request),
+                         [self = this->shared_from_this(), slot_index](auto&& response) {
+                             self->Write(slot_index, std::move(response));
+                         });
+    }
+
+    std::shared_ptr<SessionBase<Executor>> GetSharedThis() override {
+        return this->shared_from_this();
+    }
+
+    RequestHandler request_handler_;
+};
+
+// Способ, которым Listener распределяет принятые соединения между потоками
+enum class ListenerMode {
+    // io_context обслуживают несколько потоков, каждое соединение получает собственный strand
+    SHARED,
+    // io_context обслуживает ровно один поток (шард). Несколько Listener-ов разных шардов
+    // слушают один и тот же порт благодаря SO_REUSEPORT, и ядро само распределяет между ними
+    // соединения. Соединение живёт на своём шарде до закрытия, поэтому strand не нужен
+    SHARD,
+};
+
+// Включает SO_REUSEPORT на сокете acceptor-а.
+// Бросает исключение, если платформа не поддерживает эту опцию
+void EnableReusePort(tcp::acceptor& acceptor);
+
+// Набор io_context, каждый из которых обслуживается единственным потоком,
+// закреплённым за своим ядром процессора
+class IoContextShards {
+public:
+    explicit IoContextShards(unsigned num_shards);
+
+    IoContextShards(const IoContextShards&) = delete;
+    IoContextShards& operator=(const IoContextShards&) = delete;
+
+    std::size_t Size() const noexcept {
+        return shards_.size();
+    }
+
+    net::io_context& GetShard(std::size_t index) noexcept {
+        return *shards_[index];
+    }
+
+    // Запускает обработку всех шардов: шард 0 обслуживается текущим потоком,
+    // остальные - дополнительными. Возвращает управление, когда все шарды остановлены
+    void Run();
+
+    // Останавливает все шарды. Метод можно вызывать из любого потока
+    void Stop();
+
+private:
+    std::vector<std::unique_ptr<net::io_context>> shards_;
 };
 
 template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
-    // Напишите недостающий код, используя информацию из урока
+public:
+    template <typename Handler>
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+             SessionOptions options = {}, ListenerMode mode = ListenerMode::SHARED)
+        : ioc_(ioc)
+        // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
+        , acceptor_(net::make_strand(ioc))
+        , request_handler_(std::forward<Handler>(request_handler))
+        , options_(options)
+        , mode_(mode) {
+        // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
+        acceptor_.open(endpoint.protocol());
+
+        // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
+        // чтобы компьютеры могли обменяться завершающими пакетами данных.
+        // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
+        // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (mode_ == ListenerMode::SHARD) {
+            EnableReusePort(acceptor_);
+        }
+        // Привязываем acceptor к адресу и порту endpoint
+        acceptor_.bind(endpoint);
+        // Переводим acceptor в состояние, в котором он способен принимать новые соединения
+        // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
+        acceptor_.listen(net::socket_base::max_listen_connections);
+    }
+
+    void Run() {
+        if (options_.drain) {
+            options_.drain->AddListener([weak_self = this->weak_from_this()] {
+                if (auto self = weak_self.lock()) {
+                    self->Stop();
+                }
+            });
+        }
+        DoAccept();
+    }
+
+    // Прекращает приём соединений. Метод можно вызывать из любого потока
+    void Stop() {
+        net::dispatch(acceptor_.get_executor(), [self = this->shared_from_this()] {
+            sys::error_code ec;
+            self->acceptor_.close(ec);
+        });
+    }
+
+private:
+    void DoAccept() {
+        // Тип исполнителя принятого сокета совпадает с типом исполнителя, переданного
+        // в async_accept. Поэтому сессия знает конкретный тип своего исполнителя,
+        // и его копирование в обработчиках не требует обращения к куче
+        const auto on_accept = [self = this->shared_from_this()](sys::error_code ec,
+                                                                 auto socket) {
+            self->OnAccept(ec, std::move(socket));
+        };
+        if (mode_ == ListenerMode::SHARD) {
+            // Шард обслуживается одним потоком, поэтому сокет использует executor io_context
+            // напрямую, без накладных расходов на strand
+            acceptor_.async_accept(ioc_.get_executor(), on_accept);
+            return;
+        }
+        acceptor_.async_accept(
+            // Передаём последовательный исполнитель, в котором будут вызываться обработчики
+            // асинхронных операций сокета
+            net::make_strand(ioc_), on_accept);
+    }
+
+    // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
+    template <typename Socket>
+    void OnAccept(sys::error_code ec, Socket socket) {
+        using namespace std::literals;
+
+        if (ec) {
+            if (!acceptor_.is_open()) {
+                // Listener остановлен
+                return;
+            }
+            return ReportError(ec, "accept"sv);
+        }
+
+        // Асинхронно обрабатываем сессию
+        AsyncRunSession(std::move(socket));
+
+        // Принимаем новое соединение
+        DoAccept();
+    }
+
+    template <typename Socket>
+    void AsyncRunSession(Socket&& socket) {
+        using Executor = typename Socket::executor_type;
+        std::make_shared<Session<Executor, RequestHandler>>(std::move(socket), options_,
+                                                            request_handler_)
+            ->Run();
+    }
+
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    RequestHandler request_handler_;
+    SessionOptions options_;
+    ListenerMode mode_;
 };
 
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
-    // Напишите недостающий код, используя информацию из урока
+void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler,
+               SessionOptions options = {}) {
+    // При помощи decay_t исключим ссылки из типа RequestHandler,
+    // чтобы Listener хранил RequestHandler по значению
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), options)
+        ->Run();
+}
+
+// Запускает на каждом шарде собственный Listener, слушающий endpoint.
+// Каждый шард получает свою копию обработчика запросов
+template <typename RequestHandler>
+void ServeHttpSharded(IoContextShards& shards, const tcp::endpoint& endpoint,
+                      const RequestHandler& handler, SessionOptions options = {}) {
+    using MyListener = Listener<RequestHandler>;
+
+    for (std::size_t i = 0; i < shards.Size(); ++i) {
+        std::make_shared<MyListener>(shards.GetShard(i), endpoint, handler, options,
+                                     ListenerMode::SHARD)
+            ->Run();
+    }
 }
 
 }  // namespace http_server
@@ -1,6 +1,8 @@
 #include "sdk.h"
 //
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <thread>
@@ -14,10 +16,12 @@ using namespace std::literals;
 namespace sys = boost::system;
 namespace http = boost::beast::http;
 
-// Запрос, тело которого представлено в виде строки
-using StringRequest = http::request<http::string_body>;
-// Ответ, тело которого представлено в виде строки
-using StringResponse = http::response<http::string_body>;
+// Запрос, тело которого представлено в виде строки.
+// Заголовки и тело запроса размещаются в арене сессии
+using StringRequest = http_server::Request;
+// Ответ, тело которого представлено в виде строки.
+// Заголовки и тело ответа размещаются в арене запроса
+using StringResponse = http_server::Response;
 
 struct ContentType {
     ContentType() = delete;
@@ -25,11 +29,11 @@ struct ContentType {
     // При необходимости внутрь ContentType можно добавить и другие типы контента
 };
 
-// Создаёт StringResponse с заданными параметрами
-StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
-                                  bool keep_alive,
+// Создаёт StringResponse на запрос req с заданными параметрами
+StringResponse MakeStringResponse(const StringRequest& req, http::status status,
+                                  std::string_view body, bool keep_alive,
                                   std::string_view content_type = ContentType::TEXT_HTML) {
-    StringResponse response(status, http_version);
+    StringResponse response = http_server::MakeResponse(req, status);
     response.set(http::field::content_type, content_type);
     response.body() = body;
     response.content_length(body.size());
@@ -39,7 +43,46 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
 
 StringResponse HandleRequest(StringRequest&& req) {
     // Подставьте сюда код из синхронной версии HTTP-сервера
-    return MakeStringResponse(http::status::ok, "OK"sv, req.version(), req.keep_alive());
+    return MakeStringResponse(req, http::status::ok, "OK"sv, req.keep_alive());
+}
+
+// Сколько после SIGTERM ждать, пока сессии ответят на уже прочитанные запросы
+constexpr auto DRAIN_TIMEOUT = 10s;
+
+// Подписывается на SIGINT и SIGTERM. SIGTERM запускает плавное завершение: сервер
+// перестаёт принимать соединения, и stop вызывается, когда закроются все сессии, но
+// не позже чем через DRAIN_TIMEOUT. SIGINT и повторный сигнал вызывают stop немедленно
+template <typename Stop>
+void HandleSignals(net::signal_set& signals, net::steady_timer& drain_timer,
+                   http_server::ServerDrain& drain, Stop stop) {
+    signals.async_wait([&signals, &drain_timer, &drain, stop](const sys::error_code& ec,
+                                                              int signal_number) {
+        if (ec) {
+            return;
+        }
+        if (signal_number != SIGTERM || drain.IsDraining()) {
+            return stop();
+        }
+        drain.Start(stop);
+        drain_timer.expires_after(DRAIN_TIMEOUT);
+        drain_timer.async_wait([stop](const sys::error_code& ec) {
+            if (!ec) {
+                stop();
+            }
+        });
+        HandleSignals(signals, drain_timer, drain, stop);
+    });
+}
+
+// По SIGUSR1 выводит счётчики сессий, не останавливая сервер
+void DumpStatsOnSignal(net::signal_set& signals) {
+    signals.async_wait([&signals](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        if (ec) {
+            return;
+        }
+        std::cout << http_server::GetSessionStats() << std::endl;
+        DumpStatsOnSignal(signals);
+    });
 }
 
 // Запускает функцию fn на n потоках, включая текущий
@@ -57,24 +100,53 @@ void RunWorkers(unsigned n, const Fn& fn) {
 
 }  // namespace
 
-int main() {
+int main(int argc, const char* argv[]) {
     const unsigned num_threads = std::thread::hardware_concurrency();
 
+    const auto address = net::ip::make_address("0.0.0.0");
+    constexpr net::ip::port_type port = 8080;
+    const auto handler = [](auto&& req, auto&& sender) {
+        sender(HandleRequest(std::forward<decltype(req)>(req)));
+    };
+    http_server::SessionOptions options;
+    options.drain = std::make_shared<http_server::ServerDrain>();
+
+    // С ключом --sharded каждое ядро получает собственный io_context и acceptor,
+    // а соединение обслуживается одним и тем же потоком до своего закрытия
+    if (argc > 1 && argv[1] == "--sharded"sv) {
+        http_server::IoContextShards shards(num_threads);
+
+        net::signal_set signals(shards.GetShard(0), SIGINT, SIGTERM);
+        net::steady_timer drain_timer(shards.GetShard(0));
+        HandleSignals(signals, drain_timer, *options.drain, [&shards] {
+            shards.Stop();
+        });
+
+        net::signal_set stats_signals(shards.GetShard(0), SIGUSR1);
+        DumpStatsOnSignal(stats_signals);
+
+        http_server::ServeHttpSharded(shards, {address, port}, handler, options);
+
+        std::cout << "Server has started..."sv << std::endl;
+
+        shards.Run();
+        std::cout << http_server::GetSessionStats() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
     net::io_context ioc(num_threads);
 
     // Подписываемся на сигналы и при их получении завершаем работу сервера
     net::signal_set signals(ioc, SIGINT, SIGTERM);
-    signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
-        if (!ec) {
-            ioc.stop();
-        }
+    net::steady_timer drain_timer(ioc);
+    HandleSignals(signals, drain_timer, *options.drain, [&ioc] {
+        ioc.stop();
     });
 
-    const auto address = net::ip::make_address("0.0.0.0");
-    constexpr net::ip::port_type port = 8080;
-    http_server::ServeHttp(ioc, {address, port}, [](auto&& req, auto&& sender) {
-        // sender(HandleRequest(std::forward<decltype(req)>(req)));
-    });
+    net::signal_set stats_signals(ioc, SIGUSR1);
+    DumpStatsOnSignal(stats_signals);
+
+    http_server::ServeHttp(ioc, {address, port}, handler, options);
 
     // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
     std::cout << "Server has started..."sv << std::endl;
@@ -82,4 +154,6 @@ int main() {
     RunWorkers(num_threads, [&ioc] {
         ioc.run();
     });
+    // Счётчики сессий выводятся при завершении и по SIGUSR1
+    std::cout << http_server::GetSessionStats() << std::endl;
 }
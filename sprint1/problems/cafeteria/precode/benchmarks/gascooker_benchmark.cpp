@@ -0,0 +1,118 @@
+// Сравнивает GasCooker с прежней реализацией плиты на strand и очереди std::function.
+// Клиенты в цикле занимают горелку и сразу освобождают её, поэтому почти всё время
+// уходит на выдачу горелок. Клиентов больше, чем горелок, и часть запросов ждёт в очереди
+#include <boost/asio/strand.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../src/gascooker.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Прежняя реализация GasCooker: состояние плиты меняется только внутри strand
+class StrandGasCooker : public std::enable_shared_from_this<StrandGasCooker> {
+public:
+    using Handler = std::function<void()>;
+
+    StrandGasCooker(net::io_context& io, int num_burners)
+        : io_{io}
+        , number_of_burners_{num_burners} {
+    }
+
+    void UseBurner(Handler handler) {
+        net::dispatch(strand_, [handler = std::move(handler), self = shared_from_this()]() mutable {
+            if (self->burners_in_use_ < self->number_of_burners_) {
+                ++self->burners_in_use_;
+                net::post(self->io_, std::move(handler));
+            } else {
+                self->pending_handlers_.emplace_back(std::move(handler));
+            }
+        });
+    }
+
+    void ReleaseBurner() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            if (!self->pending_handlers_.empty()) {
+                net::post(self->io_, std::move(self->pending_handlers_.front()));
+                self->pending_handlers_.pop_front();
+            } else {
+                --self->burners_in_use_;
+            }
+        });
+    }
+
+private:
+    net::io_context& io_;
+    net::strand<net::io_context::executor_type> strand_{net::make_strand(io_)};
+    int number_of_burners_;
+    int burners_in_use_ = 0;
+    std::deque<Handler> pending_handlers_;
+};
+
+template <typename Cooker>
+struct Client {
+    std::shared_ptr<Cooker> cooker;
+    std::atomic<long>& grants_left;
+
+    void Use() {
+        cooker->UseBurner([this] {
+            cooker->ReleaseBurner();
+            if (grants_left.fetch_sub(1, std::memory_order_relaxed) > 1) {
+                Use();
+            }
+        });
+    }
+};
+
+// Возвращает среднее время на одну выдачу горелки в наносекундах
+template <typename Cooker>
+double Run(unsigned num_threads, int num_burners, int num_clients, long grants) {
+    net::io_context io{static_cast<int>(num_threads)};
+    auto cooker = std::make_shared<Cooker>(io, num_burners);
+    std::atomic<long> grants_left{grants};
+    std::deque<Client<Cooker>> clients;
+    for (int i = 0; i < num_clients; ++i) {
+        clients.push_back({cooker, grants_left});
+        clients.back().Use();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&io] {
+            io.run();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // Каждый выполненный обработчик уменьшил grants_left на единицу
+    return elapsed.count() / (grants - grants_left.load());
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const unsigned max_threads = argc > 1 ? std::atoi(argv[1]) : 64;
+    const long grants = argc > 2 ? std::atol(argv[2]) : 1'000'000;
+    constexpr int num_burners = 8;
+    constexpr int num_clients = 32;
+
+    std::cout << "burners: "sv << num_burners << ", clients: "sv << num_clients << '\n';
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        const double strand = Run<StrandGasCooker>(threads, num_burners, num_clients, grants);
+        const double atomic = Run<GasCooker>(threads, num_burners, num_clients, grants);
+        std::cout << "threads: "sv << threads << ", strand: "sv << strand
+                  << " ns per grant, atomic: "sv << atomic << " ns per grant"sv << std::endl;
+    }
+}
@@ -0,0 +1,135 @@
+// Сравнивает заказы хот-догов через Cafeteria::OrderHotDog (цепочка шагов на ThenAsync
+// с обработчиком) и Cafeteria::AsyncOrderHotDog (та же цепочка с токеном завершения).
+// Все заказы делаются сразу, а горелок столько, что в каждый момент готовится
+// лишь часть заказов, поэтому повара берут новые ингредиенты по мере освобождения горелок.
+// Помимо заказов в секунду, выводится количество обращений к operator new на заказ
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/cafeteria.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Количество обращений программы к operator new
+std::atomic<size_t> allocations{0};
+
+struct RunResult {
+    double orders_per_second = 0;
+    double allocations_per_order = 0;
+    int rejected = 0;
+};
+
+// make_order(io, cafeteria, on_ready) делает один заказ одним из способов
+template <typename MakeOrder>
+RunResult Run(unsigned num_threads, int num_orders, int num_burners, MakeOrder&& make_order) {
+    net::io_context io{static_cast<int>(num_threads)};
+    Cafeteria cafeteria{io, num_burners};
+    std::atomic<int> cooked{0};
+    std::atomic<int> rejected{0};
+
+    auto on_ready = [&cooked, &rejected](Result<HotDog> hot_dog) {
+        if (!hot_dog.HasValue()) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        cooked.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t allocations_before = allocations.load(std::memory_order_relaxed);
+    net::post(io, [&] {
+        for (int i = 0; i < num_orders; ++i) {
+            make_order(io, cafeteria, on_ready);
+        }
+    });
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&io] {
+            io.run();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const size_t order_allocations =
+        allocations.load(std::memory_order_relaxed) - allocations_before;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return {cooked.load() / elapsed.count(),
+            static_cast<double>(order_allocations) / cooked.load(), rejected.load()};
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+// Память, выделенная заменённым operator new, получена от std::malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main(int argc, const char* argv[]) {
+    const unsigned num_threads =
+        argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const int num_orders = argc > 2 ? std::atoi(argv[2]) : 16'384;
+    const int num_burners = argc > 3 ? std::atoi(argv[3]) : 8'192;
+
+    const RunResult callbacks = Run(num_threads, num_orders, num_burners,
+                                    [](auto& /*io*/, auto& cafeteria, auto& on_ready) {
+                                        cafeteria.OrderHotDog(on_ready);
+                                    });
+    const RunResult coroutines = Run(num_threads, num_orders, num_burners,
+                                     [](auto& /*io*/, auto& cafeteria, auto& on_ready) {
+                                         cafeteria.AsyncOrderHotDog(on_ready);
+                                     });
+    // Клиенты-сопрограммы дожидаются хот-догов через co_await
+    const RunResult awaiting = Run(
+        num_threads, num_orders, num_burners, [](auto& io, auto& cafeteria, auto& on_ready) {
+            net::co_spawn(
+                io,
+                [&cafeteria, &on_ready]() -> net::awaitable<void> {
+                    on_ready(co_await cafeteria.AsyncOrderHotDog(net::use_awaitable));
+                },
+                net::detached);
+        });
+
+    std::cout << "threads: "sv << num_threads << ", orders: "sv << num_orders << ", burners: "sv
+              << num_burners << '\n';
+    for (const auto& [name, result] : {std::pair{"OrderHotDog"sv, callbacks},
+                                       std::pair{"AsyncOrderHotDog"sv, coroutines},
+                                       std::pair{"co_await AsyncOrderHotDog"sv, awaiting}}) {
+        std::cout << name << ": "sv << result.orders_per_second << " orders/s, "sv
+                  << result.allocations_per_order << " allocations per order, "sv
+                  << result.rejected << " rejected"sv << std::endl;
+    }
+}
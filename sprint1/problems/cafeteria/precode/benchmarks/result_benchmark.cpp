@@ -0,0 +1,94 @@
+// Сравнивает создание Result с ошибкой в виде исключения и в виде кода ошибки,
+// а также цепочку шагов на Then/Map с цепочкой продолжений, обёрнутых в std::function
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "../src/result.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Возвращает время на одну итерацию fn в наносекундах
+template <typename Fn>
+double Measure(int iterations, Fn&& fn) {
+    long long checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += fn(i);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // Контрольная сумма не даёт компилятору выбросить вычисления
+    if (checksum == 42) {
+        std::cout << ""sv;
+    }
+    return elapsed.count() / iterations;
+}
+
+Result<int> Validate(int value) {
+    if (value % 16 == 0) {
+        return std::make_error_code(std::errc::invalid_argument);
+    }
+    return value;
+}
+
+// Шаги конвейера, передающие результат следующему шагу через std::function
+using Continuation = std::function<void(Result<int>)>;
+
+void ValidateAsync(int value, Continuation next) {
+    next(Validate(value));
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 1'000'000;
+
+    const double exception_error = Measure(iterations, [](int) {
+        Result<int> result{std::make_exception_ptr(std::invalid_argument{"Invalid value"})};
+        return result.HasValue() ? 1 : 0;
+    });
+    // Код ошибки читается из volatile, чтобы компилятор не вычислил результат заранее
+    volatile int error_value = static_cast<int>(std::errc::invalid_argument);
+    const double code_error = Measure(iterations, [&error_value](int) {
+        Result<int> result{std::make_error_code(static_cast<std::errc>(error_value))};
+        return result.HasValue() ? 1 : 0;
+    });
+
+    const double combinators = Measure(iterations, [](int i) {
+        const auto result = Result<int>{i}
+                                .Map([](int value) {
+                                    return value + 1;
+                                })
+                                .Then(Validate)
+                                .Map([](int value) {
+                                    return value * 2;
+                                });
+        return result.HasValue() ? result.GetValue() : 0;
+    });
+    const double continuations = Measure(iterations, [](int i) {
+        int output = 0;
+        // Каждый шаг получает продолжение, захватывающее следующее продолжение
+        Continuation finish = [&output](Result<int> result) {
+            output = result.HasValue() ? result.GetValue() * 2 : 0;
+        };
+        Continuation validate = [finish = std::move(finish)](Result<int> result) {
+            if (!result.HasValue()) {
+                return finish(std::move(result));
+            }
+            ValidateAsync(result.GetValue(), finish);
+        };
+        validate(Result<int>{i + 1});
+        return output;
+    });
+
+    std::cout << "Error as exception: "sv << exception_error << " ns\n"sv
+              << "Error as code: "sv << code_error << " ns\n"sv
+              << "Map/Then chain: "sv << combinators << " ns\n"sv
+              << "std::function continuations: "sv << continuations << " ns"sv << std::endl;
+}
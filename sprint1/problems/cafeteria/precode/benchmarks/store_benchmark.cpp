@@ -0,0 +1,79 @@
+// Сравнивает выдачу ингредиентов со склада Store, размещающего их в пулах блоков,
+// с созданием ингредиентов через std::make_shared. Каждый поток держит in_flight
+// ингредиентов каждого вида, как кафетерий держит ингредиенты готовящихся заказов
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/ingredients.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Возвращает время на выдачу пары ингредиентов в наносекундах
+template <typename GetSausage, typename GetBread>
+double Run(unsigned num_threads, int pairs, size_t in_flight, GetSausage&& get_sausage,
+           GetBread&& get_bread) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&] {
+            std::vector<std::shared_ptr<Sausage>> sausages(in_flight);
+            std::vector<std::shared_ptr<Bread>> breads(in_flight);
+            for (int i = 0; i < pairs; ++i) {
+                // Ингредиент, выданный in_flight пар назад, освобождается
+                sausages[i % in_flight] = get_sausage();
+                breads[i % in_flight] = get_bread();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / pairs;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const unsigned num_threads =
+        argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const int pairs = argc > 2 ? std::atoi(argv[2]) : 1'000'000;
+    const size_t in_flight = argc > 3 ? std::atoi(argv[3]) : 256;
+
+    std::atomic<int> next_id{0};
+    const double make_shared = Run(
+        num_threads, pairs, in_flight,
+        [&next_id] {
+            return std::make_shared<Sausage>(++next_id);
+        },
+        [&next_id] {
+            return std::make_shared<Bread>(++next_id);
+        });
+
+    Store store;
+    const double pooled = Run(
+        num_threads, pairs, in_flight,
+        [&store] {
+            return store.GetSausage();
+        },
+        [&store] {
+            return store.GetBread();
+        });
+
+    std::cout << "threads: "sv << num_threads << ", in flight: "sv << in_flight << '\n'
+              << "make_shared: "sv << make_shared << " ns per pair\n"sv
+              << "Store: "sv << pooled << " ns per pair"sv << std::endl;
+    for (const auto& [name, stats] : {std::pair{"Sausage"sv, Store::GetSausageStats()},
+                                      std::pair{"Bread"sv, Store::GetBreadStats()}}) {
+        std::cout << name << " pool: "sv << stats.allocations << " allocations, "sv
+                  << stats.system_allocations << " system allocations"sv << std::endl;
+    }
+}
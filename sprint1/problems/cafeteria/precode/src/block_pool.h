@@ -0,0 +1,209 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Счётчики пула блоков. Потоки добавляют свои операции к счётчикам пачками, поэтому
+// операции других работающих потоков могут учитываться с опозданием на несколько десятков
+struct PoolStats {
+    // Сколько раз пул выдавал память и сколько раз её возвращали
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    // Сколько раз пул запрашивал память у operator new, включая запросы,
+    // не поместившиеся в блок
+    size_t system_allocations = 0;
+};
+
+/*
+ * Потокобезопасный пул блоков одинакового размера, свой для каждого типа Tag.
+ * Размер блока задаёт первый запрос к пулу, запросы крупнее блока передаются operator new.
+ *
+ * У каждого потока есть свой кэш свободных блоков, поэтому выделение и освобождение блока
+ * обычно не требует синхронизации. Кэш обменивается блоками с общим списком пачками по
+ * BATCH_SIZE блоков, а общий список пополняется кусками по BATCH_SIZE блоков от operator new.
+ * Пул существует до завершения программы и не возвращает память системе, поэтому блоки
+ * можно освобождать в любой момент.
+ */
+template <typename Tag>
+class BlockPool {
+public:
+    constexpr static size_t BATCH_SIZE = 64;
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    static BlockPool& GetInstance() {
+        // Пул не разрушается, чтобы блоки можно было освобождать при завершении потоков
+        static BlockPool* const pool = new BlockPool;
+        return *pool;
+    }
+
+    void* Allocate(size_t size, size_t alignment) {
+        ThreadCache& cache = GetThreadCache();
+        ++cache.stats.allocations;
+        if (!FitsBlock(size, alignment)) {
+            ++cache.stats.system_allocations;
+            return ::operator new(size, std::align_val_t{alignment});
+        }
+        if (!cache.head) {
+            Refill(cache);
+        }
+        --cache.size;
+        return std::exchange(cache.head, cache.head->next);
+    }
+
+    void Deallocate(void* block, size_t size, size_t alignment) noexcept {
+        ThreadCache& cache = GetThreadCache();
+        ++cache.stats.deallocations;
+        if (!FitsBlock(size, alignment)) {
+            ::operator delete(block, std::align_val_t{alignment});
+            return;
+        }
+        cache.head = new (block) FreeBlock{cache.head};
+        if (++cache.size >= BATCH_SIZE * 2) {
+            // Блоки, освобождённые не тем потоком, который их выделил, возвращаются в общий список
+            ReturnBatch(cache, BATCH_SIZE);
+        }
+    }
+
+    PoolStats GetStats() noexcept {
+        FlushStats(GetThreadCache());
+        return {allocations_.load(std::memory_order_relaxed),
+                deallocations_.load(std::memory_order_relaxed),
+                system_allocations_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct ThreadCache {
+        FreeBlock* head = nullptr;
+        size_t size = 0;
+        PoolStats stats;
+
+        ThreadCache() = default;
+        ThreadCache(const ThreadCache&) = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+
+        ~ThreadCache() {
+            BlockPool& pool = GetInstance();
+            pool.ReturnBatch(*this, size);
+            pool.FlushStats(*this);
+        }
+    };
+
+    BlockPool() = default;
+
+    static ThreadCache& GetThreadCache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    bool FitsBlock(size_t size, size_t alignment) {
+        size_t block_size = block_size_.load(std::memory_order_acquire);
+        if (block_size == 0) {
+            constexpr size_t max_alignment = alignof(std::max_align_t);
+            const size_t rounded = (size + max_alignment - 1) / max_alignment * max_alignment;
+            // Размер блока задаёт первый запрос, даже если запросы пришли одновременно
+            block_size_.compare_exchange_strong(block_size, std::max(rounded, sizeof(FreeBlock)),
+                                                std::memory_order_acq_rel);
+            block_size = block_size_.load(std::memory_order_acquire);
+        }
+        return size <= block_size && alignment <= alignof(std::max_align_t);
+    }
+
+    // Переносит в кэш потока пачку блоков из общего списка или нового куска памяти
+    void Refill(ThreadCache& cache) {
+        FlushStats(cache);
+        {
+            std::lock_guard lock{mutex_};
+            while (free_blocks_ && cache.size < BATCH_SIZE) {
+                cache.head = new (std::exchange(free_blocks_, free_blocks_->next))
+                    FreeBlock{cache.head};
+                ++cache.size;
+            }
+        }
+        if (cache.head) {
+            return;
+        }
+        const size_t block_size = block_size_.load(std::memory_order_acquire);
+        std::byte* chunk = new std::byte[block_size * BATCH_SIZE];
+        ++cache.stats.system_allocations;
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            cache.head = new (chunk + i * block_size) FreeBlock{cache.head};
+        }
+        cache.size = BATCH_SIZE;
+    }
+
+    // Возвращает count блоков из кэша потока в общий список
+    void ReturnBatch(ThreadCache& cache, size_t count) noexcept {
+        FlushStats(cache);
+        if (count == 0) {
+            return;
+        }
+        FreeBlock* first = cache.head;
+        FreeBlock* last = first;
+        for (size_t i = 1; i < count; ++i) {
+            last = last->next;
+        }
+        cache.head = last->next;
+        cache.size -= count;
+
+        std::lock_guard lock{mutex_};
+        last->next = free_blocks_;
+        free_blocks_ = first;
+    }
+
+    void FlushStats(ThreadCache& cache) noexcept {
+        allocations_.fetch_add(std::exchange(cache.stats.allocations, 0),
+                               std::memory_order_relaxed);
+        deallocations_.fetch_add(std::exchange(cache.stats.deallocations, 0),
+                                 std::memory_order_relaxed);
+        system_allocations_.fetch_add(std::exchange(cache.stats.system_allocations, 0),
+                                      std::memory_order_relaxed);
+    }
+
+    std::atomic<size_t> block_size_{0};
+    std::mutex mutex_;
+    FreeBlock* free_blocks_ = nullptr;
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> deallocations_{0};
+    std::atomic<size_t> system_allocations_{0};
+};
+
+/*
+ * Аллокатор, выделяющий память из BlockPool<Tag>. Подходит для std::allocate_shared:
+ * объект и его блок управления занимают один блок пула и возвращаются в пул,
+ * когда удаляется последний shared_ptr. Аллокатор не хранит состояния, поэтому
+ * не увеличивает размер блока управления.
+ */
+template <typename T, typename Tag = T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, Tag>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(BlockPool<Tag>::GetInstance().Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        BlockPool<Tag>::GetInstance().Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, Tag>&) const noexcept {
+        return true;
+    }
+};
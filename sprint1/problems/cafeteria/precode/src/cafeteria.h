@@ -3,12 +3,20 @@
 #include <sdkddkver.h>
 #endif
 
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
+#include <atomic>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include "hotdog.h"
+#include "hotdog_batch.h"
+#include "hotdog_kitchen.h"
 #include "result.h"
 
 namespace net = boost::asio;
@@ -19,24 +27,108 @@ using HotDogHandler = std::function<void(Result<HotDog> hot_dog)>;
 // Класс "Кафетерий". Готовит хот-доги
 class Cafeteria {
 public:
-    explicit Cafeteria(net::io_context& io)
-        : io_{io} {
+    // Плита с большим количеством горелок позволяет готовить больше хот-догов в секунду
+    explicit Cafeteria(net::io_context& io, int num_burners = 8)
+        : io_{io}
+        , gas_cooker_{std::make_shared<GasCooker>(io_, num_burners)}
+        , kitchen_{io_, gas_cooker_} {
     }
 
     // Асинхронно готовит хот-дог и вызывает handler, как только хот-дог будет готов.
     // Этот метод может быть вызван из произвольного потока
     void OrderHotDog(HotDogHandler handler) {
-        // TODO: Реализуйте метод самостоятельно
-        // При необходимости реализуйте дополнительные классы
+        ExecuteOrder(std::move(handler));
+    }
+
+    /*
+     * Асинхронно готовит хот-дог на кухне с сопрограммами-поварами. Обработчик завершения
+     * вызывается с сигнатурой void(Result<HotDog> hot_dog). Хот-дог можно получить
+     * в обработчике или дождаться в сопрограмме:
+     *
+     * Result<HotDog> hot_dog = co_await cafeteria.AsyncOrderHotDog(net::use_awaitable);
+     *
+     * Этот метод может быть вызван из произвольного потока
+     */
+    template <typename CompletionToken>
+    auto AsyncOrderHotDog(CompletionToken&& token) {
+        return net::async_initiate<CompletionToken, void(Result<HotDog>)>(
+            [this](auto handler) {
+                ExecuteOrder([this, handler = std::move(handler)](Result<HotDog> hot_dog) mutable {
+                    // Обработчик вызывается через связанный с ним исполнитель, например,
+                    // исполнитель ожидающей сопрограммы
+                    const auto executor = net::get_associated_executor(handler, io_.get_executor());
+                    net::dispatch(executor, [handler = std::move(handler),
+                                             hot_dog = std::move(hot_dog)]() mutable {
+                        handler(std::move(hot_dog));
+                    });
+                });
+            },
+            token);
+    }
+
+    // Асинхронно готовит num_orders хот-догов по общему плану и вызывает
+    // handler(std::vector<Result<HotDog>> hot_dogs, BatchReport report), когда будут готовы
+    // все хот-доги партии.
+    // Этот метод может быть вызван из произвольного потока
+    template <typename Handler>
+    void OrderHotDogs(int num_orders, Handler&& handler) {
+        std::vector<HotDogOrder> orders;
+        orders.reserve(std::max(0, num_orders));
+        for (int i = 0; i < num_orders; ++i) {
+            orders.push_back(MakeOrder());
+        }
+        using Batch = HotDogBatch<std::decay_t<Handler>>;
+        std::make_shared<Batch>(io_, gas_cooker_, std::move(orders), std::forward<Handler>(handler))
+            ->Start();
     }
 
 private:
+    // Выдаёт со склада ингредиенты для нового хот-дога
+    HotDogOrder MakeOrder() {
+        const int id = last_hot_dog_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+        return {id, store_.GetSausage(), store_.GetBread()};
+    }
+
+    // То же, что MakeOrder, но ошибка склада возвращается в Result
+    Result<HotDogOrder> TakeIngredients() {
+        try {
+            return MakeOrder();
+        } catch (...) {
+            return Result<HotDogOrder>::FromCurrentException();
+        }
+    }
+
+    // Собирает хот-дог. Забракованный хот-дог возвращается как код ошибки
+    static Result<HotDog> Assemble(HotDogOrder&& order) {
+        return HotDog::Make(order.id, std::move(order.sausage), std::move(order.bread));
+    }
+
+    /*
+     * Выполняет заказ цепочкой шагов: ингредиенты выдаются со склада, готовятся сопрограммами-
+     * поварами кухни и собираются в хот-дог. Ошибка шага минует следующие шаги и передаётся
+     * в handler(Result<HotDog> hot_dog), который вызывается в потоке повара.
+     * Шаги связываются через ThenAsync и Then, поэтому обработчик не оборачивается
+     * в std::function на каждом шаге
+     */
+    template <typename Handler>
+    void ExecuteOrder(Handler&& handler) {
+        TakeIngredients().ThenAsync<HotDogOrder>(
+            [this](HotDogOrder&& order, auto on_cooked) {
+                kitchen_.CookIngredients(std::move(order), std::move(on_cooked));
+            },
+            [handler = std::forward<Handler>(handler)](Result<HotDogOrder> cooked) mutable {
+                handler(std::move(cooked).Then(&Cafeteria::Assemble));
+            });
+    }
+
     net::io_context& io_;
     // Используется для создания ингредиентов хот-дога
     Store store_;
+    std::atomic<int> last_hot_dog_id_{0};
     // Газовая плита. По условию задачи в кафетерии есть только одна газовая плита на 8 горелок
     // Используйте её для приготовления ингредиентов хот-дога.
     // Плита создаётся с помощью make_shared, так как GasCooker унаследован от
     // enable_shared_from_this.
-    std::shared_ptr<GasCooker> gas_cooker_ = std::make_shared<GasCooker>(io_);
+    std::shared_ptr<GasCooker> gas_cooker_;
+    HotDogKitchen kitchen_;
 };
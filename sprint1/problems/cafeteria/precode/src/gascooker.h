@@ -4,94 +4,294 @@
 #endif
 
 #include <boost/asio/io_context.hpp>
-#include <boost/asio/strand.hpp>
+#include <boost/asio/defer.hpp>
+#include <boost/asio/post.hpp>
+#include <atomic>
 #include <cassert>
-#include <deque>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace net = boost::asio;
 namespace sys = boost::system;
 
+namespace gas_cooker_detail {
+
+// Узел интрузивной очереди
+struct QueueNode {
+    std::atomic<QueueNode*> next{nullptr};
+};
+
+/*
+ * Интрузивная очередь Д. Вьюкова для многих производителей и одного потребителя.
+ * Push не блокируется и выполняется одной атомарной операцией exchange.
+ * TryPop может вернуть nullptr, пока производитель, начавший Push, не завершил его.
+ */
+class WaiterQueue {
+public:
+    WaiterQueue() = default;
+    WaiterQueue(const WaiterQueue&) = delete;
+    WaiterQueue& operator=(const WaiterQueue&) = delete;
+
+    // Можно вызывать из любого потока
+    void Push(QueueNode* node) noexcept {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        QueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Вызывается только одним потоком-потребителем в каждый момент времени
+    QueueNode* TryPop() noexcept {
+        QueueNode* tail = tail_;
+        QueueNode* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            // Производитель уже занял место в очереди, но ещё не связал с ним предыдущий узел
+            return nullptr;
+        }
+        // В очереди остался один узел. Чтобы его извлечь, за ним ставится заглушка
+        Push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    bool IsEmpty() const noexcept {
+        return tail_ == &stub_ && !stub_.next.load(std::memory_order_acquire);
+    }
+
+private:
+    QueueNode stub_;
+    std::atomic<QueueNode*> head_{&stub_};
+    QueueNode* tail_ = &stub_;
+};
+
+/*
+ * Обработчик, ожидающий горелку. Обработчики до INLINE_SIZE байт хранятся внутри узла очереди,
+ * более крупные - в динамической памяти.
+ * Освобождённые узлы не удаляются, а кэшируются в потоке, освободившем их, поэтому в
+ * установившемся режиме ожидание горелки не выделяет память.
+ */
+class Waiter : public QueueNode {
+public:
+    constexpr static size_t INLINE_SIZE = 64;
+
+    Waiter(const Waiter&) = delete;
+    Waiter& operator=(const Waiter&) = delete;
+
+    template <typename Handler>
+    static Waiter* Create(Handler&& handler) {
+        using H = std::decay_t<Handler>;
+        Waiter* waiter = GetCache().Take();
+        try {
+            if constexpr (IsInlined<H>()) {
+                new (waiter->storage_) H(std::forward<Handler>(handler));
+                waiter->post_ = [](Waiter& self, net::io_context& io) {
+                    H* stored = std::launder(reinterpret_cast<H*>(self.storage_));
+                    H moved = std::move(*stored);
+                    stored->~H();
+                    net::defer(io, std::move(moved));
+                };
+            } else {
+                new (waiter->storage_) H*(new H(std::forward<Handler>(handler)));
+                waiter->post_ = [](Waiter& self, net::io_context& io) {
+                    std::unique_ptr<H> stored{*std::launder(reinterpret_cast<H**>(self.storage_))};
+                    net::defer(io, std::move(*stored));
+                };
+            }
+        } catch (...) {
+            GetCache().Put(waiter);
+            throw;
+        }
+        return waiter;
+    }
+
+    // Отправляет обработчик на выполнение в io и возвращает узел в кэш.
+    // Обработчик продолжает работу, освободившую горелку, поэтому отправляется через defer:
+    // если она выполняется в потоке io, обработчик попадёт в очередь этого потока и
+    // не будет будить другой поток
+    void Post(net::io_context& io) {
+        struct Recycle {
+            Waiter* waiter;
+            ~Recycle() {
+                GetCache().Put(waiter);
+            }
+        } recycle{this};
+        post_(*this, io);
+    }
+
+private:
+    Waiter() = default;
+
+    template <typename H>
+    constexpr static bool IsInlined() noexcept {
+        return sizeof(H) <= INLINE_SIZE && alignof(H) <= alignof(std::max_align_t)
+               && std::is_nothrow_move_constructible_v<H>;
+    }
+
+    // Кэш свободных узлов потока
+    class Cache {
+    public:
+        Cache() = default;
+        Cache(const Cache&) = delete;
+        Cache& operator=(const Cache&) = delete;
+
+        ~Cache() {
+            while (head_) {
+                delete std::exchange(head_, Next(head_));
+            }
+        }
+
+        Waiter* Take() {
+            if (!head_) {
+                return new Waiter;
+            }
+            --size_;
+            return std::exchange(head_, Next(head_));
+        }
+
+        void Put(Waiter* waiter) noexcept {
+            if (size_ == MAX_SIZE) {
+                delete waiter;
+                return;
+            }
+            waiter->next.store(head_, std::memory_order_relaxed);
+            head_ = waiter;
+            ++size_;
+        }
+
+    private:
+        constexpr static size_t MAX_SIZE = 256;
+
+        static Waiter* Next(Waiter* waiter) noexcept {
+            return static_cast<Waiter*>(waiter->next.load(std::memory_order_relaxed));
+        }
+
+        Waiter* head_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    static Cache& GetCache() {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    alignas(std::max_align_t) std::byte storage_[INLINE_SIZE];
+    void (*post_)(Waiter& self, net::io_context& io) = nullptr;
+};
+
+}  // namespace gas_cooker_detail
+
 /*
 Газовая плита - совместно используемый ресурс кафетерия
 Содержит несколько горелок (burner), которые можно асинхронно занимать (метод UseBurner) и
 освобождать (метод ReleaseBurner).
 Если свободных горелок нет, то запрос на занимание горелки ставится в очередь.
 Методы класса можно вызывать из разных потоков.
+
+Плита работает как асинхронный семафор без блокировок. Счётчик available_ равен количеству
+свободных горелок минус количество ожидающих обработчиков. Пока горелки есть, UseBurner
+занимает горелку одной атомарной операцией. Горелка, освобождённая при непустой очереди,
+передаётся первому ожидающему обработчику, поэтому новые запросы не обгоняют очередь.
 */
 class GasCooker : public std::enable_shared_from_this<GasCooker> {
 public:
-    using Handler = std::function<void()>;
-
     GasCooker(net::io_context& io, int num_burners = 8)
         : io_{io}
-        , number_of_burners_{num_burners} {
+        , number_of_burners_{num_burners}
+        , available_{num_burners} {
     }
 
     GasCooker(const GasCooker&) = delete;
     GasCooker& operator=(const GasCooker&) = delete;
 
     ~GasCooker() {
-        assert(burners_in_use_ == 0);
+        assert(available_.load() == number_of_burners_);
+        assert(waiters_.IsEmpty());
+    }
+
+    int GetNumberOfBurners() const noexcept {
+        return number_of_burners_;
     }
 
     // Используется для того, чтобы занять горелку. handler будет вызван в момент, когда горелка
     // занята
     // Этот метод можно вызывать параллельно с вызовом других методов
-    void UseBurner(Handler handler) {
-        // Выполняем работу внутри strand, чтобы изменение состояния горелки выполнялось
-        // последовательно
-        net::dispatch(strand_,
-                      // За счёт захвата self в лямбда-функции, время жизни GasCooker будет продлено
-                      // до её вызова
-                      [handler = std::move(handler), self = shared_from_this(), this]() mutable {
-                          assert(strand_.running_in_this_thread());
-                          assert(burners_in_use_ >= 0 && burners_in_use_ <= number_of_burners_);
-
-                          // Есть свободные горелки?
-                          if (burners_in_use_ < number_of_burners_) {
-                              // Занимаем горелку
-                              ++burners_in_use_;
-                              // Асинхронно уведомляем обработчик о том, что горелка занята.
-                              // Используется асинхронный вызов, так как handler может
-                              // выполняться долго, а strand лучше освободить
-                              net::post(io_, std::move(handler));
-                          } else {  // Все горелки заняты
-                              // Ставим обработчик в хвост очереди
-                              pending_handlers_.emplace_back(std::move(handler));
-                          }
-
-                          // Проверка инвариантов класса
-                          assert(burners_in_use_ > 0 && burners_in_use_ <= number_of_burners_);
-                      });
+    template <typename Handler>
+    void UseBurner(Handler&& handler) {
+        // Есть свободные горелки?
+        if (available_.fetch_sub(1, std::memory_order_acq_rel) > 0) {
+            // Асинхронно уведомляем обработчик о том, что горелка занята, так как
+            // handler может выполняться долго
+            net::post(io_, std::forward<Handler>(handler));
+            return;
+        }
+        // Все горелки заняты
+        waiters_.Push(gas_cooker_detail::Waiter::Create(std::forward<Handler>(handler)));
+        // Горелка могла освободиться, пока обработчик ставился в очередь
+        Dispatch();
     }
 
     void ReleaseBurner() {
-        // Освобождение выполняем также последовательно
-        net::dispatch(strand_, [this, self = shared_from_this()] {
-            assert(strand_.running_in_this_thread());
-            assert(burners_in_use_ > 0 && burners_in_use_ <= number_of_burners_);
-
-            // Есть ли ожидающие обработчики?
-            if (!pending_handlers_.empty()) {
-                // Выполняем асинхронно обработчик первый обработчик
-                net::post(io_, std::move(pending_handlers_.front()));
-                // И удаляем его из очереди ожидания
-                pending_handlers_.pop_front();
-            } else {
-                // Освобождаем горелку
-                --burners_in_use_;
-            }
-        });
+        // Есть ли ожидающие обработчики?
+        if (available_.fetch_add(1, std::memory_order_acq_rel) >= 0) {
+            return;
+        }
+        // Горелка достанется первому обработчику в очереди, даже если он ещё не успел
+        // в неё встать
+        grants_.fetch_add(1, std::memory_order_acq_rel);
+        Dispatch();
     }
 
 private:
-    using Strand = net::strand<net::io_context::executor_type>;
+    /*
+     * Раздаёт ожидающим обработчикам освободившиеся горелки.
+     * Очередь разбирает только один поток. Потоки, вызвавшие Dispatch в это время,
+     * лишь увеличивают dispatch_requests_, и разбирающий поток повторяет проход, поэтому
+     * ни один поток не ждёт другой.
+     */
+    void Dispatch() {
+        if (dispatch_requests_.fetch_add(1, std::memory_order_acq_rel) > 0) {
+            return;
+        }
+        int requests = 1;
+        do {
+            while (grants_.load(std::memory_order_acquire) > 0) {
+                // Очередь может казаться пустой, пока Push не завершился. Тогда поток,
+                // выполняющий Push, сам вызовет Dispatch
+                auto waiter = static_cast<gas_cooker_detail::Waiter*>(waiters_.TryPop());
+                if (!waiter) {
+                    break;
+                }
+                grants_.fetch_sub(1, std::memory_order_acq_rel);
+                waiter->Post(io_);
+            }
+            requests = dispatch_requests_.fetch_sub(requests, std::memory_order_acq_rel) - requests;
+        } while (requests > 0);
+    }
+
     net::io_context& io_;
-    Strand strand_{net::make_strand(io_)};
     int number_of_burners_;
-    int burners_in_use_ = 0;
-    std::deque<Handler> pending_handlers_;
+    std::atomic<int> available_;
+    // Горелки, переданные очереди, но ещё не отданные ожидающим обработчикам
+    std::atomic<int> grants_{0};
+    std::atomic<int> dispatch_requests_{0};
+    gas_cooker_detail::WaiterQueue waiters_;
 };
 
 // RAII-класс для автоматического освобождения газовой плиты
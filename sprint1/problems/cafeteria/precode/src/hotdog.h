@@ -3,9 +3,47 @@
 #include <functional>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
 
 #include "gascooker.h"
 #include "ingredients.h"
+#include "result.h"
+
+// Причины, по которым хот-дог бракуется
+enum class HotDogErrc {
+    INVALID_SAUSAGE_COOK_DURATION = 1,
+    INVALID_BREAD_COOK_DURATION,
+};
+
+template <>
+struct std::is_error_code_enum<HotDogErrc> : std::true_type {};
+
+inline const std::error_category& GetHotDogCategory() noexcept {
+    class HotDogCategory : public std::error_category {
+    public:
+        const char* name() const noexcept override {
+            return "hot dog";
+        }
+
+        std::string message(int code) const override {
+            switch (static_cast<HotDogErrc>(code)) {
+                case HotDogErrc::INVALID_SAUSAGE_COOK_DURATION:
+                    return "Invalid sausage cook duration";
+                case HotDogErrc::INVALID_BREAD_COOK_DURATION:
+                    return "Invalid bread cook duration";
+            }
+            return "Unknown hot dog error";
+        }
+    };
+    static const HotDogCategory category;
+    return category;
+}
+
+inline std::error_code make_error_code(HotDogErrc code) noexcept {
+    return {static_cast<int>(code), GetHotDogCategory()};
+}
 
 /*
 Класс Хот-дог.
@@ -26,15 +64,33 @@ public:
         : id_{id}
         , sausage_{std::move(sausage)}
         , bread_{std::move(bread)} {
-        if (sausage_->GetCookDuration() < MIN_SAUSAGE_COOK_DURATION
-            || sausage_->GetCookDuration() > MAX_SAUSAGE_COOK_DURATION) {
-            throw std::invalid_argument("Invalid sausage cook duration");
+        if (const auto error = Validate(*sausage_, *bread_)) {
+            throw std::invalid_argument(error.message());
+        }
+    }
+
+    // Собирает хот-дог. Если ингредиенты приготовлены с нарушением времени, возвращает
+    // код ошибки, не выбрасывая исключения
+    static Result<HotDog> Make(int id, std::shared_ptr<Sausage> sausage,
+                               std::shared_ptr<Bread> bread) {
+        if (const auto error = Validate(*sausage, *bread)) {
+            return error;
         }
+        return HotDog{id, std::move(sausage), std::move(bread), Validated{}};
+    }
 
-        if (bread_->GetBakingDuration() < MIN_BREAD_COOK_DURATION
-            || bread_->GetBakingDuration() > MAX_BREAD_COOK_DURATION) {
-            throw std::invalid_argument("Invalid sausage cook duration");
+    // Проверяет время приготовления ингредиентов
+    static std::error_code Validate(const Sausage& sausage, const Bread& bread) {
+        if (sausage.GetCookDuration() < MIN_SAUSAGE_COOK_DURATION
+            || sausage.GetCookDuration() > MAX_SAUSAGE_COOK_DURATION) {
+            return HotDogErrc::INVALID_SAUSAGE_COOK_DURATION;
         }
+
+        if (bread.GetBakingDuration() < MIN_BREAD_COOK_DURATION
+            || bread.GetBakingDuration() > MAX_BREAD_COOK_DURATION) {
+            return HotDogErrc::INVALID_BREAD_COOK_DURATION;
+        }
+        return {};
     }
 
     int GetId() const noexcept {
@@ -50,6 +106,14 @@ public:
     }
 
 private:
+    struct Validated {};
+
+    HotDog(int id, std::shared_ptr<Sausage> sausage, std::shared_ptr<Bread> bread, Validated)
+        : id_{id}
+        , sausage_{std::move(sausage)}
+        , bread_{std::move(bread)} {
+    }
+
     int id_;
     std::shared_ptr<Sausage> sausage_;
     std::shared_ptr<Bread> bread_;
@@ -0,0 +1,272 @@
+#pragma once
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <vector>
+
+#include "hotdog.h"
+#include "result.h"
+
+// Статистика приготовления партии хот-догов
+struct BatchReport {
+    // Время от начала приготовления партии до готовности каждого хот-дога, в порядке заказов
+    std::vector<Clock::duration> latencies;
+    // Время приготовления партии по плану и фактическое
+    Clock::duration planned_makespan{};
+    Clock::duration makespan{};
+    // Нижняя оценка времени приготовления партии, см. CookingPlan::lower_bound
+    Clock::duration lower_bound{};
+    // Доля времени горелок плиты, которую заняли ингредиенты партии
+    double burner_utilization = 0;
+};
+
+// Ингредиенты одного заказа
+struct HotDogOrder {
+    int id;
+    std::shared_ptr<Sausage> sausage;
+    std::shared_ptr<Bread> bread;
+};
+
+// Приготовление сосиски или хлеба для заказа с индексом order
+struct CookingStep {
+    enum class Kind { SAUSAGE, BREAD };
+
+    Kind kind;
+    size_t order;
+
+    Clock::duration GetDuration() const noexcept {
+        return kind == Kind::SAUSAGE ? HotDog::MIN_SAUSAGE_COOK_DURATION
+                                     : HotDog::MIN_BREAD_COOK_DURATION;
+    }
+};
+
+struct CookingPlan {
+    // Шаги в том порядке, в котором они должны занимать горелки
+    std::vector<CookingStep> steps;
+    Clock::duration makespan{};
+    // Нижняя оценка времени приготовления партии при любом плане: горелки не могут
+    // работать меньше суммарного времени шагов, делённого на их количество,
+    // и меньше самого длинного шага
+    Clock::duration lower_bound{};
+};
+
+/*
+ * Составляет план приготовления num_orders хот-догов на num_burners горелках, сокращающий
+ * время приготовления всей партии (makespan). Ингредиенты готовятся минимально допустимое
+ * время. План строится по правилу LPT (longest processing time first): шаги упорядочены
+ * по убыванию длительности, и каждый шаг занимает горелку, которая освободится первой.
+ * Плита отдаёт освободившуюся горелку первому шагу в очереди, поэтому, если ставить шаги
+ * в очередь в порядке плана, она выполняет именно это расписание.
+ * Makespan LPT не больше 4/3 оптимального, а здесь, при двух длительностях шагов,
+ * отличается от нижней оценки не больше чем на длительность самого длинного шага.
+ */
+inline CookingPlan PlanHotDogs(size_t num_orders, int num_burners) {
+    CookingPlan plan;
+    plan.steps.reserve(num_orders * 2);
+    // Сосиски готовятся дольше хлеба, поэтому занимают горелки первыми
+    static_assert(HotDog::MIN_SAUSAGE_COOK_DURATION >= HotDog::MIN_BREAD_COOK_DURATION);
+    for (size_t order = 0; order < num_orders; ++order) {
+        plan.steps.push_back({CookingStep::Kind::SAUSAGE, order});
+    }
+    for (size_t order = 0; order < num_orders; ++order) {
+        plan.steps.push_back({CookingStep::Kind::BREAD, order});
+    }
+
+    // Моменты освобождения горелок
+    const size_t burners_count = static_cast<size_t>(std::max(1, num_burners));
+    std::priority_queue<Clock::duration, std::vector<Clock::duration>, std::greater<>> burners;
+    for (size_t i = 0; i < burners_count; ++i) {
+        burners.push(Clock::duration::zero());
+    }
+    Clock::duration total{};
+    Clock::duration longest{};
+    for (const CookingStep& step : plan.steps) {
+        const Clock::duration end = burners.top() + step.GetDuration();
+        burners.pop();
+        burners.push(end);
+        plan.makespan = std::max(plan.makespan, end);
+        total += step.GetDuration();
+        longest = std::max(longest, step.GetDuration());
+    }
+    plan.lower_bound = std::max(longest, total / static_cast<Clock::rep>(burners_count));
+    return plan;
+}
+
+/*
+ * Партия хот-догов, приготовляемая по плану PlanHotDogs. Когда все хот-доги готовы, вызывается
+ * handler(std::vector<Result<HotDog>> hot_dogs, BatchReport report), хот-доги передаются
+ * в порядке заказов.
+ * Все ингредиенты партии сразу встают в очередь к горелкам плиты в порядке плана,
+ * а снимает их с огня один таймер. Моменты окончания приготовления округляются вверх
+ * до TIMER_GRANULARITY, поэтому ингредиенты, занявшие горелки почти одновременно,
+ * снимаются с огня за одно срабатывание таймера.
+ */
+template <typename Handler>
+class HotDogBatch : public std::enable_shared_from_this<HotDogBatch<Handler>> {
+public:
+    HotDogBatch(net::io_context& io, std::shared_ptr<GasCooker> cooker,
+                std::vector<HotDogOrder> orders, Handler handler)
+        : io_{io}
+        , cooker_{std::move(cooker)}
+        , orders_{std::move(orders)}
+        , handler_{std::move(handler)}
+        , plan_{PlanHotDogs(orders_.size(), cooker_->GetNumberOfBurners())}
+        , cooked_parts_(orders_.size())
+        , results_(orders_.size())
+        , latencies_(orders_.size()) {
+    }
+
+    HotDogBatch(const HotDogBatch&) = delete;
+    HotDogBatch& operator=(const HotDogBatch&) = delete;
+
+    // Начинает приготовление партии. Этот метод может быть вызван из произвольного потока
+    void Start() {
+        start_time_ = Clock::now();
+        steady_start_time_ = SteadyClock::now();
+        if (orders_.empty()) {
+            net::post(strand_, [self = this->shared_from_this()] {
+                self->Complete();
+            });
+            return;
+        }
+        for (const CookingStep& step : plan_.steps) {
+            auto on_started = [self = this->shared_from_this(), step] {
+                net::dispatch(self->strand_, [self, step] {
+                    self->OnCookingStarted(step);
+                });
+            };
+            const HotDogOrder& order = orders_[step.order];
+            if (step.kind == CookingStep::Kind::SAUSAGE) {
+                order.sausage->StartFry(*cooker_, std::move(on_started));
+            } else {
+                order.bread->StartBake(*cooker_, std::move(on_started));
+            }
+        }
+    }
+
+private:
+    using SteadyClock = std::chrono::steady_clock;
+
+    // Точность, с которой таймер снимает ингредиенты с огня. Она намного меньше разницы между
+    // минимальным и максимальным временем приготовления, поэтому хот-доги не бракуются
+    constexpr static SteadyClock::duration TIMER_GRANULARITY = Milliseconds{5};
+
+    struct Deadline {
+        SteadyClock::time_point time;
+        CookingStep step;
+
+        bool operator>(const Deadline& other) const noexcept {
+            return time > other.time;
+        }
+    };
+
+    // Методы ниже вызываются внутри strand_
+
+    void OnCookingStarted(CookingStep step) {
+        const auto since_start = SteadyClock::now() + step.GetDuration() - steady_start_time_;
+        const auto ticks = (since_start + TIMER_GRANULARITY - SteadyClock::duration{1})
+                           / TIMER_GRANULARITY;
+        const auto deadline = steady_start_time_ + ticks * TIMER_GRANULARITY;
+        deadlines_.push({deadline, step});
+        if (!armed_deadline_ || deadline < *armed_deadline_) {
+            ArmTimer();
+        }
+    }
+
+    void ArmTimer() {
+        armed_deadline_ = deadlines_.top().time;
+        // Ожидание, начатое раньше, отменяется
+        timer_.expires_at(*armed_deadline_);
+        timer_.async_wait([self = this->shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->OnTimer();
+            }
+        });
+    }
+
+    void OnTimer() {
+        const auto now = SteadyClock::now();
+        while (!deadlines_.empty() && deadlines_.top().time <= now) {
+            const CookingStep step = deadlines_.top().step;
+            deadlines_.pop();
+            StopCooking(step);
+        }
+        if (deadlines_.empty()) {
+            armed_deadline_.reset();
+        } else {
+            ArmTimer();
+        }
+    }
+
+    void StopCooking(CookingStep step) {
+        const HotDogOrder& order = orders_[step.order];
+        if (step.kind == CookingStep::Kind::SAUSAGE) {
+            order.sausage->StopFry();
+        } else {
+            order.bread->StopBaking();
+        }
+        if (++cooked_parts_[step.order] < 2) {
+            return;
+        }
+
+        // Оба ингредиента готовы. Забракованный хот-дог возвращается как код ошибки
+        results_[step.order].emplace(HotDog::Make(order.id, order.sausage, order.bread));
+        latencies_[step.order] = Clock::now() - start_time_;
+        if (++completed_ == orders_.size()) {
+            Complete();
+        }
+    }
+
+    void Complete() {
+        BatchReport report;
+        report.planned_makespan = plan_.makespan;
+        report.lower_bound = plan_.lower_bound;
+        report.makespan = Clock::now() - start_time_;
+
+        Clock::duration busy{};
+        std::vector<Result<HotDog>> hot_dogs;
+        hot_dogs.reserve(orders_.size());
+        for (size_t i = 0; i < orders_.size(); ++i) {
+            busy += orders_[i].sausage->GetCookDuration() + orders_[i].bread->GetBakingDuration();
+            hot_dogs.push_back(std::move(*results_[i]));
+        }
+        if (report.makespan > Clock::duration::zero()) {
+            using Seconds = std::chrono::duration<double>;
+            report.burner_utilization = Seconds{busy}.count()
+                                        / (Seconds{report.makespan}.count()
+                                           * cooker_->GetNumberOfBurners());
+        }
+        report.latencies = std::move(latencies_);
+        handler_(std::move(hot_dogs), std::move(report));
+    }
+
+    net::io_context& io_;
+    net::strand<net::io_context::executor_type> strand_{net::make_strand(io_)};
+    net::steady_timer timer_{strand_};
+    std::shared_ptr<GasCooker> cooker_;
+    std::vector<HotDogOrder> orders_;
+    Handler handler_;
+    CookingPlan plan_;
+    Clock::time_point start_time_;
+    SteadyClock::time_point steady_start_time_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines_;
+    // Момент, на который взведён таймер
+    std::optional<SteadyClock::time_point> armed_deadline_;
+    // Количество готовых ингредиентов каждого заказа
+    std::vector<int> cooked_parts_;
+    std::vector<std::optional<Result<HotDog>>> results_;
+    std::vector<Clock::duration> latencies_;
+    size_t completed_ = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "block_pool.h"
+#include "hotdog.h"
+#include "hotdog_batch.h"
+#include "result.h"
+
+namespace hotdog_kitchen_detail {
+
+// Заказ, ингредиенты которого готовят повара кухни. Обработчик хранится в наследнике,
+// поэтому повара не зависят от его типа
+class KitchenOrder {
+public:
+    explicit KitchenOrder(HotDogOrder ingredients)
+        : ingredients_{std::move(ingredients)} {
+    }
+
+    KitchenOrder(const KitchenOrder&) = delete;
+    KitchenOrder& operator=(const KitchenOrder&) = delete;
+
+    virtual ~KitchenOrder() = default;
+
+    const HotDogOrder& GetIngredients() const noexcept {
+        return ingredients_;
+    }
+
+    // Отмечает ингредиент приготовленным. Возвращает true для последнего ингредиента заказа
+    bool MarkCooked() noexcept {
+        return cooked_parts_.fetch_add(1, std::memory_order_acq_rel) == 1;
+    }
+
+    // Передаёт приготовленные ингредиенты обработчику заказа
+    virtual void Complete() = 0;
+
+protected:
+    HotDogOrder&& ReleaseIngredients() noexcept {
+        return std::move(ingredients_);
+    }
+
+private:
+    HotDogOrder ingredients_;
+    std::atomic<int> cooked_parts_{0};
+};
+
+template <typename Handler>
+class KitchenOrderImpl final : public KitchenOrder {
+public:
+    template <typename H>
+    KitchenOrderImpl(HotDogOrder ingredients, H&& handler)
+        : KitchenOrder{std::move(ingredients)}
+        , handler_{std::forward<H>(handler)} {
+    }
+
+    void Complete() override {
+        handler_(Result<HotDogOrder>{ReleaseIngredients()});
+    }
+
+private:
+    Handler handler_;
+};
+
+}  // namespace hotdog_kitchen_detail
+
+/*
+ * Кухня, на которой ингредиенты хот-догов готовят сопрограммы-повара.
+ * Сосиска и хлеб каждого заказа встают в общую очередь, а повар берёт из неё ингредиент,
+ * ожидает горелку, держит ингредиент на огне минимально допустимое время и снимает его.
+ * Новый повар запускается, только если очередь не разберут уже запущенные повара, а поваров
+ * не больше, чем горелок: лишний повар всё равно ждал бы горелку. Повар, сообщивший
+ * о готовности заказа, сразу берёт следующий ингредиент, поэтому при постоянном потоке
+ * заказов кадры сопрограмм поваров и их таймеры используются повторно, а заказ не выделяет
+ * память под кадры сопрограмм.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class HotDogKitchen {
+public:
+    HotDogKitchen(net::io_context& io, std::shared_ptr<GasCooker> cooker)
+        : io_{io}
+        , cooker_{std::move(cooker)} {
+    }
+
+    HotDogKitchen(const HotDogKitchen&) = delete;
+    HotDogKitchen& operator=(const HotDogKitchen&) = delete;
+
+    // Готовит ингредиенты order и вызывает handler(Result<HotDogOrder> cooked) в потоке повара.
+    // Хот-дог из приготовленных ингредиентов собирает вызывающий
+    template <typename Handler>
+    void CookIngredients(HotDogOrder order, Handler&& handler) {
+        using Order = hotdog_kitchen_detail::KitchenOrderImpl<std::decay_t<Handler>>;
+        // Заказы с одинаковым типом обработчика занимают блоки одного пула
+        std::shared_ptr<hotdog_kitchen_detail::KitchenOrder> kitchen_order =
+            std::allocate_shared<Order>(PoolAllocator<Order>{}, std::move(order),
+                                        std::forward<Handler>(handler));
+
+        int cooks_to_start = 0;
+        {
+            std::lock_guard lock{mutex_};
+            // Сосиска готовится дольше, поэтому занимает горелку первой
+            tasks_.push_back({kitchen_order, CookingStep::Kind::SAUSAGE});
+            tasks_.push_back({std::move(kitchen_order), CookingStep::Kind::BREAD});
+            while (tasks_.size() > ready_cooks_
+                   && cooks_ < static_cast<size_t>(cooker_->GetNumberOfBurners())) {
+                ++ready_cooks_;
+                ++cooks_;
+                ++cooks_to_start;
+            }
+        }
+        while (cooks_to_start-- > 0) {
+            net::co_spawn(io_.get_executor(), RunCook(), [](std::exception_ptr error) {
+                // Исключение, выброшенное обработчиком заказа, покидает io.run()
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            });
+        }
+    }
+
+private:
+    using Executor = net::io_context::executor_type;
+    using CookTimer = net::basic_waitable_timer<std::chrono::steady_clock,
+                                                net::wait_traits<std::chrono::steady_clock>,
+                                                Executor>;
+
+    struct CookingTask {
+        std::shared_ptr<hotdog_kitchen_detail::KitchenOrder> order;
+        CookingStep::Kind kind;
+    };
+
+    net::awaitable<void, Executor> RunCook() {
+        constexpr net::use_awaitable_t<Executor> use_awaitable;
+        const Executor executor = co_await net::this_coro::executor;
+        CookTimer timer{executor};
+
+        for (;;) {
+            CookingTask task;
+            {
+                std::lock_guard lock{mutex_};
+                --ready_cooks_;
+                if (tasks_.empty()) {
+                    --cooks_;
+                    co_return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            // Горелка занимается асинхронной операцией, а не вложенной сопрограммой,
+            // поэтому ожидание горелки не создаёт новый кадр
+            const HotDogOrder& ingredients = task.order->GetIngredients();
+            const bool is_sausage = task.kind == CookingStep::Kind::SAUSAGE;
+            co_await net::async_initiate<decltype(use_awaitable), void()>(
+                [this, &ingredients, is_sausage](auto handler) {
+                    if (is_sausage) {
+                        ingredients.sausage->StartFry(*cooker_, std::move(handler));
+                    } else {
+                        ingredients.bread->StartBake(*cooker_, std::move(handler));
+                    }
+                },
+                use_awaitable);
+
+            timer.expires_after(is_sausage ? HotDog::MIN_SAUSAGE_COOK_DURATION
+                                           : HotDog::MIN_BREAD_COOK_DURATION);
+            co_await timer.async_wait(use_awaitable);
+            if (is_sausage) {
+                ingredients.sausage->StopFry();
+            } else {
+                ingredients.bread->StopBaking();
+            }
+
+            {
+                std::lock_guard lock{mutex_};
+                // Повар возьмёт и заказ, сделанный обработчиком этого заказа
+                ++ready_cooks_;
+            }
+            if (task.order->MarkCooked()) {
+                try {
+                    task.order->Complete();
+                } catch (...) {
+                    std::lock_guard lock{mutex_};
+                    --ready_cooks_;
+                    --cooks_;
+                    throw;
+                }
+            }
+        }
+    }
+
+    net::io_context& io_;
+    std::shared_ptr<GasCooker> cooker_;
+    std::mutex mutex_;
+    std::deque<CookingTask> tasks_;
+    // Количество запущенных поваров и поваров, которые возьмут ингредиент из очереди,
+    // не дожидаясь горелки или таймера
+    size_t cooks_ = 0;
+    size_t ready_cooks_ = 0;
+};
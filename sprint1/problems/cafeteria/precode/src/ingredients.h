@@ -1,7 +1,10 @@
 #pragma once
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <optional>
 
+#include "block_pool.h"
 #include "clock.h"
 #include "gascooker.h"
 
@@ -11,8 +14,6 @@
 */
 class Sausage : public std::enable_shared_from_this<Sausage> {
 public:
-    using Handler = std::function<void()>;
-
     explicit Sausage(int id)
         : id_{id} {
     }
@@ -21,8 +22,10 @@ public:
         return id_;
     }
 
-    // Асинхронно начинает приготовление. Вызывает handler, как только началось приготовление
-    void StartFry(GasCooker& cooker, Handler handler) {
+    // Асинхронно начинает приготовление. Вызывает handler, как только началось приготовление.
+    // handler не оборачивается в std::function и хранится в очереди плиты как есть
+    template <typename Handler>
+    void StartFry(GasCooker& cooker, Handler&& handler) {
         // Метод StartFry можно вызвать только один раз
         if (frying_start_time_) {
             throw std::logic_error("Frying already started");
@@ -36,11 +39,12 @@ public:
 
         // Занимаем горелку для начала обжаривания.
         // Чтобы продлить жизнь текущего объекта, захватываем shared_ptr в лямбде
-        cooker.UseBurner([self = shared_from_this(), handler = std::move(handler)] {
-            // Запоминаем время фактического начала обжаривания
-            self->frying_start_time_ = Clock::now();
-            handler();
-        });
+        cooker.UseBurner(
+            [self = shared_from_this(), handler = std::forward<Handler>(handler)]() mutable {
+                // Запоминаем время фактического начала обжаривания
+                self->frying_start_time_ = Clock::now();
+                handler();
+            });
     }
 
     // Завершает приготовление и освобождает горелку
@@ -77,8 +81,6 @@ private:
 // Класс "Хлеб". Ведёт себя аналогично классу "Сосиска"
 class Bread : public std::enable_shared_from_this<Bread> {
 public:
-    using Handler = std::function<void()>;
-
     explicit Bread(int id)
         : id_{id} {
     }
@@ -89,48 +91,90 @@ public:
 
     // Начинает приготовление хлеба на газовой плите. Как только горелка будет занята, вызовет
     // handler
-    void StartBake(GasCooker& cooker, Handler handler) {
-        // Реализуйте этот метод аналогично Sausage::StartFry
-        assert(!"Bread::StartBake is not implemented");
-        throw std::logic_error("Bread::StartBake is not implemented");
+    template <typename Handler>
+    void StartBake(GasCooker& cooker, Handler&& handler) {
+        // Метод StartBake можно вызвать только один раз
+        if (baking_start_time_) {
+            throw std::logic_error("Baking already started");
+        }
+
+        // Запрещаем повторный вызов StartBake
+        baking_start_time_ = Clock::now();
+
+        // Готовимся занять газовую плиту
+        gas_cooker_lock_ = GasCookerLock{cooker.shared_from_this()};
+
+        // Занимаем горелку для начала выпекания.
+        // Чтобы продлить жизнь текущего объекта, захватываем shared_ptr в лямбде
+        cooker.UseBurner(
+            [self = shared_from_this(), handler = std::forward<Handler>(handler)]() mutable {
+                // Запоминаем время фактического начала выпекания
+                self->baking_start_time_ = Clock::now();
+                handler();
+            });
     }
 
     // Останавливает приготовление хлеба и освобождает горелку.
     void StopBaking() {
-        // Реализуйте этот метод по аналогии с Sausage::StopFry
-        assert(!"Bread::StopBaking is not implemented");
-        throw std::logic_error("Bread::StopBaking is not implemented");
+        if (!baking_start_time_) {
+            throw std::logic_error("Baking has not started");
+        }
+        if (baking_end_time_) {
+            throw std::logic_error("Baking has already stopped");
+        }
+        baking_end_time_ = Clock::now();
+        // Освобождаем горелку
+        gas_cooker_lock_.Unlock();
     }
 
     // Информирует, испечён ли хлеб
     bool IsCooked() const noexcept {
-        // Реализуйте этот метод аналогично Sausage::IsCooked
-        assert(!"Bread::IsCooked is not implemented");
-        return false;
+        return baking_start_time_.has_value() && baking_end_time_.has_value();
     }
 
     // Возвращает продолжительность выпекания хлеба. Бросает исключение, если хлеб не был испечён
     Clock::duration GetBakingDuration() const {
-        // Реализуйте этот метод аналогично Sausage::GetCookDuration
-        assert(!"Bread::GetBakingDuration is not implemented");
-        throw std::logic_error("Bread::GetBakingDuration is not implemented");
+        if (!baking_start_time_ || !baking_end_time_) {
+            throw std::logic_error("Bread has not been baked");
+        }
+        return *baking_end_time_ - *baking_start_time_;
     }
 
 private:
     int id_;
+    GasCookerLock gas_cooker_lock_;
+    std::optional<Clock::time_point> baking_start_time_;
+    std::optional<Clock::time_point> baking_end_time_;
 };
 
-// Склад ингредиентов (возвращает ингредиенты с уникальным id)
+// Склад ингредиентов (возвращает ингредиенты с уникальным id).
+// Ингредиенты каждого вида размещаются в своём пуле блоков вместе с блоком управления
+// shared_ptr, поэтому при постоянном потоке заказов склад не обращается к operator new.
+// Методы класса можно вызывать из разных потоков
 class Store {
 public:
     std::shared_ptr<Bread> GetBread() {
-        return std::make_shared<Bread>(++next_id_);
+        return std::allocate_shared<Bread>(PoolAllocator<Bread>{}, GetNextId());
     }
 
     std::shared_ptr<Sausage> GetSausage() {
-        return std::make_shared<Sausage>(++next_id_);
+        return std::allocate_shared<Sausage>(PoolAllocator<Sausage>{}, GetNextId());
+    }
+
+    // Пулы общие для всех складов программы, поэтому счётчики учитывают ингредиенты
+    // всех складов
+    static PoolStats GetBreadStats() noexcept {
+        return BlockPool<Bread>::GetInstance().GetStats();
+    }
+
+    static PoolStats GetSausageStats() noexcept {
+        return BlockPool<Sausage>::GetInstance().GetStats();
     }
 
 private:
-    int next_id_ = 0;
+    int GetNextId() noexcept {
+        return next_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<int> next_id_{0};
 };
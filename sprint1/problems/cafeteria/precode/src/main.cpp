@@ -2,6 +2,10 @@
 #include <sdkddkver.h>
 #endif
 
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <cstdlib>
 #include <iostream>
 #include <latch>
 #include <mutex>
@@ -55,7 +59,9 @@ void PrintHotDogResult(const Result<HotDog>& result, Clock::duration order_durat
     }
 }
 
-std::vector<HotDog> PrepareHotDogs(int num_orders, unsigned num_threads) {
+// Готовит num_orders хот-догов отдельными заказами. Если use_coroutines равен true,
+// заказы выполняются сопрограммами через Cafeteria::AsyncOrderHotDog
+std::vector<HotDog> PrepareHotDogs(int num_orders, unsigned num_threads, bool use_coroutines) {
     net::io_context io{static_cast<int>(num_threads)};
 
     Cafeteria cafeteria{io};
@@ -74,7 +80,8 @@ std::vector<HotDog> PrepareHotDogs(int num_orders, unsigned num_threads) {
     for (int i = 0; i < num_orders; ++i) {
         // Выполняем функцию через boost::asio::dispatch, чтобы вызвать Cafeteria::OrderHotDog в
         // нескольких потоках
-        net::dispatch(io, [&cafeteria, &hotdogs, &mut, i, start_time, &start, num_waiting_threads] {
+        net::dispatch(io, [&io, &cafeteria, &hotdogs, &mut, i, start_time, &start,
+                           num_waiting_threads, use_coroutines] {
             std::osyncstream{std::cout} << "Order #" << i << " is scheduled on thread #"
                                         << std::this_thread::get_id() << std::endl;
 
@@ -84,7 +91,7 @@ std::vector<HotDog> PrepareHotDogs(int num_orders, unsigned num_threads) {
                 start.arrive_and_wait();
             }
 
-            cafeteria.OrderHotDog([&hotdogs, &mut, start_time](Result<HotDog> result) {
+            auto on_ready = [&hotdogs, &mut, start_time](Result<HotDog> result) {
                 const auto duration = Clock::now() - start_time;
                 PrintHotDogResult(result, duration);
                 if (result.HasValue()) {
@@ -92,7 +99,18 @@ std::vector<HotDog> PrepareHotDogs(int num_orders, unsigned num_threads) {
                     std::lock_guard lk{mut};
                     hotdogs.emplace_back(std::move(result).GetValue());
                 }
-            });
+            };
+            if (!use_coroutines) {
+                cafeteria.OrderHotDog(on_ready);
+                return;
+            }
+            // Сопрограмма клиента дожидается хот-дога, приготовленного сопрограммами-поварами
+            net::co_spawn(
+                io,
+                [&cafeteria, on_ready]() -> net::awaitable<void> {
+                    on_ready(co_await cafeteria.AsyncOrderHotDog(net::use_awaitable));
+                },
+                net::detached);
         });
     }
 
@@ -130,16 +148,92 @@ void VerifyHotDogs(const std::vector<HotDog>& hotdogs) {
     }
 }
 
+// Готовит партию из num_orders хот-догов на плите с num_burners горелками
+// и выводит статистику её приготовления
+void PrepareHotDogBatch(int num_orders, int num_burners, unsigned num_threads) {
+    net::io_context io{static_cast<int>(num_threads)};
+    Cafeteria cafeteria{io, num_burners};
+
+    std::vector<HotDog> hotdogs;
+    BatchReport report;
+    cafeteria.OrderHotDogs(num_orders, [&hotdogs, &report](std::vector<Result<HotDog>> results,
+                                                            BatchReport batch_report) {
+        for (auto& result : results) {
+            if (!result.HasValue()) {
+                PrintHotDogResult(result, batch_report.makespan);
+                continue;
+            }
+            hotdogs.emplace_back(std::move(result).GetValue());
+        }
+        report = std::move(batch_report);
+    });
+
+    RunWorkers(num_threads, [&io] {
+        io.run();
+    });
+
+    auto as_seconds = [](auto d) {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+    };
+    Clock::duration total_latency{};
+    Clock::duration max_latency{};
+    for (const auto latency : report.latencies) {
+        total_latency += latency;
+        max_latency = std::max(max_latency, latency);
+    }
+    std::cout << "Hot dogs: "sv << hotdogs.size() << " of "sv << num_orders << ", burners: "sv
+              << num_burners << '\n'
+              << "Makespan: "sv << as_seconds(report.makespan) << "s (planned "sv
+              << as_seconds(report.planned_makespan) << "s), "sv
+              << hotdogs.size() / as_seconds(report.makespan) << " hot dogs per second\n"sv
+              << "Latency: mean "sv
+              << as_seconds(total_latency) / std::max<size_t>(1, report.latencies.size())
+              << "s, max "sv << as_seconds(max_latency) << "s\n"sv
+              << "Lower bound: "sv << as_seconds(report.lower_bound) << "s, planned makespan is "sv
+              << as_seconds(report.planned_makespan) / as_seconds(report.lower_bound)
+              << " of it\n"sv
+              << "Burner utilization: "sv << report.burner_utilization * 100 << '%' << std::endl;
+    for (const auto& [name, stats] : {std::pair{"Sausage"sv, Store::GetSausageStats()},
+                                      std::pair{"Bread"sv, Store::GetBreadStats()}}) {
+        std::cout << name << " pool: "sv << stats.allocations << " allocations, "sv
+                  << stats.system_allocations << " system allocations"sv << std::endl;
+    }
+
+    // Ни один хот-дог не должен быть забракован
+    assert(hotdogs.size() == static_cast<size_t>(num_orders));
+    // План не может быть быстрее нижней оценки, а список LPT отстаёт от неё
+    // не больше чем на самый длинный шаг
+    assert(report.planned_makespan >= report.lower_bound);
+    assert(report.planned_makespan
+           <= report.lower_bound + HotDog::MIN_SAUSAGE_COOK_DURATION);
+    VerifyHotDogs(hotdogs);
+}
+
 }  // namespace
 
-int main() {
+/*
+ * Без аргументов готовит 20 хот-догов отдельными заказами и проверяет время приготовления.
+ * С аргументом --coroutines делает то же самое, но заказы выполняют сопрограммы.
+ * С аргументами --batch <заказов> [<горелок>] готовит партию хот-догов одним заказом
+ * и выводит её статистику
+ */
+int main(int argc, const char* argv[]) {
     using namespace std::chrono;
 
+    if (argc > 2 && argv[1] == "--batch"sv) {
+        const int num_orders = std::atoi(argv[2]);
+        const int num_burners = argc > 3 ? std::atoi(argv[3]) : 8;
+        PrepareHotDogBatch(num_orders, num_burners,
+                           std::max(1u, std::thread::hardware_concurrency()));
+        return 0;
+    }
+
     constexpr unsigned num_threads = 4;
     constexpr int num_orders = 20;
+    const bool use_coroutines = argc > 1 && argv[1] == "--coroutines"sv;
 
     const auto start_time = Clock::now();
-    auto hotdogs = PrepareHotDogs(num_orders, num_threads);
+    auto hotdogs = PrepareHotDogs(num_orders, num_threads, use_coroutines);
     const auto cook_duration = Clock::now() - start_time;
 
     std::cout << "Cook duration: " << duration_cast<duration<double>>(cook_duration).count() << 's'
@@ -1,9 +1,27 @@
 #pragma once
+#include <functional>
 #include <stdexcept>
+#include <system_error>
 #include <type_traits>
+#include <utility>
 #include <variant>
 
-// Вспомогательный класс Result, способный хранить либо значение, либо исключение
+template <typename ValueType>
+class Result;
+
+template <typename T>
+struct IsResult : std::false_type {};
+
+template <typename ValueType>
+struct IsResult<Result<ValueType>> : std::true_type {
+    using Value = ValueType;
+};
+
+/*
+ * Вспомогательный класс Result, способный хранить либо значение, либо ошибку.
+ * Ошибка хранится в виде исключения или кода ошибки. Код ошибки, в отличие от исключения,
+ * создаётся без выделения памяти и раскрутки стека, поэтому подходит для ожидаемых ошибок.
+ */
 template <typename ValueType>
 class Result {
 public:
@@ -33,6 +51,19 @@ public:
         }
     }
 
+    /*
+     * Конструирует результат, хранящий код ошибки.
+     * Способ использования:
+     *
+     * Result<тип> result{std::make_error_code(std::errc::timed_out)};
+     */
+    Result(std::error_code error)
+        : state_{error} {
+        if (!error) {
+            throw std::invalid_argument("Error code must not be empty");
+        }
+    }
+
     /*
      * Создаёт результат, который хранит ссылку на текущее выброшенное исключение
      * Способ использования:
@@ -51,16 +82,88 @@ public:
         return std::holds_alternative<ValueType>(state_);
     }
 
-    // Если внутри Result хранится исключение, то возвращает указатель на него
+    // Сообщает, хранится ли внутри код ошибки
+    bool HoldsErrorCode() const noexcept {
+        return std::holds_alternative<std::error_code>(state_);
+    }
+
+    // Если внутри Result хранится ошибка, то возвращает указатель на исключение с ней.
+    // Код ошибки возвращается в виде исключения std::system_error
     std::exception_ptr GetError() const {
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            return std::make_exception_ptr(std::system_error{*code});
+        }
         return std::get<std::exception_ptr>(state_);
     }
 
-    // Если внутри содержится исключение, то выбрасывает его. Иначе не делает ничего.
+    // Если внутри Result хранится код ошибки, то возвращает его. Иначе выбрасывает
+    // std::bad_variant_access
+    std::error_code GetErrorCode() const {
+        return std::get<std::error_code>(state_);
+    }
+
+    // Если внутри содержится ошибка, то выбрасывает её. Иначе не делает ничего.
+    // Код ошибки выбрасывается в виде исключения std::system_error
     void ThrowIfHoldsError() const {
         if (auto e = std::get_if<std::exception_ptr>(&state_)) {
             std::rethrow_exception(*e);
         }
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            throw std::system_error{*code};
+        }
+    }
+
+    /*
+     * Если внутри хранится значение, возвращает Result со значением fn(value), иначе - Result
+     * с той же ошибкой. Исключение, выброшенное fn, сохраняется в возвращаемом Result.
+     * Способ использования:
+     *
+     * Result<int> size = std::move(result).Map([](std::string s) { return s.size(); });
+     */
+    template <typename Fn>
+    auto Map(Fn&& fn) const& {
+        return MapImpl(*this, std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    auto Map(Fn&& fn) && {
+        return MapImpl(std::move(*this), std::forward<Fn>(fn));
+    }
+
+    /*
+     * Аналог Map для функций, которые сами возвращают Result. Позволяет выстраивать шаги,
+     * каждый из которых может завершиться ошибкой, в цепочку без вложенных проверок:
+     *
+     * auto hot_dog = Bake().Then(Fry).Then(Assemble);
+     */
+    template <typename Fn>
+    auto Then(Fn&& fn) const& {
+        return ThenImpl(*this, std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    auto Then(Fn&& fn) && {
+        return ThenImpl(std::move(*this), std::forward<Fn>(fn));
+    }
+
+    /*
+     * Асинхронный аналог Then. step(value, handler) запускает асинхронный шаг, который
+     * однократно вызывает handler(Result<U>). Если внутри хранится ошибка, step не вызывается,
+     * а handler сразу получает Result<U> с этой ошибкой. Исключение, выброшенное step,
+     * передаётся вызывающему. Тип handler не стирается, поэтому переход к следующему шагу
+     * не создаёт std::function:
+     *
+     * TakeIngredients().ThenAsync<HotDogOrder>(cook, [](Result<HotDogOrder> cooked) { ... });
+     */
+    template <typename U, typename Step, typename Handler>
+    void ThenAsync(Step&& step, Handler&& handler) const& {
+        ThenAsyncImpl<U>(*this, std::forward<Step>(step), std::forward<Handler>(handler));
+    }
+
+    template <typename U, typename Step, typename Handler>
+    void ThenAsync(Step&& step, Handler&& handler) && {
+        ThenAsyncImpl<U>(std::move(*this), std::forward<Step>(step),
+                         std::forward<Handler>(handler));
     }
 
     // Возвращает ссылку на хранящееся значение. Если Result хранит исключение, выбрасывает
@@ -76,5 +179,54 @@ public:
     }
 
 private:
-    std::variant<ValueType, std::exception_ptr> state_;
+    template <typename U>
+    Result<U> PropagateError() const {
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            return *code;
+        }
+        return std::get<std::exception_ptr>(state_);
+    }
+
+    template <typename Self, typename Fn>
+    static auto MapImpl(Self&& self, Fn&& fn) {
+        using U = std::remove_cvref_t<
+            std::invoke_result_t<Fn, decltype(std::forward<Self>(self).GetValue())>>;
+        static_assert(!std::is_void_v<U>, "Map requires a function returning a value");
+        if (!self.HasValue()) {
+            return self.template PropagateError<U>();
+        }
+        try {
+            return Result<U>{
+                std::invoke(std::forward<Fn>(fn), std::forward<Self>(self).GetValue())};
+        } catch (...) {
+            return Result<U>::FromCurrentException();
+        }
+    }
+
+    template <typename Self, typename Fn>
+    static auto ThenImpl(Self&& self, Fn&& fn) {
+        using R = std::remove_cvref_t<
+            std::invoke_result_t<Fn, decltype(std::forward<Self>(self).GetValue())>>;
+        static_assert(IsResult<R>::value, "Then requires a function returning Result");
+        if (!self.HasValue()) {
+            return self.template PropagateError<typename IsResult<R>::Value>();
+        }
+        try {
+            return R{std::invoke(std::forward<Fn>(fn), std::forward<Self>(self).GetValue())};
+        } catch (...) {
+            return R::FromCurrentException();
+        }
+    }
+
+    template <typename U, typename Self, typename Step, typename Handler>
+    static void ThenAsyncImpl(Self&& self, Step&& step, Handler&& handler) {
+        if (!self.HasValue()) {
+            return std::invoke(std::forward<Handler>(handler),
+                               self.template PropagateError<U>());
+        }
+        std::invoke(std::forward<Step>(step), std::forward<Self>(self).GetValue(),
+                    std::forward<Handler>(handler));
+    }
+
+    std::variant<ValueType, std::exception_ptr, std::error_code> state_;
 };
@@ -0,0 +1,60 @@
+// Измеряет стоимость проверки запроса в http_server::AdmissionControl, когда несколько
+// потоков одновременно проверяют запросы клиентов с разными адресами и токенами
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/admission_control.h"
+#include "../src/token_table.h"
+
+using namespace std::literals;
+
+int main(int argc, const char* argv[]) {
+    const unsigned num_threads =
+        argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    const int num_clients = argc > 2 ? std::atoi(argv[2]) : 10'000;
+    const int checks = argc > 3 ? std::atoi(argv[3]) : 1'000'000;
+
+    http_server::AdmissionOptions options;
+    options.per_ip = {100, 200};
+    options.per_token = {100, 200};
+    http_server::AdmissionControl admission{options};
+
+    std::vector<boost::asio::ip::address> addresses;
+    std::vector<std::string> tokens;
+    for (int i = 0; i < num_clients; ++i) {
+        addresses.emplace_back(boost::asio::ip::address_v4{static_cast<unsigned>(0x0A000000 + i)});
+        const auto id = static_cast<std::uint64_t>(i) + 1;
+        tokens.push_back("Bearer "s + app::Token{id * 1'000'000'007ull, id}.ToString());
+    }
+
+    std::vector<size_t> rejected(num_threads);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < checks; ++i) {
+                const size_t client = (i * 7919 + t * 104'729) % addresses.size();
+                rejected[t] += admission.AdmitRequest(addresses[client], tokens[client]) ? 1 : 0;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    size_t total_rejected = 0;
+    for (const size_t r : rejected) {
+        total_rejected += r;
+    }
+    std::cout << "threads: "sv << num_threads << ", clients: "sv << num_clients << '\n'
+              << "AdmitRequest: "sv << elapsed.count() / checks << " ns per check, rejected "sv
+              << total_rejected << " of "sv << static_cast<size_t>(checks) * num_threads
+              << std::endl;
+}
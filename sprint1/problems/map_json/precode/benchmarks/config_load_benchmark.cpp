@@ -0,0 +1,162 @@
+// Сравнивает время загрузки и пиковое потребление памяти при потоковом разборе
+// конфигурации (json_loader::LoadGame) и разборе через JSON-документ (LoadGameDom),
+// время потоковой загрузки при построении карт в одном и в нескольких потоках,
+// а также загрузку из двоичного образа мира (world_image::WorldImage)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../src/json_loader.h"
+#include "../src/world_image.h"
+
+using namespace std::literals;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Записывает конфигурацию из num_maps карт, на каждой из которых num_roads дорог,
+// num_roads / 4 зданий и num_roads / 16 офисов
+void GenerateConfig(const fs::path& path, int num_maps, int num_roads) {
+    std::ofstream out{path};
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> coord{0, 10'000};
+    out << "{\"maps\": ["sv;
+    for (int m = 0; m < num_maps; ++m) {
+        out << (m ? ","sv : ""sv) << "{\"id\": \"map"sv << m << "\", \"name\": \"Map "sv << m
+            << "\", \"dogSpeed\": 4.0, \"roads\": ["sv;
+        for (int i = 0; i < num_roads; ++i) {
+            out << (i ? ","sv : ""sv) << "{\"x0\": "sv << coord(rng) << ", \"y0\": "sv
+                << coord(rng) << (i % 2 ? ", \"x1\": "sv : ", \"y1\": "sv) << coord(rng) << '}';
+        }
+        out << "], \"buildings\": ["sv;
+        for (int i = 0; i < num_roads / 4; ++i) {
+            out << (i ? ","sv : ""sv) << "{\"x\": "sv << coord(rng) << ", \"y\": "sv
+                << coord(rng) << ", \"w\": "sv << coord(rng) % 50 << ", \"h\": "sv
+                << coord(rng) % 50 << '}';
+        }
+        out << "], \"offices\": ["sv;
+        for (int i = 0; i < num_roads / 16; ++i) {
+            out << (i ? ","sv : ""sv) << "{\"id\": \"o"sv << i << "\", \"x\": "sv << coord(rng)
+                << ", \"y\": "sv << coord(rng) << ", \"offsetX\": 5, \"offsetY\": 0}"sv;
+        }
+        out << "]}"sv;
+    }
+    out << "]}"sv;
+}
+
+bool SameGames(const model::Game& lhs, const model::Game& rhs) {
+    if (lhs.GetMaps().size() != rhs.GetMaps().size()) {
+        return false;
+    }
+    for (size_t m = 0; m < lhs.GetMaps().size(); ++m) {
+        const auto& a = lhs.GetMaps()[m];
+        const auto& b = rhs.GetMaps()[m];
+        if (a.GetId() != b.GetId() || a.GetName() != b.GetName()
+            || a.GetRoads().size() != b.GetRoads().size()
+            || a.GetBuildings().size() != b.GetBuildings().size()
+            || a.GetOffices().size() != b.GetOffices().size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.GetRoads().size(); ++i) {
+            const auto& ra = a.GetRoads()[i];
+            const auto& rb = b.GetRoads()[i];
+            if (ra.GetStart().x != rb.GetStart().x || ra.GetStart().y != rb.GetStart().y
+                || ra.GetEnd().x != rb.GetEnd().x || ra.GetEnd().y != rb.GetEnd().y) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < a.GetOffices().size(); ++i) {
+            if (a.GetOffices()[i].GetId() != b.GetOffices()[i].GetId()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Загружает конфигурацию в дочернем процессе и выводит время загрузки
+// и пиковый размер резидентной памяти процесса
+template <typename Loader>
+void MeasureInChild(std::string_view name, const fs::path& path, Loader loader) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        const auto start = std::chrono::steady_clock::now();
+        const model::Game game = loader(path);
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::cout << name << ": "sv << elapsed.count() << " ms, maps: "sv
+                  << game.GetMaps().size() << std::flush;
+        std::_Exit(EXIT_SUCCESS);
+    }
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    std::cout << ", peak RSS: "sv << usage.ru_maxrss / 1024 << " MiB"sv << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const int num_maps = argc > 1 ? std::atoi(argv[1]) : 8;
+    const int num_roads = argc > 2 ? std::atoi(argv[2]) : 200'000;
+    const fs::path path = fs::temp_directory_path() / "config_load_benchmark.json";
+    const fs::path image_path = fs::temp_directory_path() / "config_load_benchmark.bin";
+
+    try {
+        GenerateConfig(path, num_maps, num_roads);
+        std::cout << "config size: "sv << fs::file_size(path) / (1024 * 1024) << " MiB"sv
+                  << std::endl;
+
+        MeasureInChild("streaming, 1 thread"sv, path, [](const fs::path& p) {
+            return json_loader::LoadGame(p, 1);
+        });
+        MeasureInChild("streaming, all cores"sv, path, [](const fs::path& p) {
+            return json_loader::LoadGame(p);
+        });
+        MeasureInChild("DOM"sv, path, json_loader::LoadGameDom);
+
+        world_image::WriteWorldImage(json_loader::LoadGame(path), image_path);
+        std::cout << "world image size: "sv << fs::file_size(image_path) / (1024 * 1024)
+                  << " MiB"sv << std::endl;
+        MeasureInChild("world image, open"sv, image_path, [](const fs::path& p) {
+            const world_image::WorldImage image{p};
+            model::Game game;
+            for (size_t i = 0; i < image.GetMapCount(); ++i) {
+                game.AddMap(model::Map{model::Map::Id{util::InternedString{image.GetMap(i).GetId()}},
+                                       std::string{image.GetMap(i).GetName()}});
+            }
+            return game;
+        });
+        MeasureInChild("world image, to model"sv, image_path, [](const fs::path& p) {
+            return world_image::WorldImage{p}.ToGame();
+        });
+
+        if (!SameGames(json_loader::LoadGame(path), json_loader::LoadGameDom(path))
+            || !SameGames(json_loader::LoadGame(path, 1), json_loader::LoadGame(path))
+            || !SameGames(world_image::WorldImage{image_path}.ToGame(),
+                          json_loader::LoadGame(path))) {
+            std::cerr << "Loaded games differ"sv << std::endl;
+            fs::remove(path);
+            fs::remove(image_path);
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        fs::remove(path);
+        fs::remove(image_path);
+        return EXIT_FAILURE;
+    }
+    fs::remove(path);
+    fs::remove(image_path);
+}
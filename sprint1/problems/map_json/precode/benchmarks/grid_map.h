@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "../src/model.h"
+
+// Создаёт карту-сетку из num_lines горизонтальных и num_lines вертикальных дорог,
+// проходящих через всю карту на расстоянии spacing друг от друга
+inline model::Map MakeGridMap(int num_lines, int spacing) {
+    using namespace std::literals;
+    model::Map map{model::Map::Id{util::InternedString{"bench"sv}}, "Benchmark map"s};
+    const int size = (num_lines - 1) * spacing;
+    for (int line = 0; line < num_lines; ++line) {
+        map.AddRoad({model::Road::HORIZONTAL, {0, line * spacing}, size});
+        map.AddRoad({model::Road::VERTICAL, {line * spacing, 0}, size});
+    }
+    return map;
+}
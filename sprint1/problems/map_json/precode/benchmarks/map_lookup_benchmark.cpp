@@ -0,0 +1,88 @@
+// Сравнивает поиск карты по id из запроса с помощью Game::FindMap(std::string_view)
+// с поиском в std::unordered_map<std::string, ...>, требующим создания std::string
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+
+namespace {
+
+template <typename Fn>
+double MeasureNsPerCall(const std::vector<std::string>& targets, int rounds, Fn&& fn) {
+    size_t found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& target : targets) {
+            found += fn(std::string_view{target}) ? 1 : 0;
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (found == 0) {
+        std::cerr << "Nothing found"sv << std::endl;
+    }
+    return elapsed.count() / (static_cast<double>(rounds) * targets.size());
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const int num_maps = argc > 1 ? std::atoi(argv[1]) : 64;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 100'000;
+
+    model::Game game;
+    std::unordered_map<std::string, const model::Map*> by_string;
+    for (int i = 0; i < num_maps; ++i) {
+        const std::string id = "town-with-a-rather-long-map-id-"s + std::to_string(i);
+        game.AddMap(model::Map{model::Map::Id{util::InternedString{id}}, "Map "s + id});
+    }
+    for (const auto& map : game.GetMaps()) {
+        by_string.emplace(std::string{map.GetId()->GetView()}, &map);
+    }
+
+    // Идентификаторы из запросов: существующие карты и несуществующие
+    std::vector<std::string> targets;
+    std::mt19937 rng{42};
+    for (int i = 0; i < 1024; ++i) {
+        const int n = std::uniform_int_distribution<int>{0, num_maps * 5 / 4}(rng);
+        targets.push_back("town-with-a-rather-long-map-id-"s + std::to_string(n));
+    }
+
+    const double string_map_ns = MeasureNsPerCall(targets, rounds, [&](std::string_view id) {
+        const auto it = by_string.find(std::string{id});
+        return it != by_string.end() ? it->second : nullptr;
+    });
+    const double find_map_ns = MeasureNsPerCall(targets, rounds, [&](std::string_view id) {
+        return game.FindMap(id);
+    });
+    const std::vector<model::Map::Id> ids = [&] {
+        std::vector<model::Map::Id> result;
+        for (const auto& map : game.GetMaps()) {
+            result.push_back(map.GetId());
+        }
+        return result;
+    }();
+    size_t found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            found += game.FindMap(ids[i % ids.size()]) ? 1 : 0;
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << "maps: "sv << num_maps << '\n'
+              << "unordered_map<string> with std::string key: "sv << string_map_ns << " ns\n"sv
+              << "Game::FindMap(string_view): "sv << find_map_ns << " ns\n"sv
+              << "Game::FindMap(Map::Id): "sv
+              << elapsed.count() / (static_cast<double>(rounds) * targets.size()) << " ns ("sv
+              << found << " found)"sv << std::endl;
+}
@@ -0,0 +1,154 @@
+// Сравнивает поиск дорог с помощью RoadIndex с линейным перебором всех дорог карты
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr double HALF_WIDTH = model::RoadIndex::HALF_WIDTH;
+
+bool Covers(const model::Road& road, geom::Point2D p) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    const auto [min_x, max_x] = std::minmax(start.x, end.x);
+    const auto [min_y, max_y] = std::minmax(start.y, end.y);
+    return p.x >= min_x - HALF_WIDTH && p.x <= max_x + HALF_WIDTH && p.y >= min_y - HALF_WIDTH
+           && p.y <= max_y + HALF_WIDTH;
+}
+
+std::vector<size_t> FindRoadsCoveringLinear(const model::Map& map, geom::Point2D p) {
+    std::vector<size_t> result;
+    const auto& roads = map.GetRoads();
+    for (size_t i = 0; i < roads.size(); ++i) {
+        if (Covers(roads[i], p)) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+geom::Point2D GetFurthestPointLinear(const model::Map& map, geom::Point2D p) {
+    // Движение на восток
+    geom::Point2D furthest = p;
+    for (bool moved = true; moved;) {
+        moved = false;
+        double next_x = furthest.x;
+        for (const auto& road : map.GetRoads()) {
+            if (Covers(road, furthest)) {
+                next_x = std::max(next_x, std::max(road.GetStart().x, road.GetEnd().x) + HALF_WIDTH);
+            }
+        }
+        if (next_x > furthest.x + model::RoadIndex::COORD_EPSILON) {
+            furthest.x = next_x;
+            moved = true;
+        }
+    }
+    return furthest;
+}
+
+// Создаёт карту-сетку из num_lines горизонтальных и num_lines вертикальных линий,
+// каждая из которых разбита на короткие дороги со случайными разрывами
+model::Map MakeGridMap(int num_lines, int spacing, std::mt19937& rng) {
+    model::Map map{model::Map::Id{util::InternedString{"bench"sv}}, "Benchmark map"s};
+    const int size = num_lines * spacing;
+    std::uniform_int_distribution<int> gap{0, 3};
+    for (int line = 0; line < num_lines; ++line) {
+        const int coord = line * spacing;
+        for (int start = 0; start < size; start += spacing) {
+            if (gap(rng) == 0) {
+                continue;
+            }
+            map.AddRoad({model::Road::HORIZONTAL, {start, coord}, start + spacing});
+            map.AddRoad({model::Road::VERTICAL, {coord, start}, start + spacing});
+        }
+    }
+    return map;
+}
+
+std::vector<geom::Point2D> MakeQueries(const model::Map& map, size_t count, std::mt19937& rng) {
+    std::vector<geom::Point2D> queries;
+    queries.reserve(count);
+    std::uniform_int_distribution<size_t> road_dist{0, map.GetRoads().size() - 1};
+    std::uniform_real_distribution<double> offset_dist{0.0, 1.0};
+    std::uniform_real_distribution<double> width_dist{-HALF_WIDTH, HALF_WIDTH};
+    for (size_t i = 0; i < count; ++i) {
+        const auto& road = map.GetRoads()[road_dist(rng)];
+        const auto start = road.GetStart();
+        const auto end = road.GetEnd();
+        const double t = offset_dist(rng);
+        queries.emplace_back(start.x + (end.x - start.x) * t + width_dist(rng),
+                             start.y + (end.y - start.y) * t + width_dist(rng));
+    }
+    return queries;
+}
+
+template <typename Fn>
+double MeasureSeconds(Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RunBenchmark(int num_lines, size_t num_queries) {
+    std::mt19937 rng{42};
+    const auto map = MakeGridMap(num_lines, 10, rng);
+    const auto queries = MakeQueries(map, num_queries, rng);
+    const auto& index = map.GetRoadIndex();
+
+    std::vector<std::vector<size_t>> linear_result(queries.size());
+    std::vector<std::vector<size_t>> indexed_result(queries.size());
+
+    const double linear_time = MeasureSeconds([&] {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            linear_result[i] = FindRoadsCoveringLinear(map, queries[i]);
+        }
+    });
+    const double indexed_time = MeasureSeconds([&] {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            indexed_result[i] = index.FindRoadsCovering(queries[i]);
+        }
+    });
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        std::sort(indexed_result[i].begin(), indexed_result[i].end());
+        assert(linear_result[i] == indexed_result[i]);
+    }
+
+    // Поиск дальней точки перебором выполняется для меньшего числа запросов
+    const size_t num_move_queries = std::min<size_t>(queries.size(), 1000);
+    std::vector<geom::Point2D> linear_points(num_move_queries);
+    std::vector<geom::Point2D> indexed_points(num_move_queries);
+    const double linear_move_time = MeasureSeconds([&] {
+        for (size_t i = 0; i < num_move_queries; ++i) {
+            linear_points[i] = GetFurthestPointLinear(map, queries[i]);
+        }
+    });
+    const double indexed_move_time = MeasureSeconds([&] {
+        for (size_t i = 0; i < num_move_queries; ++i) {
+            indexed_points[i] = index.GetFurthestPoint(queries[i], model::Direction::EAST);
+        }
+    });
+    assert(linear_points == indexed_points);
+
+    std::cout << "roads: "sv << map.GetRoads().size() << ", queries: "sv << queries.size()
+              << "\n  covering roads: linear "sv << linear_time * 1e9 / queries.size()
+              << " ns/query, index "sv << indexed_time * 1e9 / queries.size() << " ns/query"sv
+              << "\n  furthest point: linear "sv << linear_move_time * 1e9 / num_move_queries
+              << " ns/query, index "sv << indexed_move_time * 1e9 / num_move_queries
+              << " ns/query"sv << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    for (int num_lines : {10, 50, 200}) {
+        RunBenchmark(num_lines, 100'000);
+    }
+}
@@ -0,0 +1,101 @@
+// Сравнивает сопоставление пути запроса с маршрутами API с помощью Router
+// и цепочки проверок starts_with/== по тем же маршрутам
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/router.h"
+
+using namespace std::literals;
+namespace http = boost::beast::http;
+using http_handler::MethodBit;
+using http_handler::RouteMatch;
+using http_handler::RouteSpec;
+
+namespace {
+
+constexpr std::uint64_t GET_HEAD = MethodBit(http::verb::get) | MethodBit(http::verb::head);
+constexpr std::uint64_t POST = MethodBit(http::verb::post);
+
+// Маршруты, которые должны появиться в API игры
+constexpr std::array ROUTES{
+    RouteSpec{"/api/v1/maps"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/maps/{id}"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/join"sv, POST, "POST"sv},
+    RouteSpec{"/api/v1/game/players"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/state"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/player/action"sv, POST, "POST"sv},
+    RouteSpec{"/api/v1/game/tick"sv, POST, "POST"sv},
+    RouteSpec{"/api/v1/game/records"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/tick-stats"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/route-stats"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/session/{id:uint}/state"sv, GET_HEAD, "GET, HEAD"sv},
+};
+
+constexpr auto ROUTER = http_handler::MakeRouter<ROUTES>();
+
+// Поиск маршрута перебором: так выглядела бы маршрутизация без префиксного дерева
+size_t MatchLinear(std::string_view path) {
+    constexpr std::string_view MAP_PREFIX = "/api/v1/maps/"sv;
+    constexpr std::string_view SESSION_PREFIX = "/api/v1/game/session/"sv;
+    for (size_t i = 0; i < ROUTES.size(); ++i) {
+        if (ROUTES[i].pattern.find('{') == std::string_view::npos && path == ROUTES[i].pattern) {
+            return i;
+        }
+    }
+    if (path.starts_with(MAP_PREFIX) && path.find('/', MAP_PREFIX.size()) == path.npos) {
+        return 1;
+    }
+    if (path.starts_with(SESSION_PREFIX) && path.ends_with("/state"sv)) {
+        return ROUTES.size() - 1;
+    }
+    return RouteMatch::NOT_FOUND;
+}
+
+template <typename Fn>
+double MeasureNsPerCall(const std::vector<std::string>& paths, int rounds, Fn&& fn) {
+    size_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& path : paths) {
+            checksum += fn(std::string_view{path});
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (checksum == 0) {
+        std::cerr << "Nothing matched"sv << std::endl;
+    }
+    return elapsed.count() / (static_cast<double>(rounds) * paths.size());
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 200'000;
+    const std::vector<std::string> paths{
+        "/api/v1/maps"s,           "/api/v1/maps/map1"s,       "/api/v1/game/join"s,
+        "/api/v1/game/players"s,   "/api/v1/game/state"s,      "/api/v1/game/player/action"s,
+        "/api/v1/game/tick"s,      "/api/v1/game/records"s,    "/api/v1/game/session/17/state"s,
+        "/api/v1/unknown/path"s};
+
+    for (const auto& path : paths) {
+        if (ROUTER.Match(http::verb::get, path).route != MatchLinear(path)) {
+            std::cerr << "Router and linear matching disagree on "sv << path << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const double router_ns = MeasureNsPerCall(paths, rounds, [](std::string_view path) {
+        return ROUTER.Match(http::verb::get, path).route + 1;
+    });
+    const double linear_ns = MeasureNsPerCall(paths, rounds, [](std::string_view path) {
+        return MatchLinear(path) + 1;
+    });
+    std::cout << "routes: "sv << ROUTES.size() << '\n'
+              << "router: "sv << router_ns << " ns per request\n"sv
+              << "linear: "sv << linear_ns << " ns per request"sv << std::endl;
+}
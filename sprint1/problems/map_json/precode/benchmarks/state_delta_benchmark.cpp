@@ -0,0 +1,121 @@
+// Сравнивает размер и время формирования полного состояния игры и изменений
+// после тика, который клиент получил при предыдущем опросе
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../src/state_journal.h"
+#include "grid_map.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr auto TICK_PERIOD = 50ms;
+
+// Положение, вычисленное клиентом по скорости, отличается от положения на сервере
+// только ошибками округления
+bool SameDogs(const app::DogState& lhs, const app::DogState& rhs) {
+    constexpr double EPSILON = 1e-6;
+    return lhs.id == rhs.id && std::abs(lhs.position.x - rhs.position.x) < EPSILON
+           && std::abs(lhs.position.y - rhs.position.y) < EPSILON && lhs.speed.x == rhs.speed.x
+           && lhs.speed.y == rhs.speed.y && lhs.direction == rhs.direction;
+}
+
+struct Totals {
+    double bytes = 0;
+    double us = 0;
+};
+
+template <typename Fn>
+void Measure(Totals& totals, Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::string body = fn();
+    totals.us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+                     .count();
+    totals.bytes += static_cast<double>(body.size());
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t num_dogs = argc > 1 ? std::atoi(argv[1]) : 2'000;
+    // Доля собак, получающих новое действие на каждом тике, в процентах
+    const int active_percent = argc > 2 ? std::atoi(argv[2]) : 2;
+    const int num_ticks = argc > 3 ? std::atoi(argv[3]) : 200;
+    // Клиент опрашивает сервер раз в poll_interval тиков
+    const int poll_interval = argc > 4 ? std::atoi(argv[4]) : 2;
+
+    const auto map = MakeGridMap(100, 10);
+    model::GameSession session{map};
+    app::StateJournal journal{TICK_PERIOD};
+
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> line_dist{0, 99};
+    std::uniform_int_distribution<size_t> dog_dist{0, num_dogs - 1};
+    std::uniform_int_distribution<int> direction_dist{0, 3};
+    std::uniform_real_distribution<double> speed_dist{1.0, 5.0};
+    for (size_t i = 0; i < num_dogs; ++i) {
+        session.AddDog({line_dist(rng) * 10.0, line_dist(rng) * 10.0});
+    }
+    journal.RecordChanges(session);
+    journal.RecordState(session);
+
+    Totals full;
+    Totals delta;
+    std::vector<app::DogState> client_dogs = journal.GetState(std::nullopt).dogs;
+    std::uint64_t client_tick = 0;
+    int polls = 0;
+    for (int tick = 1; tick <= num_ticks; ++tick) {
+        for (size_t i = 0; i < num_dogs * active_percent / 100; ++i) {
+            session.SetDogAction(dog_dist(rng), static_cast<model::Direction>(direction_dist(rng)),
+                                 speed_dist(rng));
+        }
+        session.Tick(TICK_PERIOD);
+        journal.RecordChanges(session);
+        if (tick % poll_interval != 0) {
+            continue;
+        }
+        // Полное состояние сохраняется только перед опросом, как при догоняющих тиках
+        journal.RecordState(session);
+
+        ++polls;
+        Measure(full, [&] {
+            return app::SerializeState(journal.GetState(std::nullopt));
+        });
+        app::StateView changes;
+        Measure(delta, [&] {
+            changes = journal.GetState(client_tick);
+            return app::SerializeState(changes);
+        });
+
+        // Клиент сдвигает собак, не попавших в изменения, на пройденный путь и применяет
+        // изменения. После этого он должен получить полное состояние
+        const double seconds = std::chrono::duration<double>(changes.tick_period).count()
+                               * static_cast<double>(changes.tick - client_tick);
+        for (auto& dog : client_dogs) {
+            dog.position.x += dog.speed.x * seconds;
+            dog.position.y += dog.speed.y * seconds;
+        }
+        for (const auto& dog : changes.dogs) {
+            client_dogs[dog.id] = dog;
+        }
+        client_tick = changes.tick;
+        const auto actual = journal.GetState(std::nullopt).dogs;
+        for (size_t i = 0; i < actual.size(); ++i) {
+            if (!SameDogs(actual[i], client_dogs[i])) {
+                std::cerr << "Client state diverged at tick "sv << tick << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    std::cout << "dogs: "sv << num_dogs << ", active per tick: "sv << active_percent
+              << "%, poll every "sv << poll_interval << " ticks\n"sv
+              << "full:  "sv << full.bytes / polls << " bytes, "sv << full.us / polls
+              << " us per poll\n"sv
+              << "delta: "sv << delta.bytes / polls << " bytes, "sv << delta.us / polls
+              << " us per poll"sv << std::endl;
+}
@@ -0,0 +1,103 @@
+// Сравнивает рассылку состояния после тика через app::StateStream, сериализующий кадр
+// один раз, с сериализацией состояния отдельно для каждого подписчика
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../src/state_stream.h"
+#include "grid_map.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Подписчик, который, как медленный клиент, оставляет только последний кадр
+class LatestFrameSubscriber : public app::StreamSubscriber {
+public:
+    void Push(app::StateFramePtr frame) override {
+        bytes_ += frame->IsApplicable(last_tick_) ? frame->GetChanges().size()
+                                                   : frame->GetFullState().size();
+        last_tick_ = frame->GetTick();
+        frame_ = std::move(frame);
+    }
+
+    size_t GetBytes() const noexcept {
+        return bytes_;
+    }
+
+private:
+    app::StateFramePtr frame_;
+    std::optional<std::uint64_t> last_tick_;
+    size_t bytes_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const size_t num_dogs = argc > 1 ? std::atoi(argv[1]) : 500;
+    const size_t num_subscribers = argc > 2 ? std::atoi(argv[2]) : 200;
+    const int num_ticks = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    const auto map = MakeGridMap(100, 10);
+    model::GameSession session{map};
+    app::StateJournal journal{50ms};
+    app::StateStream stream;
+
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> line_dist{0, 99};
+    std::uniform_int_distribution<size_t> dog_dist{0, num_dogs - 1};
+    std::uniform_int_distribution<int> direction_dist{0, 3};
+    for (size_t i = 0; i < num_dogs; ++i) {
+        session.AddDog({line_dist(rng) * 10.0, line_dist(rng) * 10.0});
+    }
+    journal.RecordChanges(session);
+    journal.RecordState(session);
+
+    std::vector<std::shared_ptr<LatestFrameSubscriber>> subscribers;
+    for (size_t i = 0; i < num_subscribers; ++i) {
+        subscribers.push_back(std::make_shared<LatestFrameSubscriber>());
+        stream.Subscribe(subscribers.back());
+    }
+
+    std::chrono::duration<double, std::micro> stream_time{0};
+    std::chrono::duration<double, std::micro> per_subscriber_time{0};
+    std::optional<std::uint64_t> last_tick;
+    size_t per_subscriber_bytes = 0;
+    for (int tick = 1; tick <= num_ticks; ++tick) {
+        for (size_t i = 0; i < num_dogs / 50; ++i) {
+            session.SetDogAction(dog_dist(rng), static_cast<model::Direction>(direction_dist(rng)),
+                                 3.0);
+        }
+        session.Tick(50ms);
+        journal.RecordChanges(session);
+        journal.RecordState(session);
+
+        auto start = std::chrono::steady_clock::now();
+        stream.Publish(journal);
+        stream_time += std::chrono::steady_clock::now() - start;
+
+        // Каждому клиенту изменения сериализуются заново, как при отдельных HTTP-запросах
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_subscribers; ++i) {
+            per_subscriber_bytes += app::SerializeState(journal.GetState(last_tick)).size();
+        }
+        per_subscriber_time += std::chrono::steady_clock::now() - start;
+        last_tick = journal.GetState(std::nullopt).tick;
+    }
+
+    size_t stream_bytes = 0;
+    for (const auto& subscriber : subscribers) {
+        stream_bytes += subscriber->GetBytes();
+    }
+    if (stream_bytes != per_subscriber_bytes) {
+        std::cerr << "Subscribers received "sv << stream_bytes << " bytes, expected "sv
+                  << per_subscriber_bytes << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "dogs: "sv << num_dogs << ", subscribers: "sv << num_subscribers << '\n'
+              << "StateStream:    "sv << stream_time.count() / num_ticks << " us per tick\n"sv
+              << "per subscriber: "sv << per_subscriber_time.count() / num_ticks
+              << " us per tick"sv << std::endl;
+}
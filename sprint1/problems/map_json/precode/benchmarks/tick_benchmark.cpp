@@ -0,0 +1,50 @@
+// Измеряет длительность тика игровой сессии в зависимости от количества собак
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "../src/game_session.h"
+#include "grid_map.h"
+
+using namespace std::literals;
+
+namespace {
+
+void RunBenchmark(const model::Map& map, size_t num_dogs, int num_ticks) {
+    std::mt19937 rng{42};
+    const int num_lines = static_cast<int>(map.GetRoads().size() / 2);
+    std::uniform_int_distribution<int> line_dist{0, num_lines - 1};
+    std::uniform_int_distribution<int> direction_dist{0, 3};
+    std::uniform_real_distribution<double> speed_dist{1.0, 5.0};
+
+    model::GameSession session{map};
+    for (size_t i = 0; i < num_dogs; ++i) {
+        // Собаки размещаются на перекрёстках, чтобы любое направление вело вдоль дороги
+        const auto& road = map.GetRoads()[2 * line_dist(rng)];
+        const auto start = road.GetStart();
+        const size_t dog = session.AddDog({static_cast<double>(line_dist(rng) * 10),
+                                           static_cast<double>(start.y)});
+        session.SetDogAction(dog, static_cast<model::Direction>(direction_dist(rng)),
+                             speed_dist(rng));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ticks; ++i) {
+        session.Tick(50ms);
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << "dogs: "sv << num_dogs << ", tick: "sv << elapsed.count() / num_ticks
+              << " us, per dog: "sv << elapsed.count() * 1000 / num_ticks / num_dogs << " ns"sv
+              << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    const auto map = MakeGridMap(100, 10);
+    for (size_t num_dogs : {100, 1'000, 10'000, 100'000}) {
+        RunBenchmark(map, num_dogs, 200);
+    }
+}
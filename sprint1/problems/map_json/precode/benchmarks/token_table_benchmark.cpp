@@ -0,0 +1,134 @@
+// Сравнивает поиск игрока по токену из заголовка Authorization в app::TokenTable
+// и в std::unordered_map<std::string, Player*> под мьютексом, пока другой поток
+// добавляет новых игроков
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/token_table.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Player {
+    int id;
+};
+
+// Таблица токенов, которую предполагалось использовать в join_game
+class MutexTokenMap {
+public:
+    Player* Find(std::string_view token) const {
+        std::lock_guard lock{mutex_};
+        const auto it = players_.find(std::string{token});
+        return it != players_.end() ? it->second : nullptr;
+    }
+
+    void Insert(std::string token, Player* player) {
+        std::lock_guard lock{mutex_};
+        players_.emplace(std::move(token), player);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Player*> players_;
+};
+
+// Запускает num_readers потоков, каждый из которых выполняет lookups поисков,
+// и поток, добавляющий игроков, пока читатели работают. Возвращает время на один поиск
+template <typename Find, typename Insert>
+double Run(unsigned num_readers, int lookups, const std::vector<std::string>& headers,
+           Find&& find, Insert&& insert) {
+    std::atomic<bool> done{false};
+    std::atomic<size_t> misses{0};
+    std::thread writer{[&] {
+        int id = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            insert(++id);
+            std::this_thread::sleep_for(100us);
+        }
+    }};
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < num_readers; ++r) {
+        readers.emplace_back([&, r] {
+            size_t local_misses = 0;
+            for (int i = 0; i < lookups; ++i) {
+                local_misses += find(headers[(i + r * 7919) % headers.size()]) ? 0 : 1;
+            }
+            misses.fetch_add(local_misses);
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    done = true;
+    writer.join();
+
+    if (misses != 0) {
+        std::cerr << "Lost lookups: "sv << misses << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    return elapsed.count() / lookups;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const unsigned num_readers =
+        argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    const int num_players = argc > 2 ? std::atoi(argv[2]) : 10'000;
+    const int lookups = argc > 3 ? std::atoi(argv[3]) : 1'000'000;
+
+    app::TokenGenerator generator;
+    std::vector<Player> players(num_players);
+    std::vector<app::Token> tokens;
+    std::vector<std::string> headers;
+    app::TokenTable<Player> table;
+    MutexTokenMap map;
+    for (int i = 0; i < num_players; ++i) {
+        players[i].id = i;
+        tokens.push_back(generator.Generate());
+        headers.push_back("Bearer "s + tokens.back().ToString());
+        table.Insert(tokens.back(), &players[i]);
+        map.Insert(tokens.back().ToString(), &players[i]);
+    }
+
+    // Игроки, добавляемые во время измерения, хранятся отдельно и не ищутся
+    std::vector<Player> late_players(1'000'000);
+    app::TokenGenerator late_generator;
+    const double table_ns = Run(
+        num_readers, lookups, headers,
+        [&](std::string_view header) {
+            const auto token = app::Token::ParseBearer(header);
+            return token ? table.Find(*token) : nullptr;
+        },
+        [&](int id) {
+            if (static_cast<size_t>(id) < late_players.size()) {
+                table.Insert(late_generator.Generate(), &late_players[id]);
+            }
+        });
+    const double map_ns = Run(
+        num_readers, lookups, headers,
+        [&](std::string_view header) {
+            return map.Find(header.substr("Bearer "sv.size()));
+        },
+        [&](int id) {
+            if (static_cast<size_t>(id) < late_players.size()) {
+                map.Insert(late_generator.Generate().ToString(), &late_players[id]);
+            }
+        });
+
+    std::cout << "readers: "sv << num_readers << ", players: "sv << num_players << '\n'
+              << "TokenTable: "sv << table_ns << " ns per lookup\n"sv
+              << "mutex + unordered_map<string>: "sv << map_ns << " ns per lookup"sv << std::endl;
+}
@@ -0,0 +1,136 @@
+#include "admission_control.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "token_table.h"
+
+namespace http_server {
+
+using namespace std::literals;
+
+RateLimiter::RateLimiter(double rate, double burst)
+    : rate_{rate}
+    , burst_{burst} {
+    if (rate_ <= 0 || burst_ < 1) {
+        throw std::invalid_argument("Rate limit must be positive and allow at least one request");
+    }
+}
+
+std::optional<RateLimiter::Clock::duration> RateLimiter::Acquire(std::string_view key,
+                                                                 Clock::time_point now) {
+    const size_t hash = KeyHasher{}(key);
+    // Младшие биты хеша выбирают корзину внутри unordered_map, поэтому сегмент
+    // выбирается по старшим
+    Segment& segment = segments_[(hash >> (sizeof(size_t) * 8 - 4)) % NUM_SEGMENTS];
+
+    std::lock_guard lock{segment.mutex};
+    const auto it = segment.buckets.find(key);
+    if (it == segment.buckets.end()) {
+        AddBucket(segment, key) = {burst_ - 1, now};
+        return std::nullopt;
+    }
+
+    Bucket& bucket = it->second;
+    bucket.tokens = Refill(bucket, now);
+    bucket.updated = now;
+    if (bucket.tokens < 1) {
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>{(1 - bucket.tokens) / rate_});
+    }
+    bucket.tokens -= 1;
+    return std::nullopt;
+}
+
+double RateLimiter::Refill(const Bucket& bucket, Clock::time_point now) const noexcept {
+    const std::chrono::duration<double> elapsed = now - bucket.updated;
+    return std::min(burst_, bucket.tokens + elapsed.count() * rate_);
+}
+
+RateLimiter::Bucket& RateLimiter::AddBucket(Segment& segment, std::string_view key) {
+    if (segment.keys.empty()) {
+        segment.buckets.reserve(MAX_SEGMENT_SIZE + 1);
+        segment.keys.reserve(MAX_SEGMENT_SIZE);
+    }
+    const auto it = segment.buckets.emplace(std::string{key}, Bucket{}).first;
+    if (segment.keys.size() < MAX_SEGMENT_SIZE) {
+        segment.keys.push_back(&it->first);
+    } else {
+        // Место самой старой корзины занимает новая
+        segment.buckets.erase(*std::exchange(segment.keys[segment.oldest], &it->first));
+        segment.oldest = (segment.oldest + 1) % MAX_SEGMENT_SIZE;
+    }
+    return it->second;
+}
+
+AdmissionControl::AdmissionControl(AdmissionOptions options)
+    : options_{options} {
+    const auto make_limiter = [](std::optional<RateLimiter>& limiter, const RateLimit& limit) {
+        if (limit.rate > 0) {
+            limiter.emplace(limit.rate, limit.burst > 0 ? limit.burst : std::max(1.0, limit.rate));
+        }
+    };
+    make_limiter(ip_limiter_, options_.per_ip);
+    make_limiter(token_limiter_, options_.per_token);
+
+    const auto retry_after = std::max<std::chrono::seconds::rep>(1, options_.retry_after.count());
+    connection_reject_response_.append("HTTP/1.1 503 Service Unavailable\r\n"sv)
+        .append("Retry-After: "sv)
+        .append(std::to_string(retry_after))
+        .append("\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"sv);
+}
+
+bool AdmissionControl::TryAcquireConnection() noexcept {
+    if (options_.max_connections == 0) {
+        connections_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    size_t connections = connections_.load(std::memory_order_relaxed);
+    do {
+        if (connections >= options_.max_connections) {
+            return false;
+        }
+    } while (!connections_.compare_exchange_weak(connections, connections + 1,
+                                                 std::memory_order_relaxed));
+    return true;
+}
+
+void AdmissionControl::ReleaseConnection() noexcept {
+    connections_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::optional<std::chrono::seconds> AdmissionControl::AdmitRequest(
+    const net::ip::address& address, std::string_view authorization) {
+    const auto now = RateLimiter::Clock::now();
+    std::optional<RateLimiter::Clock::duration> wait;
+    if (ip_limiter_) {
+        // Ключом служит двоичное представление адреса, строка для него не форматируется
+        if (address.is_v4()) {
+            const auto bytes = address.to_v4().to_bytes();
+            wait = ip_limiter_->Acquire(
+                {reinterpret_cast<const char*>(bytes.data()), bytes.size()}, now);
+        } else {
+            const auto bytes = address.to_v6().to_bytes();
+            wait = ip_limiter_->Acquire(
+                {reinterpret_cast<const char*>(bytes.data()), bytes.size()}, now);
+        }
+    }
+    if (!wait && token_limiter_) {
+        // Корзины заводятся только для токенов правильного формата, поэтому произвольные
+        // значения заголовка не вытесняют корзины настоящих игроков. Ключом служат
+        // двоичные половины токена, так что регистр шестнадцатеричных цифр не важен
+        if (const auto token = app::Token::ParseBearer(authorization)) {
+            const std::uint64_t halves[] = {token->hi, token->lo};
+            wait = token_limiter_->Acquire(
+                {reinterpret_cast<const char*>(halves), sizeof(halves)}, now);
+        }
+    }
+    if (!wait) {
+        return std::nullopt;
+    }
+    const auto seconds = std::chrono::ceil<std::chrono::seconds>(*wait);
+    return std::max(seconds, std::max(options_.retry_after, std::chrono::seconds{1}));
+}
+
+}  // namespace http_server
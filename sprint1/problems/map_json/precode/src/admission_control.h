@@ -0,0 +1,179 @@
+#pragma once
+#include "sdk.h"
+//
+#include <boost/asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+/*
+ * Ограничитель частоты запросов по алгоритму token bucket с отдельной корзиной на каждый
+ * ключ. Корзина вмещает burst жетонов и пополняется со скоростью rate жетонов в секунду,
+ * каждый запрос забирает один жетон.
+ *
+ * Корзины распределены между сегментами со своими мьютексами, поэтому запросы с разными
+ * ключами почти не конкурируют. Сегмент хранит не больше MAX_SEGMENT_SIZE корзин в кольцевом
+ * буфере: корзина нового ключа в заполненном сегменте занимает место самой старой корзины
+ * за O(1). Самая старая корзина обычно давно наполнилась до краёв и ничем не отличается
+ * от отсутствующей.
+ */
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RateLimiter(double rate, double burst);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Забирает жетон из корзины key. Если корзина пуста, возвращает время,
+    // через которое в ней появится жетон
+    std::optional<Clock::duration> Acquire(std::string_view key, Clock::time_point now);
+
+private:
+    constexpr static size_t NUM_SEGMENTS = 16;
+    // Количество корзин в сегменте, после которого новые корзины вытесняют старые
+    constexpr static size_t MAX_SEGMENT_SIZE = 4096;
+
+    struct Bucket {
+        double tokens;
+        Clock::time_point updated;
+    };
+
+    struct KeyHasher {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    struct Segment {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bucket, KeyHasher, std::equal_to<>> buckets;
+        // Ключи корзин в порядке добавления, начиная с oldest. Элементы unordered_map
+        // не перемещаются в памяти, поэтому указатели на ключи остаются действительными
+        std::vector<const std::string*> keys;
+        size_t oldest = 0;
+    };
+
+    double Refill(const Bucket& bucket, Clock::time_point now) const noexcept;
+    // Возвращает корзину для нового ключа, при необходимости вытесняя самую старую
+    Bucket& AddBucket(Segment& segment, std::string_view key);
+
+    double rate_;
+    double burst_;
+    std::array<Segment, NUM_SEGMENTS> segments_;
+};
+
+struct RateLimit {
+    // Запросов в секунду. 0 - ограничение не действует
+    double rate = 0;
+    // Запросов, которые можно выполнить подряд после простоя. 0 - равно rate
+    double burst = 0;
+};
+
+struct AdmissionOptions {
+    // Максимальное количество одновременно открытых HTTP-соединений. 0 - без ограничения
+    size_t max_connections = 0;
+    RateLimit per_ip;
+    // Ограничение для запросов с заголовком Authorization вида "Bearer <токен>", общее
+    // для всех запросов с одинаковым токеном. Заголовки другого формата не заводят корзин,
+    // такие запросы ограничиваются только per_ip
+    RateLimit per_token;
+    // Минимальное значение заголовка Retry-After в отклонённых ответах
+    std::chrono::seconds retry_after{1};
+};
+
+/*
+ * Контроль допуска запросов к обработке.
+ * Решение принимается до чтения тела запроса, поэтому отказ обходится серверу
+ * дешевле обработки и не задерживает допущенные запросы.
+ * Один объект разделяется всеми Listener-ами и сессиями сервера.
+ */
+class AdmissionControl {
+public:
+    explicit AdmissionControl(AdmissionOptions options);
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    // Занимает место для нового соединения. Возвращает false, если мест нет
+    bool TryAcquireConnection() noexcept;
+    void ReleaseConnection() noexcept;
+
+    // Проверяет, можно ли обработать запрос клиента address с заголовком Authorization,
+    // равным authorization (пустая строка, если заголовка нет).
+    // Если нельзя, возвращает значение для заголовка Retry-After в секундах
+    std::optional<std::chrono::seconds> AdmitRequest(const net::ip::address& address,
+                                                     std::string_view authorization);
+
+    // Ответ, отправляемый соединению сверх лимита без чтения запроса
+    std::string_view GetConnectionRejectResponse() const noexcept {
+        return connection_reject_response_;
+    }
+
+    size_t GetConnections() const noexcept {
+        return connections_.load(std::memory_order_relaxed);
+    }
+
+private:
+    AdmissionOptions options_;
+    std::atomic<size_t> connections_{0};
+    std::optional<RateLimiter> ip_limiter_;
+    std::optional<RateLimiter> token_limiter_;
+    std::string connection_reject_response_;
+};
+
+/*
+ * Место соединения, занятое AdmissionControl::TryAcquireConnection.
+ * Освобождает место при разрушении. Перемещается вместе с соединением, например,
+ * из HTTP-сессии в сессию WebSocket, поэтому место занято, пока открыт поток.
+ */
+class ConnectionSlot {
+public:
+    ConnectionSlot() = default;
+
+    // Принимает во владение место, уже занятое в admission_control
+    explicit ConnectionSlot(std::shared_ptr<AdmissionControl> admission_control) noexcept
+        : admission_control_{std::move(admission_control)} {
+    }
+
+    ConnectionSlot(ConnectionSlot&& other) noexcept = default;
+
+    ConnectionSlot& operator=(ConnectionSlot&& rhs) noexcept {
+        if (this != &rhs) {
+            Release();
+            admission_control_ = std::move(rhs.admission_control_);
+        }
+        return *this;
+    }
+
+    ~ConnectionSlot() {
+        Release();
+    }
+
+private:
+    void Release() noexcept {
+        if (admission_control_) {
+            admission_control_->ReleaseConnection();
+            admission_control_.reset();
+        }
+    }
+
+    std::shared_ptr<AdmissionControl> admission_control_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,23 @@
+#pragma once
+#include <functional>
+
+namespace http_handler {
+
+/*
+ * Ответ, который формируется асинхронно, например, в strand игровой сессии или в пуле
+ * потоков для блокирующих операций. run получает функцию respond, которую нужно однократно
+ * вызвать из любого потока.
+ */
+template <typename ResponseType>
+struct DeferredResponse {
+    using Respond = std::function<void(ResponseType&& response)>;
+    std::function<void(Respond respond)> run;
+};
+
+template <typename T>
+constexpr bool IS_DEFERRED_RESPONSE = false;
+
+template <typename ResponseType>
+constexpr bool IS_DEFERRED_RESPONSE<DeferredResponse<ResponseType>> = true;
+
+}  // namespace http_handler
@@ -0,0 +1,33 @@
+#include "duration_histogram.h"
+
+#include <algorithm>
+
+namespace app {
+
+void DurationHistogram::Record(std::chrono::nanoseconds duration) noexcept {
+    const auto us = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    const auto bucket =
+        std::lower_bound(BUCKET_BOUNDS_US.begin(), BUCKET_BOUNDS_US.end(), us)
+        - BUCKET_BOUNDS_US.begin();
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    total_us_.fetch_add(us, std::memory_order_relaxed);
+
+    std::uint64_t max_us = max_us_.load(std::memory_order_relaxed);
+    while (us > max_us
+           && !max_us_.compare_exchange_weak(max_us, us, std::memory_order_relaxed)) {
+    }
+}
+
+DurationHistogram::Snapshot DurationHistogram::GetSnapshot() const noexcept {
+    Snapshot snapshot;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.total_us = total_us_.load(std::memory_order_relaxed);
+    snapshot.max_us = max_us_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+}  // namespace app
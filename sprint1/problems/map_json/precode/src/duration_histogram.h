@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace app {
+
+/*
+ * Гистограмма длительностей с фиксированными границами корзин.
+ * Запись и чтение можно выполнять из разных потоков без блокировок.
+ */
+class DurationHistogram {
+public:
+    // Верхние границы корзин в микросекундах. Длительности больше последней границы
+    // попадают в дополнительную последнюю корзину
+    constexpr static std::array<std::uint64_t, 12> BUCKET_BOUNDS_US{
+        10, 25, 50, 100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000};
+    constexpr static size_t NUM_BUCKETS = BUCKET_BOUNDS_US.size() + 1;
+
+    struct Snapshot {
+        std::array<std::uint64_t, NUM_BUCKETS> counts{};
+        std::uint64_t count = 0;
+        std::uint64_t total_us = 0;
+        std::uint64_t max_us = 0;
+    };
+
+    void Record(std::chrono::nanoseconds duration) noexcept;
+    Snapshot GetSnapshot() const noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, NUM_BUCKETS> counts_{};
+    std::atomic<std::uint64_t> total_us_{0};
+    std::atomic<std::uint64_t> max_us_{0};
+};
+
+}  // namespace app
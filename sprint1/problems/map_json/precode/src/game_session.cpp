@@ -0,0 +1,100 @@
+#include "game_session.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace model {
+
+size_t GameSession::AddDog(geom::Point2D position) {
+    const size_t dog = dogs_.Size();
+    try {
+        dogs_.x.push_back(position.x);
+        dogs_.y.push_back(position.y);
+        dogs_.speed_x.push_back(0.0);
+        dogs_.speed_y.push_back(0.0);
+        dogs_.direction.push_back(Direction::NORTH);
+        is_changed_.push_back(false);
+    } catch (...) {
+        // Возвращаем массивы к одинаковой длине, если добавить собаку не удалось
+        dogs_.x.resize(dog);
+        dogs_.y.resize(dog);
+        dogs_.speed_x.resize(dog);
+        dogs_.speed_y.resize(dog);
+        dogs_.direction.resize(dog);
+        is_changed_.resize(dog);
+        throw;
+    }
+    MarkChanged(dog);
+    return dog;
+}
+
+void GameSession::SetDogAction(size_t dog, Direction direction, double speed) {
+    if (dog >= dogs_.Size()) {
+        throw std::out_of_range("Invalid dog index");
+    }
+    dogs_.direction[dog] = direction;
+    double speed_x = 0.0;
+    double speed_y = 0.0;
+    switch (direction) {
+        case Direction::NORTH:
+            speed_y = -speed;
+            break;
+        case Direction::SOUTH:
+            speed_y = speed;
+            break;
+        case Direction::WEST:
+            speed_x = -speed;
+            break;
+        case Direction::EAST:
+            speed_x = speed;
+            break;
+    }
+    dogs_.speed_x[dog] = speed_x;
+    dogs_.speed_y[dog] = speed_y;
+    MarkChanged(dog);
+}
+
+void GameSession::Tick(TimeInterval delta) {
+    const double seconds = std::chrono::duration<double>(delta).count();
+    const RoadIndex& roads = map_.GetRoadIndex();
+    const size_t num_dogs = dogs_.Size();
+
+    double* const x = dogs_.x.data();
+    double* const y = dogs_.y.data();
+    double* const speed_x = dogs_.speed_x.data();
+    double* const speed_y = dogs_.speed_y.data();
+    const Direction* const direction = dogs_.direction.data();
+
+    for (size_t dog = 0; dog < num_dogs; ++dog) {
+        // Собака движется вдоль одной из осей, поэтому модуль скорости равен сумме
+        // модулей её компонент
+        const double speed = std::abs(speed_x[dog]) + std::abs(speed_y[dog]);
+        if (speed == 0.0) {
+            continue;
+        }
+        const auto [position, stopped] =
+            roads.Move({x[dog], y[dog]}, direction[dog], speed * seconds);
+        x[dog] = position.x;
+        y[dog] = position.y;
+        // Движение с прежней скоростью клиенты вычисляют сами, поэтому изменением
+        // считается только остановка
+        if (stopped) {
+            speed_x[dog] = 0.0;
+            speed_y[dog] = 0.0;
+            MarkChanged(dog);
+        }
+    }
+    ++tick_count_;
+}
+
+std::vector<size_t> GameSession::TakeChangedDogs() {
+    std::vector<size_t> changed;
+    changed.reserve(dogs_.Size());
+    changed.swap(changed_dogs_);
+    for (const size_t dog : changed) {
+        is_changed_[dog] = false;
+    }
+    return changed;
+}
+
+}  // namespace model
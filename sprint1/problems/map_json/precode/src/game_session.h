@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "geom.h"
+#include "model.h"
+
+namespace model {
+
+/*
+ * Состояния собак игровой сессии, хранящиеся в виде структуры массивов.
+ * i-я собака сессии описывается i-ми элементами всех массивов. Координаты и скорости
+ * лежат в памяти подряд, поэтому за один тик они обходятся последовательно.
+ */
+struct DogStates {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> speed_x;
+    std::vector<double> speed_y;
+    std::vector<Direction> direction;
+
+    size_t Size() const noexcept {
+        return x.size();
+    }
+
+    geom::Point2D GetPosition(size_t dog) const noexcept {
+        return {x[dog], y[dog]};
+    }
+
+    geom::Vec2D GetSpeed(size_t dog) const noexcept {
+        return {speed_x[dog], speed_y[dog]};
+    }
+};
+
+/*
+ * Игровая сессия на одной карте.
+ * Класс не потокобезопасен: все обращения к сессии, включая тики, должны выполняться
+ * последовательно, например, через strand, выделенный сессии планировщиком тиков.
+ */
+class GameSession {
+public:
+    using TimeInterval = std::chrono::milliseconds;
+
+    explicit GameSession(const Map& map) noexcept
+        : map_{map} {
+    }
+
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    const Map& GetMap() const noexcept {
+        return map_;
+    }
+
+    const DogStates& GetDogs() const noexcept {
+        return dogs_;
+    }
+
+    // Добавляет неподвижную собаку в точку position и возвращает её номер в сессии
+    size_t AddDog(geom::Point2D position);
+
+    // Задаёт собаке направление и величину скорости. Нулевая скорость останавливает собаку,
+    // сохраняя её направление
+    void SetDogAction(size_t dog, Direction direction, double speed);
+
+    // Перемещает всех собак сессии за время delta. Собака, упёршаяся в границу дороги,
+    // останавливается
+    void Tick(TimeInterval delta);
+
+    // Количество выполненных тиков
+    std::uint64_t GetTickCount() const noexcept {
+        return tick_count_;
+    }
+
+    // Продолжает счёт тиков с tick_count. Используется при восстановлении сессии из снимка
+    void SetTickCount(std::uint64_t tick_count) noexcept {
+        tick_count_ = tick_count;
+    }
+
+    // Возвращает номера собак, состояние которых изменилось после предыдущего вызова:
+    // добавленных, получивших новое действие или остановившихся за тик у края дороги.
+    // Каждая собака встречается в списке один раз
+    std::vector<size_t> TakeChangedDogs();
+
+private:
+    void MarkChanged(size_t dog) {
+        if (!is_changed_[dog]) {
+            changed_dogs_.push_back(dog);
+            is_changed_[dog] = true;
+        }
+    }
+
+    const Map& map_;
+    DogStates dogs_;
+    std::uint64_t tick_count_ = 0;
+    std::vector<size_t> changed_dogs_;
+    std::vector<bool> is_changed_;
+};
+
+}  // namespace model
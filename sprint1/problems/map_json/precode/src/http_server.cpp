@@ -1,7 +1,470 @@
 #include "http_server.h"
 
+#include <boost/asio/dispatch.hpp>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace http_server {
 
-// Разместите здесь реализацию http-сервера, взяв её из задания по разработке асинхронного сервера
+using namespace std::literals;
+
+namespace {
+
+class CountingMemoryResource final : public std::pmr::memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        auto& stats = GetSessionStats();
+        stats.upstream_allocations.fetch_add(1, std::memory_order_relaxed);
+        stats.upstream_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Закрепляет текущий поток за ядром процессора с номером cpu.
+// На платформах, где это не поддерживается, ничего не делает
+void PinCurrentThread(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        std::cerr << "Failed to pin thread to CPU "sv << cpu << std::endl;
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+}  // namespace
+
+void ReportError(beast::error_code ec, std::string_view what) {
+    std::cerr << what << ": "sv << ec.message() << std::endl;
+}
+
+SessionStats& GetSessionStats() noexcept {
+    static SessionStats stats;
+    return stats;
+}
+
+std::pmr::memory_resource* GetCountingMemoryResource() noexcept {
+    static CountingMemoryResource resource;
+    return &resource;
+}
+
+ListeningSocket OpenListeningSocket(const tcp::endpoint& endpoint) {
+    net::io_context ioc;
+    tcp::acceptor acceptor{ioc};
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(net::socket_base::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen(net::socket_base::max_listen_connections);
+    return {endpoint.protocol(), acceptor.release()};
+}
+
+void EnableReusePort(tcp::acceptor& acceptor) {
+#ifdef SO_REUSEPORT
+    using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor.set_option(reuse_port(true));
+#else
+    (void)acceptor;
+    throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+}
+
+IoContextShards::IoContextShards(unsigned num_shards) {
+    num_shards = std::max(1u, num_shards);
+    shards_.reserve(num_shards);
+    for (unsigned i = 0; i < num_shards; ++i) {
+        // Подсказка 1 сообщает io_context, что его будет обслуживать единственный поток
+        shards_.emplace_back(std::make_unique<net::io_context>(1));
+    }
+}
+
+void IoContextShards::Run() {
+    const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::jthread> workers;
+    workers.reserve(shards_.size() - 1);
+    for (std::size_t i = 1; i < shards_.size(); ++i) {
+        workers.emplace_back([this, i, num_cpus] {
+            PinCurrentThread(static_cast<unsigned>(i % num_cpus));
+            shards_[i]->run();
+        });
+    }
+    PinCurrentThread(0);
+    shards_.front()->run();
+}
+
+void IoContextShards::Stop() {
+    for (auto& shard : shards_) {
+        shard->stop();
+    }
+}
+
+SessionBase::PipelineSlot::PipelineSlot(std::size_t arena_size)
+    : initial_block{std::make_unique<std::byte[]>(arena_size)}
+    , arena{initial_block.get(), arena_size, GetCountingMemoryResource()} {
+}
+
+SessionBase::SessionBase(tcp::socket&& socket, const SessionOptions& options)
+    : stream_(std::move(socket))
+    , buffer_(ArenaAllocator<char>{GetCountingMemoryResource()})
+    , timeout_(options.timeout)
+    , drain_(options.drain)
+    , admission_control_(options.admission_control)
+    , connection_slot_(options.admission_control) {
+    beast::error_code ec;
+    client_address_ = stream_.socket().remote_endpoint(ec).address();
+    buffer_.reserve(options.read_buffer_size);
+    const std::size_t num_slots = std::max<std::size_t>(1, options.max_pipelined_requests);
+    slots_.reserve(num_slots);
+    for (std::size_t i = 0; i < num_slots; ++i) {
+        slots_.emplace_back(std::make_unique<PipelineSlot>(options.arena_size));
+    }
+    GetSessionStats().sessions_created.fetch_add(1, std::memory_order_relaxed);
+}
+
+SessionBase::~SessionBase() {
+    if (drain_) {
+        drain_->RemoveSession(this);
+    }
+}
+
+void SessionBase::Run() {
+    if (drain_) {
+        drain_->AddSession(GetSharedThis());
+    }
+    // Вызываем метод Read, используя executor объекта stream_.
+    // Таким образом вся работа со stream_ будет выполняться, используя его executor
+    net::dispatch(stream_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
+}
+
+void SessionBase::Read() {
+    // Следующий запрос читается, только пока есть свободный слот конвейера.
+    // Иначе чтение возобновится после отправки самого старого ответа
+    if (reading_ || read_closed_ || closed_ || in_flight_ == slots_.size()) {
+        return;
+    }
+
+    PipelineSlot& slot = *slots_[(head_ + in_flight_) % slots_.size()];
+    const ArenaAllocator<char> alloc{&slot.arena};
+    slot.parser.emplace(Request::header_type{alloc}, alloc);
+
+    reading_ = true;
+    stream_.expires_after(timeout_);
+    // Считываем заголовок запроса из stream_, используя buffer_ для хранения считанных данных
+    http::async_read_header(stream_, buffer_, *slot.parser,
+                            // По окончании операции будет вызван метод OnReadHeader
+                            beast::bind_front_handler(&SessionBase::OnReadHeader,
+                                                      GetSharedThis()));
+}
+
+void SessionBase::OnReadHeader(beast::error_code ec, std::size_t bytes_read) {
+    if (ec) {
+        return OnRead(ec, bytes_read);
+    }
+    const std::size_t slot_index = (head_ + in_flight_) % slots_.size();
+    PipelineSlot& slot = *slots_[slot_index];
+
+    if (admission_control_) {
+        const auto retry_after = admission_control_->AdmitRequest(
+            client_address_, slot.parser->get()[http::field::authorization]);
+        if (retry_after) {
+            const auto content_length = slot.parser->content_length();
+            if (slot.parser->is_done() || !content_length
+                || *content_length > MAX_SKIPPED_BODY_SIZE) {
+                reading_ = false;
+                return Reject(slot_index, *retry_after);
+            }
+            // Отказ отправится, когда тело будет прочитано
+            slot.retry_after = *retry_after;
+        }
+    }
+
+    if (slot.parser->is_done()) {
+        // У запроса нет тела
+        return OnRead(ec, bytes_read);
+    }
+    http::async_read(stream_, buffer_, *slot.parser,
+                     beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+}
+
+void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    reading_ = false;
+    const std::size_t slot_index = (head_ + in_flight_) % slots_.size();
+
+    if (ec) {
+        // После любой ошибки чтения соединение больше не читается, иначе OnWrite
+        // возобновил бы чтение из неисправного сокета.
+        // end_of_stream - нормальная ситуация: клиент закрыл соединение.
+        // Ответы на уже прочитанные запросы всё равно отправляются
+        read_closed_ = true;
+        slots_[slot_index]->parser.reset();
+        slots_[slot_index]->retry_after.reset();
+        if (ec != http::error::end_of_stream) {
+            ReportError(ec, "read"sv);
+        }
+        if (in_flight_ == 0) {
+            Close();
+        }
+        return;
+    }
+
+    PipelineSlot& slot = *slots_[slot_index];
+    if (slot.retry_after) {
+        // Тело отклонённого запроса прочитано, и соединение можно не закрывать
+        const auto retry_after = *slot.retry_after;
+        slot.retry_after.reset();
+        return Reject(slot_index, retry_after);
+    }
+
+    auto& stats = GetSessionStats();
+    stats.requests_read.fetch_add(1, std::memory_order_relaxed);
+    if (in_flight_ > 0) {
+        stats.pipelined_requests.fetch_add(1, std::memory_order_relaxed);
+    }
+    ++in_flight_;
+
+    slot.request.emplace(slot.parser->release());
+    slot.parser.reset();
+    if (!slot.request->keep_alive()) {
+        read_closed_ = true;
+    }
+    if (beast::websocket::is_upgrade(*slot.request)) {
+        // После запроса на обновление протокола по соединению пойдут кадры WebSocket,
+        // а не HTTP-запросы. Если обработчик откажет в обновлении, соединение будет закрыто
+        read_closed_ = true;
+        slot.upgrade_request.emplace(*slot.request);
+    }
+    HandleRequest(std::move(*slot.request), slot_index);
+
+    // Читаем следующий запрос, не дожидаясь отправки ответа на текущий
+    Read();
+}
+
+void SessionBase::Reject(std::size_t slot_index, std::chrono::seconds retry_after) {
+    PipelineSlot& slot = *slots_[slot_index];
+    const auto& header = slot.parser->get();
+    // Непрочитанное тело было бы разобрано как следующий запрос, поэтому соединение
+    // с таким запросом закрывается после ответа, а новые запросы из него не читаются
+    const bool keep_alive = header.keep_alive() && slot.parser->is_done();
+
+    http::response<http::empty_body> response{http::status::service_unavailable,
+                                              header.version()};
+    response.set(http::field::retry_after, std::to_string(retry_after.count()));
+    response.content_length(0);
+    response.keep_alive(keep_alive);
+    slot.parser.reset();
+
+    auto& stats = GetSessionStats();
+    stats.requests_read.fetch_add(1, std::memory_order_relaxed);
+    stats.rejected_requests.fetch_add(1, std::memory_order_relaxed);
+    if (in_flight_ > 0) {
+        stats.pipelined_requests.fetch_add(1, std::memory_order_relaxed);
+    }
+    ++in_flight_;
+    if (!keep_alive) {
+        read_closed_ = true;
+    }
+
+    Write(slot_index, std::move(response));
+    Read();
+}
+
+void SessionBase::Write(std::size_t slot_index, WebSocketUpgrade&& upgrade) {
+    PipelineSlot& slot = *slots_[slot_index];
+    slot.upgrade = std::move(upgrade.accept);
+    slot.write = [](SessionBase& session, PipelineSlot& s) {
+        session.Upgrade(s);
+    };
+
+    net::dispatch(stream_.get_executor(), [self = GetSharedThis(), slot_index] {
+        self->OnResponseReady(slot_index);
+    });
+}
+
+void SessionBase::OnResponseReady(std::size_t slot_index) {
+    if (closed_) {
+        return;
+    }
+    slots_[slot_index]->response_ready = true;
+    WriteNextResponse();
+}
+
+void SessionBase::WriteNextResponse() {
+    if (writing_ || in_flight_ == 0) {
+        return;
+    }
+    PipelineSlot& slot = *slots_[head_];
+    if (!slot.response_ready) {
+        // Ответ на самый старый запрос ещё не готов. Более новые ответы ждут своей очереди
+        return;
+    }
+    writing_ = true;
+    slot.write(*this, slot);
+}
+
+void SessionBase::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
+
+    PipelineSlot& slot = *slots_[head_];
+    const bool close = slot.close_after_write;
+    // Освобождаем ответ и запрос до сброса арены, в которой они размещены
+    slot.response.reset();
+    slot.request.reset();
+    slot.upgrade_request.reset();
+    slot.write = nullptr;
+    slot.response_ready = false;
+    slot.close_after_write = false;
+    slot.arena.release();
+    head_ = (head_ + 1) % slots_.size();
+    --in_flight_;
+
+    if (ec) {
+        closed_ = true;
+        return ReportError(ec, "write"sv);
+    }
+    GetSessionStats().responses_written.fetch_add(1, std::memory_order_relaxed);
+
+    if (close) {
+        // Семантика ответа требует закрыть соединение
+        return Close();
+    }
+
+    WriteNextResponse();
+    if (read_closed_ && in_flight_ == 0) {
+        return Close();
+    }
+    Read();
+}
+
+void SessionBase::Upgrade(PipelineSlot& slot) {
+    // Ответы на все предыдущие запросы отправлены, а новые запросы не читаются,
+    // поэтому с потоком не выполняется ни одной операции, и его можно передать
+    closed_ = true;
+    GetSessionStats().websocket_upgrades.fetch_add(1, std::memory_order_relaxed);
+    const auto accept = std::move(slot.upgrade);
+    accept(std::move(stream_), *slot.upgrade_request, std::move(connection_slot_));
+}
+
+void SessionBase::Drain() {
+    net::dispatch(stream_.get_executor(), [self = GetSharedThis()] {
+        self->read_closed_ = true;
+        if (self->closed_) {
+            return;
+        }
+        if (self->reading_) {
+            // Ожидающее чтение завершится с end_of_stream, и сессия закроется так же,
+            // как при закрытии соединения клиентом
+            beast::error_code ec;
+            self->stream_.socket().shutdown(tcp::socket::shutdown_receive, ec);
+        } else if (self->in_flight_ == 0) {
+            self->Close();
+        }
+    });
+}
+
+void SessionBase::Close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+void ServerDrain::Start(Callback on_drained) {
+    std::vector<Callback> listeners;
+    std::vector<std::shared_ptr<SessionBase>> sessions;
+    Callback drained;
+    {
+        std::lock_guard lock{mutex_};
+        if (draining_) {
+            return;
+        }
+        draining_.store(true, std::memory_order_release);
+        listeners.swap(listeners_);
+        sessions.reserve(sessions_.size());
+        for (const auto& [ptr, weak_session] : sessions_) {
+            if (auto session = weak_session.lock()) {
+                sessions.push_back(std::move(session));
+            }
+        }
+        if (sessions_.empty()) {
+            drained = std::move(on_drained);
+        } else {
+            on_drained_ = std::move(on_drained);
+        }
+    }
+
+    // Обработчики вызываются без блокировки: сессия может быть удалена прямо здесь,
+    // когда будет освобождён последний указатель на неё
+    for (const auto& stop_accepting : listeners) {
+        stop_accepting();
+    }
+    for (const auto& session : sessions) {
+        session->Drain();
+    }
+    if (drained) {
+        drained();
+    }
+}
+
+std::size_t ServerDrain::GetSessionCount() const {
+    std::lock_guard lock{mutex_};
+    return sessions_.size();
+}
+
+void ServerDrain::AddListener(Callback stop_accepting) {
+    {
+        std::lock_guard lock{mutex_};
+        if (!draining_) {
+            listeners_.push_back(std::move(stop_accepting));
+            return;
+        }
+    }
+    stop_accepting();
+}
+
+void ServerDrain::AddSession(const std::shared_ptr<SessionBase>& session) {
+    {
+        std::lock_guard lock{mutex_};
+        sessions_.emplace(session.get(), session);
+        if (!draining_) {
+            return;
+        }
+    }
+    // Соединение принято одновременно с началом завершения
+    session->Drain();
+}
+
+void ServerDrain::RemoveSession(const SessionBase* session) {
+    Callback drained;
+    {
+        std::lock_guard lock{mutex_};
+        sessions_.erase(session);
+        if (draining_ && sessions_.empty()) {
+            drained = std::move(on_drained_);
+            on_drained_ = nullptr;
+        }
+    }
+    if (drained) {
+        drained();
+    }
+}
 
 }  // namespace http_server
@@ -1,13 +1,530 @@
 #pragma once
 #include "sdk.h"
-//
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket/rfc6455.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "admission_control.h"
 
 namespace http_server {
 
-// Разместите здесь реализацию http-сервера, взяв её из задания по разработке асинхронного сервера
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace sys = boost::system;
+
+void ReportError(beast::error_code ec, std::string_view what);
+
+// Счётчики, общие для всех сессий сервера.
+// upstream_allocations учитывает только обращения к куче арен и буфера чтения сессий:
+// если в установившемся режиме requests_read растёт, а upstream_allocations нет, запросам
+// и ответам хватает начальных блоков арен. Память, которую выделяют обработчики запросов
+// и сама Asio, здесь не учитывается
+struct SessionStats {
+    std::atomic<std::uint64_t> sessions_created{0};
+    std::atomic<std::uint64_t> requests_read{0};
+    std::atomic<std::uint64_t> responses_written{0};
+    // Запросы, прочитанные в то время, пока ответ на предыдущий запрос ещё не был отправлен
+    std::atomic<std::uint64_t> pipelined_requests{0};
+    // Соединения, закрытые сразу после принятия из-за превышения лимита соединений
+    std::atomic<std::uint64_t> rejected_connections{0};
+    // Запросы, на которые ответ 503 отправлен без обработки. Тело такого запроса
+    // не читается или, если оно небольшое, читается и отбрасывается
+    std::atomic<std::uint64_t> rejected_requests{0};
+    // Соединения, переданные обработчику WebSocket
+    std::atomic<std::uint64_t> websocket_upgrades{0};
+    // Обращения арен и буфера чтения к куче (арене не хватило начального блока)
+    std::atomic<std::uint64_t> upstream_allocations{0};
+    std::atomic<std::uint64_t> upstream_allocated_bytes{0};
+};
+
+SessionStats& GetSessionStats() noexcept;
+
+// Источник памяти, который выделяет память в куче и учитывает каждое выделение в SessionStats
+std::pmr::memory_resource* GetCountingMemoryResource() noexcept;
+
+class SessionBase;
+
+/*
+ * Плавное завершение работы сервера.
+ * После вызова Start Listener-ы перестают принимать соединения, а сессии дописывают
+ * ответы на уже прочитанные запросы и закрывают соединения, не читая новых запросов.
+ * Один объект разделяется всеми Listener-ами и сессиями сервера.
+ */
+class ServerDrain {
+public:
+    using Callback = std::function<void()>;
+
+    ServerDrain() = default;
+
+    ServerDrain(const ServerDrain&) = delete;
+    ServerDrain& operator=(const ServerDrain&) = delete;
+
+    // Начинает завершение. on_drained будет вызван однократно, в произвольном потоке,
+    // когда закроется последняя сессия
+    void Start(Callback on_drained);
+
+    bool IsDraining() const noexcept {
+        return draining_.load(std::memory_order_acquire);
+    }
+
+    std::size_t GetSessionCount() const;
+
+    // Регистрирует действие, прекращающее приём соединений Listener-ом
+    void AddListener(Callback stop_accepting);
+    void AddSession(const std::shared_ptr<SessionBase>& session);
+    void RemoveSession(const SessionBase* session);
+
+private:
+    mutable std::mutex mutex_;
+    std::atomic<bool> draining_{false};
+    std::vector<Callback> listeners_;
+    std::unordered_map<const SessionBase*, std::weak_ptr<SessionBase>> sessions_;
+    Callback on_drained_;
+};
+
+struct SessionOptions {
+    // Сколько запросов одного соединения могут одновременно находиться в обработке.
+    // При значении 1 сессия работает как классический keep-alive без конвейеризации
+    std::size_t max_pipelined_requests = 4;
+    // Размер начального блока арены, в которой размещаются запрос и ответ
+    std::size_t arena_size = 8 * 1024;
+    // Начальная ёмкость буфера чтения
+    std::size_t read_buffer_size = 8 * 1024;
+    std::chrono::steady_clock::duration timeout = std::chrono::seconds{30};
+    // Если задан, сессии и Listener-ы завершают работу по команде ServerDrain::Start
+    std::shared_ptr<ServerDrain> drain;
+    // Ограничения на соединения и частоту запросов, общие для всех сессий сервера.
+    // Если не заданы, сервер принимает все соединения и запросы
+    std::shared_ptr<AdmissionControl> admission_control;
+};
+
+// Аллокатор, выделяющий память из memory_resource.
+// В отличие от std::pmr::polymorphic_allocator допускает присваивание, которого требует
+// http::basic_fields
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(std::pmr::memory_resource* resource) noexcept
+        : resource_{resource} {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : resource_{other.GetResource()} {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    std::pmr::memory_resource* GetResource() const noexcept {
+        return resource_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return resource_ == other.GetResource();
+    }
+
+private:
+    std::pmr::memory_resource* resource_;
+};
+
+using RequestBody = http::basic_string_body<char, std::char_traits<char>, ArenaAllocator<char>>;
+using RequestFields = http::basic_fields<ArenaAllocator<char>>;
+// Запрос, заголовки и тело которого размещаются в арене сессии.
+// Память запроса действительна до тех пор, пока на него не будет отправлен ответ
+using Request = http::request<RequestBody, RequestFields>;
+using RequestParser = http::request_parser<RequestBody, ArenaAllocator<char>>;
+
+// Ответ обработчика запросов, переводящий соединение на протокол WebSocket.
+// Когда ответы на все предыдущие запросы соединения будут отправлены, сессия прекратит
+// работу с потоком и передаст его, запрос на обновление протокола и место соединения
+// функции accept. Место освобождается, когда его владелец закроет поток.
+// Запрос размещён в арене сессии и действителен только до возврата из accept
+struct WebSocketUpgrade {
+    std::function<void(beast::tcp_stream&& stream, Request& request, ConnectionSlot&& slot)>
+        accept;
+};
+
+class SessionBase {
+public:
+    SessionBase(const SessionBase&) = delete;
+    SessionBase& operator=(const SessionBase&) = delete;
+
+    void Run();
+
+    // Прекращает чтение новых запросов. Соединение закрывается после отправки ответов
+    // на уже прочитанные запросы. Метод можно вызывать из любого потока
+    void Drain();
+
+protected:
+    SessionBase(tcp::socket&& socket, const SessionOptions& options);
+
+    ~SessionBase();
+
+    // Отправляет ответ на запрос, прочитанный в слот slot_index.
+    // Ответы отправляются строго в порядке поступления запросов.
+    // Метод можно вызывать из любого потока
+    template <typename Body, typename Fields>
+    void Write(std::size_t slot_index, http::response<Body, Fields>&& response) {
+        using Response = http::response<Body, Fields>;
+
+        PipelineSlot& slot = *slots_[slot_index];
+        slot.close_after_write = response.need_eof();
+        // Ответ размещается в арене слота, поэтому не требует обращения к куче
+        slot.response = std::allocate_shared<Response>(
+            ArenaAllocator<Response>{&slot.arena}, std::move(response));
+        slot.write = [](SessionBase& session, PipelineSlot& s) {
+            http::async_write(session.stream_, *static_cast<Response*>(s.response.get()),
+                              [self = session.GetSharedThis()](beast::error_code ec,
+                                                               std::size_t bytes_written) {
+                                  self->OnWrite(ec, bytes_written);
+                              });
+        };
+
+        net::dispatch(stream_.get_executor(), [self = GetSharedThis(), slot_index] {
+            self->OnResponseReady(slot_index);
+        });
+    }
+
+    // Передаёт соединение обработчику WebSocket вместо ответа на запрос из слота slot_index.
+    // Метод можно вызывать из любого потока
+    void Write(std::size_t slot_index, WebSocketUpgrade&& upgrade);
+
+private:
+    // Слот конвейера. Хранит запрос, ответ на него и арену, в которой они размещены.
+    // Слоты создаются один раз при создании сессии и переиспользуются для всех запросов
+    struct PipelineSlot {
+        explicit PipelineSlot(std::size_t arena_size);
+
+        std::unique_ptr<std::byte[]> initial_block;
+        std::pmr::monotonic_buffer_resource arena;
+        // Заголовок запроса читается отдельно от тела, чтобы отклонить запрос до чтения тела
+        std::optional<RequestParser> parser;
+        std::optional<Request> request;
+        // Копия запроса на обновление протокола. Запрос request передаётся обработчику
+        // HTTP, а копия остаётся в слоте до передачи соединения обработчику WebSocket
+        std::optional<Request> upgrade_request;
+        // Задан, если запрос отклонён, но его тело дочитывается, чтобы пропустить его
+        std::optional<std::chrono::seconds> retry_after;
+        std::shared_ptr<void> response;
+        void (*write)(SessionBase& session, PipelineSlot& slot) = nullptr;
+        decltype(WebSocketUpgrade::accept) upgrade;
+        bool response_ready = false;
+        bool close_after_write = false;
+    };
+
+    // Тело отклонённого запроса не больше этого размера дочитывается и отбрасывается,
+    // чтобы соединение осталось открытым. Тело большего размера не читается, и соединение
+    // закрывается после ответа
+    constexpr static std::uint64_t MAX_SKIPPED_BODY_SIZE = 4 * 1024;
+
+    void Read();
+    void OnReadHeader(beast::error_code ec, std::size_t bytes_read);
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void Reject(std::size_t slot_index, std::chrono::seconds retry_after);
+    void OnResponseReady(std::size_t slot_index);
+    void WriteNextResponse();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+    void Upgrade(PipelineSlot& slot);
+    void Close();
+
+    virtual void HandleRequest(Request&& request, std::size_t slot_index) = 0;
+    virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
+
+    beast::tcp_stream stream_;
+    beast::basic_flat_buffer<ArenaAllocator<char>> buffer_;
+    std::chrono::steady_clock::duration timeout_;
+    std::shared_ptr<ServerDrain> drain_;
+    std::shared_ptr<AdmissionControl> admission_control_;
+    // Место соединения занято Listener-ом при его принятии
+    ConnectionSlot connection_slot_;
+    net::ip::address client_address_;
+
+    std::vector<std::unique_ptr<PipelineSlot>> slots_;
+    // Слот самого старого запроса, ответ на который ещё не отправлен
+    std::size_t head_ = 0;
+    // Количество запросов, которые прочитаны, но ответ на которые ещё не отправлен
+    std::size_t in_flight_ = 0;
+    bool reading_ = false;
+    bool writing_ = false;
+    // Клиент закрыл соединение или попросил закрыть его после ответа
+    bool read_closed_ = false;
+    bool closed_ = false;
+};
+
+template <typename RequestHandler>
+class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
+public:
+    template <typename Handler>
+    Session(tcp::socket&& socket, const SessionOptions& options, Handler&& request_handler)
+        : SessionBase(std::move(socket), options)
+        , request_handler_(std::forward<Handler>(request_handler)) {
+    }
+
+private:
+    void HandleRequest(Request&& request, std::size_t slot_index) override {
+        // Захват умного указателя на текущий объект Session в лямбде
+        // не даёт сессии исчезнуть до завершения асинхронной операции
+        request_handler_(std::move(request),
+                         [self = this->shared_from_this(), slot_index](auto&& response) {
+                             self->Write(slot_index, std::move(response));
+                         });
+    }
+
+    std::shared_ptr<SessionBase> GetSharedThis() override {
+        return this->shared_from_this();
+    }
+
+    RequestHandler request_handler_;
+};
+
+// Способ, которым Listener распределяет принятые соединения между потоками
+enum class ListenerMode {
+    // io_context обслуживают несколько потоков, каждое соединение получает собственный strand
+    SHARED,
+    // io_context обслуживает ровно один поток (шард). Несколько Listener-ов разных шардов
+    // слушают один и тот же порт благодаря SO_REUSEPORT, и ядро само распределяет между ними
+    // соединения. Соединение живёт на своём шарде до закрытия, поэтому strand не нужен
+    SHARD,
+};
+
+// Слушающий сокет, открытый вне Listener-а, например полученный от другого процесса
+struct ListeningSocket {
+    tcp protocol;
+    tcp::acceptor::native_handle_type handle;
+};
+
+// Открывает сокет, слушающий endpoint. Сокет принадлежит вызывающему до передачи Listener-у
+ListeningSocket OpenListeningSocket(const tcp::endpoint& endpoint);
+
+// Включает SO_REUSEPORT на сокете acceptor-а.
+// Бросает исключение, если платформа не поддерживает эту опцию
+void EnableReusePort(tcp::acceptor& acceptor);
+
+// Набор io_context, каждый из которых обслуживается единственным потоком,
+// закреплённым за своим ядром процессора
+class IoContextShards {
+public:
+    explicit IoContextShards(unsigned num_shards);
+
+    IoContextShards(const IoContextShards&) = delete;
+    IoContextShards& operator=(const IoContextShards&) = delete;
+
+    std::size_t Size() const noexcept {
+        return shards_.size();
+    }
+
+    net::io_context& GetShard(std::size_t index) noexcept {
+        return *shards_[index];
+    }
+
+    // Запускает обработку всех шардов: шард 0 обслуживается текущим потоком,
+    // остальные - дополнительными. Возвращает управление, когда все шарды остановлены
+    void Run();
+
+    // Останавливает все шарды. Метод можно вызывать из любого потока
+    void Stop();
+
+private:
+    std::vector<std::unique_ptr<net::io_context>> shards_;
+};
+
+template <typename RequestHandler>
+class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
+public:
+    template <typename Handler>
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+             SessionOptions options = {}, ListenerMode mode = ListenerMode::SHARED)
+        : ioc_(ioc)
+        // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
+        , acceptor_(net::make_strand(ioc))
+        , request_handler_(std::forward<Handler>(request_handler))
+        , options_(options)
+        , mode_(mode) {
+        // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
+        acceptor_.open(endpoint.protocol());
+
+        // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
+        // чтобы компьютеры могли обменяться завершающими пакетами данных.
+        // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
+        // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (mode_ == ListenerMode::SHARD) {
+            EnableReusePort(acceptor_);
+        }
+        // Привязываем acceptor к адресу и порту endpoint
+        acceptor_.bind(endpoint);
+        // Переводим acceptor в состояние, в котором он способен принимать новые соединения
+        // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
+        acceptor_.listen(net::socket_base::max_listen_connections);
+    }
+
+    // Принимает соединения на заранее открытом слушающем сокете, становясь его владельцем
+    template <typename Handler>
+    Listener(net::io_context& ioc, ListeningSocket socket, Handler&& request_handler,
+             SessionOptions options = {})
+        : ioc_(ioc)
+        , acceptor_(net::make_strand(ioc))
+        , request_handler_(std::forward<Handler>(request_handler))
+        , options_(options)
+        , mode_(ListenerMode::SHARED) {
+        acceptor_.assign(socket.protocol, socket.handle);
+    }
+
+    void Run() {
+        if (options_.drain) {
+            options_.drain->AddListener([weak_self = this->weak_from_this()] {
+                if (auto self = weak_self.lock()) {
+                    self->Stop();
+                }
+            });
+        }
+        DoAccept();
+    }
+
+    // Прекращает приём соединений. Метод можно вызывать из любого потока
+    void Stop() {
+        net::dispatch(acceptor_.get_executor(), [self = this->shared_from_this()] {
+            sys::error_code ec;
+            self->acceptor_.close(ec);
+        });
+    }
+
+private:
+    void DoAccept() {
+        if (mode_ == ListenerMode::SHARD) {
+            // Шард обслуживается одним потоком, поэтому сокет использует executor io_context
+            // напрямую, без накладных расходов на strand
+            acceptor_.async_accept(
+                ioc_.get_executor(),
+                beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this()));
+            return;
+        }
+        acceptor_.async_accept(
+            // Передаём последовательный исполнитель, в котором будут вызываться обработчики
+            // асинхронных операций сокета
+            net::make_strand(ioc_),
+            // С помощью bind_front_handler создаём обработчик, привязанный к методу OnAccept
+            // текущего объекта.
+            // Так как Listener — шаблонный класс, нужно подсказать компилятору, что
+            // shared_from_this — метод класса, а не свободная функция.
+            // Для этого вызываем его, используя this
+            // Этот вызов bind_front_handler аналогичен
+            // namespace ph = std::placeholders;
+            // std::bind(&Listener::OnAccept, this->shared_from_this(), ph::_1, ph::_2)
+            beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this()));
+    }
+
+    // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
+    void OnAccept(sys::error_code ec, tcp::socket socket) {
+        using namespace std::literals;
+
+        if (ec) {
+            if (!acceptor_.is_open()) {
+                // Listener остановлен
+                return;
+            }
+            return ReportError(ec, "accept"sv);
+        }
+
+        if (options_.admission_control && !options_.admission_control->TryAcquireConnection()) {
+            // Сверх лимита соединение закрывается, даже не прочитав запрос
+            RejectConnection(std::move(socket));
+            return DoAccept();
+        }
+
+        // Асинхронно обрабатываем сессию
+        AsyncRunSession(std::move(socket));
+
+        // Принимаем новое соединение
+        DoAccept();
+    }
+
+    void RejectConnection(tcp::socket&& socket) {
+        GetSessionStats().rejected_connections.fetch_add(1, std::memory_order_relaxed);
+        auto rejected = std::make_shared<tcp::socket>(std::move(socket));
+        net::async_write(*rejected,
+                         net::buffer(options_.admission_control->GetConnectionRejectResponse()),
+                         [rejected](sys::error_code, std::size_t) {
+                             sys::error_code ec;
+                             rejected->shutdown(tcp::socket::shutdown_send, ec);
+                         });
+    }
+
+    void AsyncRunSession(tcp::socket&& socket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), options_, request_handler_)
+            ->Run();
+    }
+
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    RequestHandler request_handler_;
+    SessionOptions options_;
+    ListenerMode mode_;
+};
+
+template <typename RequestHandler>
+void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler,
+               SessionOptions options = {}) {
+    // При помощи decay_t исключим ссылки из типа RequestHandler,
+    // чтобы Listener хранил RequestHandler по значению
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), options)
+        ->Run();
+}
+
+template <typename RequestHandler>
+void ServeHttp(net::io_context& ioc, ListeningSocket socket, RequestHandler&& handler,
+               SessionOptions options = {}) {
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+    std::make_shared<MyListener>(ioc, socket, std::forward<RequestHandler>(handler), options)
+        ->Run();
+}
+
+// Запускает на каждом шарде собственный Listener, слушающий endpoint.
+// Каждый шард получает свою копию обработчика запросов
+template <typename RequestHandler>
+void ServeHttpSharded(IoContextShards& shards, const tcp::endpoint& endpoint,
+                      const RequestHandler& handler, SessionOptions options = {}) {
+    using MyListener = Listener<RequestHandler>;
+
+    for (std::size_t i = 0; i < shards.Size(); ++i) {
+        std::make_shared<MyListener>(shards.GetShard(i), endpoint, handler, options,
+                                     ListenerMode::SHARD)
+            ->Run();
+    }
+}
 
 }  // namespace http_server
@@ -0,0 +1,77 @@
+#include "interned_string.h"
+
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace util {
+
+// Пул строк. Записи хранятся в std::deque, поэтому их адреса не меняются
+// при добавлении новых строк, и объекты InternedString могут ссылаться на них
+// без блокировок
+class InternedString::Pool {
+public:
+    const Entry* Intern(std::string_view str) {
+        if (const Entry* entry = Find(str)) {
+            return entry;
+        }
+
+        std::lock_guard lock{mutex_};
+        // Пока блокировка была снята, строку мог добавить другой поток
+        if (const Entry* entry = FindLocked(str)) {
+            return entry;
+        }
+        if (entries_.size() == std::numeric_limits<Handle>::max()) {
+            throw std::length_error("Interned string pool is full");
+        }
+        const auto handle = static_cast<Handle>(entries_.size());
+        const Entry& entry = entries_.emplace_back(
+            Entry{std::string{str}, std::hash<std::string_view>{}(str), handle});
+        try {
+            index_.emplace(entry.str, &entry);
+        } catch (...) {
+            entries_.pop_back();
+            throw;
+        }
+        return &entry;
+    }
+
+    const Entry* Find(std::string_view str) const {
+        std::shared_lock lock{mutex_};
+        return FindLocked(str);
+    }
+
+private:
+    const Entry* FindLocked(std::string_view str) const {
+        if (auto it = index_.find(str); it != index_.end()) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::deque<Entry> entries_;
+    // Ключи ссылаются на строки в entries_
+    std::unordered_map<std::string_view, const Entry*> index_;
+};
+
+InternedString::Pool& InternedString::GetPool() {
+    static Pool pool;
+    return pool;
+}
+
+InternedString::InternedString(std::string_view str)
+    : entry_{GetPool().Intern(str)} {
+}
+
+std::optional<InternedString> InternedString::Find(std::string_view str) {
+    if (const Entry* entry = GetPool().Find(str)) {
+        return InternedString{entry};
+    }
+    return std::nullopt;
+}
+
+}  // namespace util
@@ -0,0 +1,82 @@
+#pragma once
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+/*
+ * Строка, хранящаяся в глобальном пуле в единственном экземпляре.
+ *
+ * Объект занимает размер указателя и ссылается на запись пула, в которой хранятся
+ * сама строка, её хеш (std::hash<std::string_view>), вычисленный один раз при
+ * добавлении, и порядковый номер строки в пуле. Поэтому копирование, сравнение
+ * на равенство и хеширование не обращаются к символам строки.
+ *
+ * Записи пула никогда не удаляются, поэтому пул предназначен для идентификаторов
+ * из конфигурации, а не для произвольных строк из запросов: чтобы найти строку
+ * из запроса, используйте Find, которая не добавляет строку в пул.
+ * Методы можно вызывать из разных потоков.
+ */
+class InternedString {
+public:
+    using Handle = std::uint32_t;
+
+    // Находит строку str в пуле или добавляет её туда
+    explicit InternedString(std::string_view str);
+
+    // Возвращает строку из пула, не добавляя её туда. Если строки в пуле нет,
+    // возвращает std::nullopt
+    static std::optional<InternedString> Find(std::string_view str);
+
+    std::string_view GetView() const noexcept {
+        return entry_->str;
+    }
+
+    size_t GetHash() const noexcept {
+        return entry_->hash;
+    }
+
+    // Порядковый номер строки в пуле. Одинаковые строки имеют одинаковый номер
+    Handle GetHandle() const noexcept {
+        return entry_->handle;
+    }
+
+    bool operator==(const InternedString& other) const noexcept {
+        return entry_ == other.entry_;
+    }
+
+    // Упорядочивает строки лексикографически, как std::string
+    std::strong_ordering operator<=>(const InternedString& other) const noexcept {
+        return GetView() <=> other.GetView();
+    }
+
+private:
+    struct Entry {
+        std::string str;
+        size_t hash;
+        Handle handle;
+    };
+
+    class Pool;
+
+    explicit InternedString(const Entry* entry) noexcept
+        : entry_{entry} {
+    }
+
+    static Pool& GetPool();
+
+    const Entry* entry_;
+};
+
+}  // namespace util
+
+template <>
+struct std::hash<util::InternedString> {
+    size_t operator()(const util::InternedString& str) const noexcept {
+        return str.GetHash();
+    }
+};
@@ -1,13 +1,611 @@
 #include "json_loader.h"
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/json.hpp>
+#include <boost/json/basic_parser_impl.hpp>
+#include <array>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "maps_splitter.h"
+
 namespace json_loader {
 
-model::Game LoadGame(const std::filesystem::path& json_path) {
+namespace json = boost::json;
+namespace bip = boost::interprocess;
+namespace net = boost::asio;
+using namespace std::literals;
+
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("Failed to open file "s + path.string());
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return std::move(content).str();
+}
+
+model::Coord GetCoord(const json::object& obj, std::string_view key) {
+    return static_cast<model::Coord>(obj.at(key).as_int64());
+}
+
+model::Road LoadRoad(const json::object& obj) {
+    const model::Point start{GetCoord(obj, "x0"sv), GetCoord(obj, "y0"sv)};
+    if (obj.contains("x1"sv)) {
+        return {model::Road::HORIZONTAL, start, GetCoord(obj, "x1"sv)};
+    }
+    return {model::Road::VERTICAL, start, GetCoord(obj, "y1"sv)};
+}
+
+model::Building LoadBuilding(const json::object& obj) {
+    return model::Building{{{GetCoord(obj, "x"sv), GetCoord(obj, "y"sv)},
+                            {GetCoord(obj, "w"sv), GetCoord(obj, "h"sv)}}};
+}
+
+model::Office LoadOffice(const json::object& obj) {
+    return {model::Office::Id{util::InternedString{json::value_to<std::string>(obj.at("id"sv))}},
+            {GetCoord(obj, "x"sv), GetCoord(obj, "y"sv)},
+            {GetCoord(obj, "offsetX"sv), GetCoord(obj, "offsetY"sv)}};
+}
+
+model::Map LoadMap(const json::object& obj) {
+    model::Map map{model::Map::Id{util::InternedString{json::value_to<std::string>(obj.at("id"sv))}},
+                   json::value_to<std::string>(obj.at("name"sv))};
+
+    for (const auto& road : obj.at("roads"sv).as_array()) {
+        map.AddRoad(LoadRoad(road.as_object()));
+    }
+    for (const auto& building : obj.at("buildings"sv).as_array()) {
+        map.AddBuilding(LoadBuilding(building.as_object()));
+    }
+    for (const auto& office : obj.at("offices"sv).as_array()) {
+        map.AddOffice(LoadOffice(office.as_object()));
+    }
+
+    return map;
+}
+
+// Данные карты, собранные парсером. Карта строится по ним отдельно от разбора файла
+struct MapData {
+    std::optional<std::string> id;
+    std::optional<std::string> name;
+    std::vector<model::Road> roads;
+    std::vector<model::Building> buildings;
+    std::vector<model::Office> offices;
+};
+
+// Строит карту и проверяет её содержимое, например, уникальность id офисов
+model::Map BuildMap(MapData data) {
+    model::Map map{model::Map::Id{util::InternedString{*data.id}}, std::move(*data.name)};
+    for (const auto& road : data.roads) {
+        map.AddRoad(road);
+    }
+    for (const auto& building : data.buildings) {
+        map.AddBuilding(building);
+    }
+    for (auto& office : data.offices) {
+        map.AddOffice(std::move(office));
+    }
+    return map;
+}
+
+// Получатель элементов массива maps, найденных ConfigHandler
+class MapSink {
+public:
+    // Элемент массива - объект карты, данные которой собрал парсер
+    virtual void AddMap(MapData data) = 0;
+    // Элемент массива - число index, которым SplitMaps заменила текст карты в скелете документа
+    virtual void AddMapChunk(std::int64_t index) = 0;
+
+protected:
+    ~MapSink() = default;
+};
+
+/*
+ * Обработчик событий потокового парсера boost::json::basic_parser.
+ * Отслеживает, в каком месте документа находится парсер, и собирает дороги, здания
+ * и офисы из значений их полей. Каждый элемент массива maps передаётся в sink.
+ * Если map_text равен true, разбираемый документ - текст одной карты, а не весь файл.
+ * Неизвестные ключи и их значения пропускаются.
+ */
+class ConfigHandler {
+public:
+    ConfigHandler(MapSink& sink, bool map_text)
+        : sink_{sink}
+        , root_{map_text ? Context::MAPS : Context::DOCUMENT} {
+    }
+
+    constexpr static std::size_t max_object_size = std::numeric_limits<std::size_t>::max();
+    constexpr static std::size_t max_array_size = std::numeric_limits<std::size_t>::max();
+    constexpr static std::size_t max_key_size = std::numeric_limits<std::size_t>::max();
+    constexpr static std::size_t max_string_size = std::numeric_limits<std::size_t>::max();
+
+    // Возвращает true, если в корневом объекте встретился массив maps
+    bool HasMaps() const noexcept {
+        return has_maps_;
+    }
+
+    bool on_document_begin(json::error_code&) {
+        return true;
+    }
+
+    bool on_document_end(json::error_code&) {
+        return true;
+    }
+
+    bool on_object_begin(json::error_code&) {
+        switch (Current()) {
+            case Context::DOCUMENT:
+                stack_.push_back(Context::ROOT);
+                break;
+            case Context::MAPS:
+                map_.emplace();
+                stack_.push_back(Context::MAP);
+                break;
+            case Context::ROADS:
+                BeginElement(Context::ROAD);
+                break;
+            case Context::BUILDINGS:
+                BeginElement(Context::BUILDING);
+                break;
+            case Context::OFFICES:
+                BeginElement(Context::OFFICE);
+                break;
+            default:
+                CheckNotMaps();
+                stack_.push_back(Context::SKIP);
+                break;
+        }
+        return true;
+    }
+
+    bool on_object_end(std::size_t, json::error_code&) {
+        const Context context = Current();
+        stack_.pop_back();
+        switch (context) {
+            case Context::MAP:
+                EndMap();
+                break;
+            case Context::ROAD:
+                map_->roads.push_back(MakeRoad());
+                break;
+            case Context::BUILDING:
+                map_->buildings.push_back(MakeBuilding());
+                break;
+            case Context::OFFICE:
+                map_->offices.push_back(MakeOffice());
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool on_array_begin(json::error_code&) {
+        const Context context = Current();
+        if (context == Context::ROOT && key_ == "maps"sv) {
+            has_maps_ = true;
+            stack_.push_back(Context::MAPS);
+        } else if (context == Context::MAP && key_ == "roads"sv) {
+            stack_.push_back(Context::ROADS);
+        } else if (context == Context::MAP && key_ == "buildings"sv) {
+            stack_.push_back(Context::BUILDINGS);
+        } else if (context == Context::MAP && key_ == "offices"sv) {
+            stack_.push_back(Context::OFFICES);
+        } else {
+            CheckNotInList();
+            stack_.push_back(Context::SKIP);
+        }
+        return true;
+    }
+
+    bool on_array_end(std::size_t, json::error_code&) {
+        stack_.pop_back();
+        return true;
+    }
+
+    bool on_key_part(json::string_view s, std::size_t, json::error_code&) {
+        key_part_.append(s.data(), s.size());
+        return true;
+    }
+
+    bool on_key(json::string_view s, std::size_t, json::error_code&) {
+        if (key_part_.empty()) {
+            key_.assign(s.data(), s.size());
+        } else {
+            key_part_.append(s.data(), s.size());
+            key_.swap(key_part_);
+            key_part_.clear();
+        }
+        return true;
+    }
+
+    bool on_string_part(json::string_view s, std::size_t, json::error_code&) {
+        string_.append(s.data(), s.size());
+        return true;
+    }
+
+    bool on_string(json::string_view s, std::size_t, json::error_code&) {
+        string_.append(s.data(), s.size());
+        OnString();
+        string_.clear();
+        return true;
+    }
+
+    bool on_number_part(json::string_view, json::error_code&) {
+        return true;
+    }
+
+    bool on_int64(std::int64_t value, json::string_view, json::error_code&) {
+        OnInteger(value);
+        return true;
+    }
+
+    bool on_uint64(std::uint64_t value, json::string_view, json::error_code&) {
+        if (value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            OnNonInteger();
+        } else {
+            OnInteger(static_cast<std::int64_t>(value));
+        }
+        return true;
+    }
+
+    bool on_double(double, json::string_view, json::error_code&) {
+        OnNonInteger();
+        return true;
+    }
+
+    bool on_bool(bool, json::error_code&) {
+        OnNonInteger();
+        return true;
+    }
+
+    bool on_null(json::error_code&) {
+        OnNonInteger();
+        return true;
+    }
+
+    bool on_comment_part(json::string_view, json::error_code&) {
+        return true;
+    }
+
+    bool on_comment(json::string_view, json::error_code&) {
+        return true;
+    }
+
+private:
+    enum class Context {
+        DOCUMENT,
+        ROOT,
+        MAPS,
+        MAP,
+        ROADS,
+        ROAD,
+        BUILDINGS,
+        BUILDING,
+        OFFICES,
+        OFFICE,
+        SKIP,
+    };
+
+    // Целочисленные поля дорог, зданий и офисов
+    enum Field {
+        X0,
+        Y0,
+        X1,
+        Y1,
+        X,
+        Y,
+        W,
+        H,
+        OFFSET_X,
+        OFFSET_Y,
+        FIELD_COUNT,
+    };
+
+    constexpr static std::array<std::string_view, FIELD_COUNT> FIELD_NAMES{
+        "x0"sv, "y0"sv, "x1"sv, "y1"sv, "x"sv, "y"sv, "w"sv, "h"sv, "offsetX"sv, "offsetY"sv};
+
+    Context Current() const noexcept {
+        return stack_.empty() ? root_ : stack_.back();
+    }
+
+    // Элементы списков дорог, зданий и офисов должны быть объектами
+    void CheckNotInList() const {
+        const Context context = Current();
+        if (context == Context::MAPS || context == Context::ROADS
+            || context == Context::BUILDINGS || context == Context::OFFICES) {
+            throw std::invalid_argument("Invalid config: list item must be an object"s);
+        }
+    }
+
+    // Значение ключа maps корневого объекта должно быть массивом
+    void CheckNotMaps() const {
+        if (Current() == Context::ROOT && key_ == "maps"sv) {
+            throw std::invalid_argument("Invalid config: maps must be an array"s);
+        }
+    }
+
+    void BeginElement(Context context) {
+        fields_.fill(std::nullopt);
+        office_id_.reset();
+        stack_.push_back(context);
+    }
+
+    bool IsElement() const noexcept {
+        const Context context = Current();
+        return context == Context::ROAD || context == Context::BUILDING
+               || context == Context::OFFICE;
+    }
+
+    void OnInteger(std::int64_t value) {
+        CheckNotMaps();
+        if (Current() == Context::MAPS) {
+            sink_.AddMapChunk(value);
+            return;
+        }
+        CheckNotInList();
+        if (!IsElement()) {
+            return;
+        }
+        for (size_t field = 0; field < FIELD_COUNT; ++field) {
+            if (key_ == FIELD_NAMES[field]) {
+                fields_[field] = static_cast<model::Coord>(value);
+                return;
+            }
+        }
+    }
+
+    void OnNonInteger() {
+        CheckNotMaps();
+        CheckNotInList();
+        if (!IsElement()) {
+            return;
+        }
+        for (const auto name : FIELD_NAMES) {
+            if (key_ == name) {
+                throw std::invalid_argument("Invalid config: "s + key_ + " must be an integer"s);
+            }
+        }
+    }
+
+    void OnString() {
+        CheckNotMaps();
+        CheckNotInList();
+        const Context context = Current();
+        if (context == Context::MAP && key_ == "id"sv) {
+            map_->id = string_;
+        } else if (context == Context::MAP && key_ == "name"sv) {
+            map_->name = string_;
+        } else if (context == Context::OFFICE && key_ == "id"sv) {
+            office_id_ = string_;
+        } else if (IsElement()) {
+            OnNonInteger();
+        }
+    }
+
+    model::Coord GetField(Field field) const {
+        if (!fields_[field]) {
+            throw std::invalid_argument("Invalid config: missing "s
+                                        + std::string{FIELD_NAMES[field]});
+        }
+        return *fields_[field];
+    }
+
+    model::Road MakeRoad() const {
+        const model::Point start{GetField(X0), GetField(Y0)};
+        if (fields_[X1]) {
+            return {model::Road::HORIZONTAL, start, *fields_[X1]};
+        }
+        return {model::Road::VERTICAL, start, GetField(Y1)};
+    }
+
+    model::Building MakeBuilding() const {
+        return model::Building{{{GetField(X), GetField(Y)}, {GetField(W), GetField(H)}}};
+    }
+
+    model::Office MakeOffice() {
+        if (!office_id_) {
+            throw std::invalid_argument("Invalid config: office must have an id"s);
+        }
+        return {model::Office::Id{util::InternedString{*office_id_}},
+                {GetField(X), GetField(Y)},
+                {GetField(OFFSET_X), GetField(OFFSET_Y)}};
+    }
+
+    void EndMap() {
+        if (!map_->id || !map_->name) {
+            throw std::invalid_argument("Invalid config: map must have an id and a name"s);
+        }
+        MapData data = std::move(*map_);
+        map_.reset();
+        sink_.AddMap(std::move(data));
+    }
+
+    MapSink& sink_;
+    // Контекст, в котором разбирается корневое значение документа
+    const Context root_;
+    std::vector<Context> stack_;
+    bool has_maps_ = false;
+    std::string key_;
+    std::string key_part_;
+    std::string string_;
+    std::optional<MapData> map_;
+    std::array<std::optional<model::Coord>, FIELD_COUNT> fields_;
+    std::optional<std::string> office_id_;
+};
+
+// Разбирает весь текст text парсером parser. Ошибкой считаются и символы после конца документа
+void Parse(json::basic_parser<ConfigHandler>& parser, std::string_view text,
+           const std::filesystem::path& path) {
+    json::error_code ec;
+    const std::size_t consumed = parser.write_some(false, text.data(), text.size(), ec);
+    if (!ec && (consumed != text.size() || !parser.done())) {
+        ec = json::error::extra_data;
+    }
+    if (ec) {
+        throw std::runtime_error("Failed to parse "s + path.string() + ": "s + ec.message());
+    }
+}
+
+// Принимает единственную карту из текста, выделенного SplitMaps
+class SingleMapSink final : public MapSink {
+public:
+    void AddMap(MapData data) override {
+        data_ = std::move(data);
+    }
+
+    void AddMapChunk(std::int64_t) override {
+        throw std::invalid_argument("Invalid config: list item must be an object"s);
+    }
+
+    MapData Take() {
+        if (!data_) {
+            throw std::invalid_argument("Invalid config: list item must be an object"s);
+        }
+        return std::move(*data_);
+    }
+
+private:
+    std::optional<MapData> data_;
+};
+
+// Разбирает текст одной карты из массива maps и строит её
+model::Map ParseMap(std::string_view text, const std::filesystem::path& path) {
+    SingleMapSink sink;
+    json::basic_parser<ConfigHandler> parser{json::parse_options{}, sink, true};
+    Parse(parser, text, path);
+    return BuildMap(sink.Take());
+}
+
+/*
+ * Собирает игру из карт, которые строятся в пуле потоков pool.
+ * Текст карты, выделенный SplitMaps, разбирается и строится в пуле целиком, поэтому карты
+ * разбираются параллельно. Карты, которые парсер разобрал сам, в пуле только строятся.
+ */
+class GameBuilder final : public MapSink {
+public:
+    GameBuilder(net::thread_pool& pool, std::vector<std::string_view> map_texts,
+                const std::filesystem::path& path)
+        : pool_{pool}
+        , map_texts_{std::move(map_texts)}
+        , path_{path} {
+    }
+
+    void AddMap(MapData data) override {
+        Post([data = std::move(data)]() mutable {
+            return BuildMap(std::move(data));
+        });
+    }
+
+    void AddMapChunk(std::int64_t index) override {
+        // Числа в массиве maps скелета идут подряд, начиная с нуля. Любое другое число
+        // стоит в исходном документе, а элемент карты должен быть объектом
+        if (index < 0 || static_cast<std::size_t>(index) != next_text_
+            || next_text_ == map_texts_.size()) {
+            throw std::invalid_argument("Invalid config: list item must be an object"s);
+        }
+        Post([text = map_texts_[next_text_++], path = path_] {
+            return ParseMap(text, path);
+        });
+    }
+
+    // Дожидается построения всех карт и добавляет их в игру в порядке следования в файле.
+    // Если разобрать или построить карту не удалось, выбрасывает исключение первой такой карты
+    model::Game TakeGame() {
+        model::Game game;
+        for (auto& map : maps_) {
+            game.AddMap(map.get());
+        }
+        maps_.clear();
+        return game;
+    }
+
+private:
+    template <typename Fn>
+    void Post(Fn&& fn) {
+        auto task = std::make_shared<std::packaged_task<model::Map()>>(std::forward<Fn>(fn));
+        maps_.push_back(task->get_future());
+        net::post(pool_, [task] {
+            (*task)();
+        });
+    }
+
+    net::thread_pool& pool_;
+    std::vector<std::string_view> map_texts_;
+    std::size_t next_text_ = 0;
+    std::filesystem::path path_;
+    // Строящиеся карты в порядке следования в файле
+    std::vector<std::future<model::Map>> maps_;
+};
+
+}  // namespace
+
+model::Game LoadGame(const std::filesystem::path& json_path, unsigned num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(json_path, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to open file "s + json_path.string());
+    }
+    if (file_size == 0) {
+        throw std::runtime_error("Config file "s + json_path.string() + " is empty"s);
+    }
+
+    const bip::file_mapping file{json_path.string().c_str(), bip::read_only};
+    bip::mapped_region region{file, bip::read_only};
+    // Файл читается один раз от начала до конца
+    region.advise(bip::mapped_region::advice_sequential);
+
+    const std::string_view document{static_cast<const char*>(region.get_address()),
+                                    region.get_size()};
+    // Тексты карт разбираются в пуле, а здесь разбирается только скелет документа.
+    // Если найти массив maps не удалось, документ разбирается здесь целиком,
+    // а в пуле только строятся готовые карты
+    auto layout = SplitMaps(document);
+
+    // Пул объявлен после отображения файла и скелета и разрушается раньше них. При выходе
+    // из функции по исключению деструктор пула останавливает его: задачи, которые ещё
+    // не начали выполняться, отбрасываются, а выполняющиеся завершаются до освобождения файла
+    net::thread_pool pool{num_threads};
+    GameBuilder builder{pool, layout ? std::move(layout->maps) : std::vector<std::string_view>{},
+                        json_path};
+    json::basic_parser<ConfigHandler> parser{json::parse_options{}, builder, false};
+    Parse(parser, layout ? std::string_view{layout->skeleton} : document, json_path);
+    // Как и LoadGameDom, выбрасываем std::out_of_range, если в корневом объекте нет ключа maps
+    if (!parser.handler().HasMaps()) {
+        throw std::out_of_range("Invalid config: maps not found"s);
+    }
+    return builder.TakeGame();
+}
+
+model::Game LoadGameDom(const std::filesystem::path& json_path) {
     // Загрузить содержимое файла json_path, например, в виде строки
+    const std::string content = ReadFile(json_path);
     // Распарсить строку как JSON, используя boost::json::parse
+    const json::value config = json::parse(content);
     // Загрузить модель игры из файла
     model::Game game;
 
+    for (const auto& map : config.as_object().at("maps"sv).as_array()) {
+        game.AddMap(LoadMap(map.as_object()));
+    }
+
     return game;
 }
 
@@ -6,6 +6,17 @@
 
 namespace json_loader {
 
-model::Game LoadGame(const std::filesystem::path& json_path);
+// Загружает модель игры из конфигурационного файла.
+// Файл отображается в память и разбирается потоково: объекты модели создаются прямо
+// по событиям парсера, без построения JSON-документа в памяти.
+// Тексты элементов массива maps выделяются без разбора и разбираются, строятся
+// и проверяются параллельно на num_threads потоках (0 - по числу ядер).
+// Карты добавляются в игру в том порядке, в каком перечислены в файле
+model::Game LoadGame(const std::filesystem::path& json_path, unsigned num_threads = 0);
+
+// Загружает модель игры, предварительно построив JSON-документ с помощью boost::json::parse.
+// Требует памяти в несколько раз больше размера файла. Используется для сравнения
+// с LoadGame в тестах и бенчмарках
+model::Game LoadGameDom(const std::filesystem::path& json_path);
 
 }  // namespace json_loader
@@ -1,17 +1,43 @@
 #include "sdk.h"
 //
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "json_loader.h"
+#include "game_session.h"
 #include "request_handler.h"
+#include "socket_handoff.h"
+#include "state_snapshot.h"
+#include "tick_scheduler.h"
+#include "world_image.h"
 
 using namespace std::literals;
 namespace net = boost::asio;
+namespace sys = boost::system;
 
 namespace {
 
+using tcp = net::ip::tcp;
+
+// Сколько преемник ждёт, пока предшественник сохранит игру
+constexpr std::chrono::seconds SNAPSHOT_TIMEOUT{5};
+
 // Запускает функцию fn на n потоках, включая текущий
 template <typename Fn>
 void RunWorkers(unsigned n, const Fn& fn) {
@@ -25,32 +51,280 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
+struct Args {
+    // Файл конфигурации в формате JSON либо образ мира, созданный --compile-config
+    std::string config_file;
+    std::string static_root;
+    // Если период не задан, игровое время не идёт
+    std::optional<std::chrono::milliseconds> tick_period;
+    // Если задан, сервер не запускается, а записывает образ мира в этот файл
+    std::optional<std::string> image_file;
+    // Ограничения на соединения и частоту запросов. Нулевые значения снимают ограничения
+    http_server::AdmissionOptions admission;
+    // Сколько ждать завершения начатых сессий после SIGTERM
+    std::chrono::milliseconds drain_timeout{10'000};
+    // Файл, в который сохраняется состояние игры при завершении и из которого
+    // оно восстанавливается при запуске
+    std::optional<std::string> state_file;
+    // UNIX-сокет для передачи слушающего сокета при перезапуске без простоя
+    std::optional<std::string> handoff_socket;
+};
+
+// Разбирает неотрицательное значение параметра командной строки. Целое значение должно
+// целиком состоять из десятичных цифр и помещаться в T. Если T - тип с плавающей точкой,
+// допускаются дробная часть и показатель степени, но не бесконечность и NaN.
+// Знак, пробелы и символы после числа не допускаются
+template <typename T>
+bool ParseNumber(std::string_view value, T& result) {
+    const char* const end = value.data() + value.size();
+    if constexpr (std::is_floating_point_v<T>) {
+        // from_chars принимает знак минус, поэтому он отвергается отдельно
+        T number = 0;
+        if (value.starts_with('-')) {
+            return false;
+        }
+        const auto [ptr, ec] = std::from_chars(value.data(), end, number);
+        if (ec != std::errc{} || ptr != end || !std::isfinite(number)) {
+            return false;
+        }
+        result = number;
+    } else {
+        std::uint64_t number = 0;
+        const auto [ptr, ec] = std::from_chars(value.data(), end, number);
+        if (ec != std::errc{} || ptr != end || !std::in_range<T>(number)) {
+            return false;
+        }
+        result = static_cast<T>(number);
+    }
+    return true;
+}
+
+std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+    Args args;
+    std::vector<std::string_view> positional;
+    bool compile_config = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--compile-config"sv) {
+            compile_config = true;
+        } else if (arg == "-o"sv) {
+            if (++i == argc) {
+                return std::nullopt;
+            }
+            args.image_file = argv[i];
+        } else if (arg == "--tick-period"sv) {
+            std::chrono::milliseconds::rep period = 0;
+            if (++i == argc || !ParseNumber(argv[i], period) || period == 0) {
+                return std::nullopt;
+            }
+            args.tick_period = std::chrono::milliseconds{period};
+        } else if (arg == "--drain-timeout"sv) {
+            std::chrono::milliseconds::rep timeout = 0;
+            if (++i == argc || !ParseNumber(argv[i], timeout)) {
+                return std::nullopt;
+            }
+            args.drain_timeout = std::chrono::milliseconds{timeout};
+        } else if (arg == "--state-file"sv) {
+            if (++i == argc) {
+                return std::nullopt;
+            }
+            args.state_file = argv[i];
+        } else if (arg == "--handoff-socket"sv) {
+            if (++i == argc) {
+                return std::nullopt;
+            }
+            args.handoff_socket = argv[i];
+        } else if (arg == "--max-connections"sv) {
+            if (++i == argc || !ParseNumber(argv[i], args.admission.max_connections)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--ip-rate-limit"sv) {
+            if (++i == argc || !ParseNumber(argv[i], args.admission.per_ip.rate)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--token-rate-limit"sv) {
+            if (++i == argc || !ParseNumber(argv[i], args.admission.per_token.rate)) {
+                return std::nullopt;
+            }
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (compile_config) {
+        if (positional.size() != 1 || !args.image_file) {
+            return std::nullopt;
+        }
+    } else if (positional.empty() || positional.size() > 2 || args.image_file) {
+        return std::nullopt;
+    }
+    args.config_file = positional[0];
+    if (positional.size() == 2) {
+        args.static_root = positional[1];
+    }
+    return args;
+}
+
+// Загружает модель игры из образа мира, если файл им является, иначе из JSON-конфигурации
+model::Game LoadGame(const std::string& path) {
+    if (world_image::IsWorldImage(path)) {
+        return world_image::WorldImage{path}.ToGame();
+    }
+    return json_loader::LoadGame(path);
+}
+
 }  // namespace
 
 int main(int argc, const char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: game_server <game-config-json>"sv << std::endl;
+    const auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+        std::cerr << "Usage: game_server <game-config-json-or-world-bin> [<static-files-dir>] "sv
+                     "[--tick-period <milliseconds>]\n"sv
+                     "       [--max-connections <n>] [--ip-rate-limit <requests-per-second>] "sv
+                     "[--token-rate-limit <requests-per-second>]\n"sv
+                     "       [--drain-timeout <milliseconds>] [--state-file <path>] "sv
+                     "[--handoff-socket <path>]\n"sv
+                     "       game_server --compile-config <game-config-json> -o <world-bin>"sv
+                  << std::endl;
         return EXIT_FAILURE;
     }
     try {
+        if (args->image_file) {
+            world_image::WriteWorldImage(json_loader::LoadGame(args->config_file),
+                                         *args->image_file);
+            return EXIT_SUCCESS;
+        }
+
         // 1. Загружаем карту из файла и построить модель игры
-        model::Game game = json_loader::LoadGame(argv[1]);
+        model::Game game = LoadGame(args->config_file);
 
         // 2. Инициализируем io_context
         const unsigned num_threads = std::thread::hardware_concurrency();
         net::io_context ioc(num_threads);
 
-        // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
+        // Создаём по игровой сессии на каждую карту. Если задан период тиков, сессии
+        // обновляются планировщиком, каждая в своём strand
+        std::vector<std::unique_ptr<model::GameSession>> sessions;
+        sessions.reserve(game.GetMaps().size());
+        for (const auto& map : game.GetMaps()) {
+            sessions.emplace_back(std::make_unique<model::GameSession>(map));
+        }
+
+        // При перезапуске без простоя слушающий сокет передаёт работающий предшественник.
+        // Соединения, пришедшие в это время, ждут в очереди ядра. Предшественник сохраняет
+        // игру до плавного завершения, поэтому преемник ждёт только сохранения
+        const tcp::endpoint endpoint{net::ip::make_address("0.0.0.0"), 8080};
+        std::optional<http_server::Predecessor> predecessor;
+        if (args->handoff_socket) {
+            predecessor = http_server::Predecessor::Connect(*args->handoff_socket,
+                                                            endpoint.protocol());
+        }
+        const http_server::ListeningSocket listening_socket =
+            predecessor ? predecessor->GetListeningSocket()
+                        : http_server::OpenListeningSocket(endpoint);
+        if (predecessor && args->state_file && !predecessor->WaitForRelease(SNAPSHOT_TIMEOUT)) {
+            std::cerr << "Predecessor has not saved the game state in time"sv << std::endl;
+        }
+        predecessor.reset();
+        if (args->state_file) {
+            app::LoadStateSnapshot(sessions, *args->state_file);
+        }
+
+        std::optional<app::TickScheduler> tick_scheduler;
+        if (args->tick_period) {
+            tick_scheduler.emplace(ioc, app::TickSchedulerOptions{*args->tick_period});
+            for (auto& session : sessions) {
+                tick_scheduler->AddSession(*session);
+            }
+            tick_scheduler->Start();
+        }
 
         // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        http_handler::RequestHandler handler{game};
+        http_handler::RequestHandler handler{game, args->static_root,
+                                             tick_scheduler ? &*tick_scheduler : nullptr};
 
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
-        /*
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto&& req, auto&& send) {
-            handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        });
-        */
+        http_server::SessionOptions session_options;
+        session_options.admission_control =
+            std::make_shared<http_server::AdmissionControl>(args->admission);
+        session_options.drain = std::make_shared<http_server::ServerDrain>();
+        http_server::ServeHttp(
+            ioc, listening_socket,
+            [&handler](auto&& req, auto&& send) {
+                handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+            },
+            session_options);
+
+        // Плавное завершение: сервер перестаёт принимать соединения и ждёт, пока сессии
+        // ответят на прочитанные запросы, но не дольше drain_timeout
+        net::steady_timer drain_timer{ioc};
+        std::once_flag drain_once;
+        std::optional<http_server::SocketHandoff> handoff;
+        const auto start_drain = [&] {
+            std::call_once(drain_once, [&] {
+                if (handoff) {
+                    handoff->Stop();
+                }
+                session_options.drain->Start([&ioc] {
+                    ioc.stop();
+                });
+                drain_timer.expires_after(args->drain_timeout);
+                drain_timer.async_wait([&ioc](const sys::error_code& ec) {
+                    if (!ec) {
+                        ioc.stop();
+                    }
+                });
+            });
+        };
+
+        // Состояние, сохранённое для преемника, не сохраняется повторно при выходе
+        bool state_saved = false;
+        const auto save_state = [&] {
+            try {
+                app::SaveStateSnapshot(sessions, *args->state_file);
+                state_saved = true;
+            } catch (const std::exception& ex) {
+                std::cerr << "Failed to save the game state: "sv << ex.what() << std::endl;
+            }
+        };
+
+        // Преемник получил слушающий сокет и уже может принимать соединения, но ждёт
+        // состояния игры. Поэтому тики останавливаются, а игра сохраняется и преемник
+        // отпускается до плавного завершения, которое может длиться drain_timeout
+        const auto on_handoff = [&] {
+            const auto release_successor = [&] {
+                if (args->state_file) {
+                    save_state();
+                }
+                handoff->ReleaseSuccessor();
+                start_drain();
+            };
+            if (args->state_file && tick_scheduler) {
+                tick_scheduler->Stop(release_successor);
+            } else {
+                release_successor();
+            }
+        };
+        if (args->handoff_socket) {
+            handoff.emplace(ioc, *args->handoff_socket, listening_socket, on_handoff);
+        }
+
+        // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM.
+        // SIGTERM запускает плавное завершение, SIGINT и повторный сигнал
+        // останавливают сервер немедленно
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        std::function<void(const sys::error_code&, int)> on_signal =
+            [&](const sys::error_code& ec, int signal_number) {
+                if (ec) {
+                    return;
+                }
+                if (signal_number == SIGTERM && !session_options.drain->IsDraining()) {
+                    start_drain();
+                    signals.async_wait(on_signal);
+                    return;
+                }
+                ioc.stop();
+            };
+        signals.async_wait(on_signal);
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         std::cout << "Server has started..."sv << std::endl;
@@ -59,6 +333,15 @@ int main(int argc, const char* argv[]) {
         RunWorkers(std::max(1u, num_threads), [&ioc] {
             ioc.run();
         });
+
+        // Рабочие потоки остановлены, поэтому игровые сессии больше никто не изменяет
+        if (args->state_file && !state_saved) {
+            app::SaveStateSnapshot(sessions, *args->state_file);
+        }
+        std::cout.flush();
+        std::clog.flush();
+        // Если сервер остановился раньше, чем отпустил преемника, соединение с ним
+        // закрывается при удалении handoff, после сохранения состояния
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << std::endl;
         return EXIT_FAILURE;
@@ -0,0 +1,125 @@
+#include "maps_cache.h"
+
+#include <boost/json.hpp>
+#include <cstdio>
+
+namespace http_handler {
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+json::object RoadToJson(const model::Road& road) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    json::object obj{{"x0"sv, start.x}, {"y0"sv, start.y}};
+    if (road.IsHorizontal()) {
+        obj.emplace("x1"sv, end.x);
+    } else {
+        obj.emplace("y1"sv, end.y);
+    }
+    return obj;
+}
+
+json::object BuildingToJson(const model::Building& building) {
+    const auto& bounds = building.GetBounds();
+    return {{"x"sv, bounds.position.x},
+            {"y"sv, bounds.position.y},
+            {"w"sv, bounds.size.width},
+            {"h"sv, bounds.size.height}};
+}
+
+json::object OfficeToJson(const model::Office& office) {
+    return {{"id"sv, office.GetId()->GetView()},
+            {"x"sv, office.GetPosition().x},
+            {"y"sv, office.GetPosition().y},
+            {"offsetX"sv, office.GetOffset().dx},
+            {"offsetY"sv, office.GetOffset().dy}};
+}
+
+json::object MapToJson(const model::Map& map) {
+    json::array roads;
+    roads.reserve(map.GetRoads().size());
+    for (const auto& road : map.GetRoads()) {
+        roads.emplace_back(RoadToJson(road));
+    }
+
+    json::array buildings;
+    buildings.reserve(map.GetBuildings().size());
+    for (const auto& building : map.GetBuildings()) {
+        buildings.emplace_back(BuildingToJson(building));
+    }
+
+    json::array offices;
+    offices.reserve(map.GetOffices().size());
+    for (const auto& office : map.GetOffices()) {
+        offices.emplace_back(OfficeToJson(office));
+    }
+
+    return {{"id"sv, map.GetId()->GetView()},
+            {"name"sv, map.GetName()},
+            {"roads"sv, std::move(roads)},
+            {"buildings"sv, std::move(buildings)},
+            {"offices"sv, std::move(offices)}};
+}
+
+std::string_view Trim(std::string_view str) noexcept {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+}  // namespace
+
+SerializedJsonPtr MakeSerializedJson(std::string body) {
+    const size_t hash = std::hash<std::string_view>{}(body);
+    char etag[20];
+    const int etag_size = std::snprintf(etag, sizeof(etag), "\"%016zx\"", hash);
+    return std::make_shared<const SerializedJson>(
+        SerializedJson{std::move(body), std::string(etag, static_cast<size_t>(etag_size))});
+}
+
+bool IfNoneMatch(std::string_view if_none_match, std::string_view etag) noexcept {
+    while (!if_none_match.empty()) {
+        const auto comma_pos = if_none_match.find(',');
+        auto candidate = Trim(if_none_match.substr(0, comma_pos));
+        if_none_match
+            = comma_pos == std::string_view::npos ? ""sv : if_none_match.substr(comma_pos + 1);
+
+        // Для If-None-Match используется слабое сравнение, поэтому префикс W/ игнорируется
+        if (candidate.starts_with("W/"sv)) {
+            candidate.remove_prefix(2);
+        }
+        if (candidate == "*"sv || candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MapsCache::MapsCache(const model::Game& game)
+    : game_{game} {
+    json::array map_list;
+    map_list.reserve(game.GetMaps().size());
+    maps_.reserve(game.GetMaps().size());
+    for (const auto& map : game.GetMaps()) {
+        map_list.emplace_back(
+            json::object{{"id"sv, map.GetId()->GetView()}, {"name"sv, map.GetName()}});
+        maps_.emplace_back(MakeSerializedJson(json::serialize(MapToJson(map))));
+    }
+    map_list_ = MakeSerializedJson(json::serialize(map_list));
+}
+
+const SerializedJson* MapsCache::FindMap(std::string_view id) const noexcept {
+    if (const model::Map* map = game_.FindMap(id)) {
+        return maps_[map - game_.GetMaps().data()].get();
+    }
+    return nullptr;
+}
+
+}  // namespace http_handler
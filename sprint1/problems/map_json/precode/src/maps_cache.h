@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "model.h"
+
+namespace http_handler {
+
+// Неизменяемое JSON-представление ресурса вместе с его ETag.
+// Создаётся один раз при старте сервера и затем только читается
+struct SerializedJson {
+    std::string body;
+    // Сильный ETag в кавычках, например "\"1f2e3d4c5b6a7980\""
+    std::string etag;
+};
+
+using SerializedJsonPtr = std::shared_ptr<const SerializedJson>;
+
+// Создаёт SerializedJson, вычисляя ETag по содержимому body
+SerializedJsonPtr MakeSerializedJson(std::string body);
+
+// Проверяет, совпадает ли etag с одним из значений заголовка If-None-Match
+bool IfNoneMatch(std::string_view if_none_match, std::string_view etag) noexcept;
+
+/*
+ * Кеш JSON-представлений списка карт и каждой карты.
+ * Модель игры не меняется после загрузки, поэтому все ответы сериализуются в конструкторе,
+ * а обработка запроса сводится к поиску в хеш-таблице.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class MapsCache {
+public:
+    explicit MapsCache(const model::Game& game);
+
+    const SerializedJson& GetMapList() const noexcept {
+        return *map_list_;
+    }
+
+    // Возвращает nullptr, если карты с таким id нет
+    const SerializedJson* FindMap(std::string_view id) const noexcept;
+
+private:
+    const model::Game& game_;
+    SerializedJsonPtr map_list_;
+    // JSON-представления карт в порядке их следования в game_.GetMaps()
+    std::vector<SerializedJsonPtr> maps_;
+};
+
+}  // namespace http_handler
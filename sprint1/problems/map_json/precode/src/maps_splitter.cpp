@@ -0,0 +1,148 @@
+#include "maps_splitter.h"
+
+namespace json_loader {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr auto npos = std::string_view::npos;
+
+bool IsWhitespace(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+std::size_t SkipWhitespace(std::string_view text, std::size_t pos) noexcept {
+    while (pos < text.size() && IsWhitespace(text[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Возвращает позицию после строки, открывающая кавычка которой стоит в позиции pos,
+// или npos, если строка не закрыта
+std::size_t SkipString(std::string_view text, std::size_t pos) noexcept {
+    ++pos;
+    while ((pos = text.find_first_of("\"\\"sv, pos)) != npos) {
+        if (text[pos] == '"') {
+            return pos + 1;
+        }
+        // Экранированный символ, в том числе кавычка, строку не завершает
+        pos += 2;
+    }
+    return npos;
+}
+
+// Возвращает позицию после значения, начинающегося в позиции pos, или npos, если значение
+// не закончено. Тип закрывающей скобки не сверяется с открывающей - это сделает парсер
+std::size_t SkipValue(std::string_view text, std::size_t pos) noexcept {
+    if (pos >= text.size()) {
+        return npos;
+    }
+    const char first = text[pos];
+    if (first == '"') {
+        return SkipString(text, pos);
+    }
+    if (first != '{' && first != '[') {
+        // Число, true, false или null продолжается до разделителя
+        while (pos < text.size() && !IsWhitespace(text[pos]) && text[pos] != ','
+               && text[pos] != ']' && text[pos] != '}') {
+            ++pos;
+        }
+        return pos;
+    }
+    std::size_t depth = 0;
+    while ((pos = text.find_first_of("\"{}[]"sv, pos)) != npos) {
+        const char c = text[pos];
+        if (c == '"') {
+            pos = SkipString(text, pos);
+            if (pos == npos) {
+                return npos;
+            }
+            continue;
+        }
+        ++pos;
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (--depth == 0) {
+            return pos;
+        }
+    }
+    return npos;
+}
+
+// Разделяет массив, открывающая скобка которого стоит в позиции array_begin
+std::optional<MapsLayout> SplitArray(std::string_view document, std::size_t array_begin) {
+    MapsLayout layout;
+    std::size_t pos = SkipWhitespace(document, array_begin + 1);
+    if (pos < document.size() && document[pos] == ']') {
+        layout.skeleton = document;
+        return layout;
+    }
+    // Начало ещё не скопированной в скелет части документа
+    std::size_t copied = 0;
+    while (true) {
+        const std::size_t end = SkipValue(document, pos);
+        if (end == npos || end == pos) {
+            return std::nullopt;
+        }
+        layout.skeleton.append(document.substr(copied, pos - copied));
+        layout.skeleton.append(std::to_string(layout.maps.size()));
+        layout.maps.push_back(document.substr(pos, end - pos));
+        copied = end;
+
+        pos = SkipWhitespace(document, end);
+        if (pos == document.size()) {
+            return std::nullopt;
+        }
+        if (document[pos] == ']') {
+            break;
+        }
+        if (document[pos] != ',') {
+            return std::nullopt;
+        }
+        pos = SkipWhitespace(document, pos + 1);
+    }
+    layout.skeleton.append(document.substr(copied));
+    return layout;
+}
+
+}  // namespace
+
+std::optional<MapsLayout> SplitMaps(std::string_view document) {
+    std::size_t pos = SkipWhitespace(document, 0);
+    if (pos == document.size() || document[pos] != '{') {
+        return std::nullopt;
+    }
+    pos = SkipWhitespace(document, pos + 1);
+    // Перебираем пары ключ-значение корневого объекта, пока не встретится ключ maps
+    while (pos < document.size() && document[pos] == '"') {
+        const std::size_t key_end = SkipString(document, pos);
+        if (key_end == npos) {
+            return std::nullopt;
+        }
+        // Ключ сравнивается без раскодирования escape-последовательностей. Ключ maps,
+        // записанный с ними, не будет найден, и документ разберётся целиком
+        const auto key = document.substr(pos + 1, key_end - pos - 2);
+        pos = SkipWhitespace(document, key_end);
+        if (pos == document.size() || document[pos] != ':') {
+            return std::nullopt;
+        }
+        pos = SkipWhitespace(document, pos + 1);
+        if (key == "maps"sv && pos < document.size() && document[pos] == '[') {
+            return SplitArray(document, pos);
+        }
+        pos = SkipValue(document, pos);
+        if (pos == npos) {
+            return std::nullopt;
+        }
+        pos = SkipWhitespace(document, pos);
+        if (pos == document.size() || document[pos] != ',') {
+            break;
+        }
+        pos = SkipWhitespace(document, pos + 1);
+    }
+    return std::nullopt;
+}
+
+}  // namespace json_loader
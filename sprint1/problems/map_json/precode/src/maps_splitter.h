@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json_loader {
+
+// Конфигурационный файл, разделённый на тексты карт и остальную часть документа
+struct MapsLayout {
+    // Документ, в котором i-й элемент массива maps заменён числом i
+    std::string skeleton;
+    // Тексты элементов массива maps в порядке следования. Ссылаются на исходный документ
+    std::vector<std::string_view> maps;
+};
+
+/*
+ * Находит массив maps корневого объекта и байтовые диапазоны его элементов, не разбирая
+ * документ полностью: учитываются только строки, скобки, двоеточия и запятые.
+ * Корректность JSON не проверяется - её проверяет разбор скелета и каждого из текстов карт:
+ * если корректны они все, корректен и исходный документ.
+ * Возвращает std::nullopt, если массив не найден или структура документа нарушена.
+ * В этом случае документ нужно разобрать целиком.
+ */
+std::optional<MapsLayout> SplitMaps(std::string_view document);
+
+}  // namespace json_loader
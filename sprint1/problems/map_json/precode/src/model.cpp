@@ -5,6 +5,24 @@
 namespace model {
 using namespace std::literals;
 
+void Map::AddRoad(const Road& road) {
+    const size_t index = roads_.size();
+    const Road& r = roads_.emplace_back(road);
+    try {
+        const auto start = r.GetStart();
+        const auto end = r.GetEnd();
+        if (r.IsHorizontal()) {
+            road_index_.AddHorizontalRoad(start.y, start.x, end.x, index);
+        } else {
+            road_index_.AddVerticalRoad(start.x, start.y, end.y, index);
+        }
+    } catch (...) {
+        // Удаляем дорогу из вектора, если не удалось добавить её в индекс
+        roads_.pop_back();
+        throw;
+    }
+}
+
 void Map::AddOffice(Office office) {
     if (warehouse_id_to_index_.contains(office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
@@ -24,7 +42,8 @@ void Map::AddOffice(Office office) {
 void Game::AddMap(Map map) {
     const size_t index = maps_.size();
     if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
-        throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
+        throw std::invalid_argument("Map with id "s + std::string{map.GetId()->GetView()}
+                                    + " already exists"s);
     } else {
         try {
             maps_.emplace_back(std::move(map));
@@ -1,8 +1,11 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "interned_string.h"
+#include "road_index.h"
 #include "tagged.h"
 
 namespace model {
@@ -87,7 +90,7 @@ private:
 
 class Office {
 public:
-    using Id = util::Tagged<std::string, Office>;
+    using Id = util::Tagged<util::InternedString, Office>;
 
     Office(Id id, Point position, Offset offset) noexcept
         : id_{std::move(id)}
@@ -115,7 +118,7 @@ private:
 
 class Map {
 public:
-    using Id = util::Tagged<std::string, Map>;
+    using Id = util::Tagged<util::InternedString, Map>;
     using Roads = std::vector<Road>;
     using Buildings = std::vector<Building>;
     using Offices = std::vector<Office>;
@@ -145,10 +148,13 @@ public:
         return offices_;
     }
 
-    void AddRoad(const Road& road) {
-        roads_.emplace_back(road);
+    // Пространственный индекс дорог карты. Строится по мере добавления дорог
+    const RoadIndex& GetRoadIndex() const noexcept {
+        return road_index_;
     }
 
+    void AddRoad(const Road& road);
+
     void AddBuilding(const Building& building) {
         buildings_.emplace_back(building);
     }
@@ -161,6 +167,7 @@ private:
     Id id_;
     std::string name_;
     Roads roads_;
+    RoadIndex road_index_;
     Buildings buildings_;
 
     OfficeIdToIndex warehouse_id_to_index_;
@@ -177,17 +184,58 @@ public:
         return maps_;
     }
 
+    // Использует вычисленный заранее хеш id и сравнивает id без обращения к символам строки
     const Map* FindMap(const Map::Id& id) const noexcept {
+        return FindMapImpl(id);
+    }
+
+    // Ищет карту по id, полученному, например, из URL запроса. Не создаёт std::string
+    // и не добавляет id в пул строк
+    const Map* FindMap(std::string_view id) const noexcept {
+        return FindMapImpl(id);
+    }
+
+private:
+    // Хешер и компаратор, позволяющие искать карты как по Map::Id, так и по std::string_view.
+    // Хеш Map::Id совпадает с хешем его строки, поэтому оба вида ключей попадают в одну корзину
+    struct MapIdHasher {
+        using is_transparent = void;
+
+        size_t operator()(const Map::Id& id) const noexcept {
+            return id->GetHash();
+        }
+
+        size_t operator()(std::string_view id) const noexcept {
+            return std::hash<std::string_view>{}(id);
+        }
+    };
+
+    struct MapIdEqual {
+        using is_transparent = void;
+
+        bool operator()(const Map::Id& lhs, const Map::Id& rhs) const noexcept {
+            return lhs == rhs;
+        }
+
+        bool operator()(const Map::Id& lhs, std::string_view rhs) const noexcept {
+            return lhs->GetView() == rhs;
+        }
+
+        bool operator()(std::string_view lhs, const Map::Id& rhs) const noexcept {
+            return lhs == rhs->GetView();
+        }
+    };
+
+    using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher, MapIdEqual>;
+
+    template <typename Key>
+    const Map* FindMapImpl(const Key& id) const noexcept {
         if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end()) {
-            return &maps_.at(it->second);
+            return &maps_[it->second];
         }
         return nullptr;
     }
 
-private:
-    using MapIdHasher = util::TaggedHasher<Map::Id>;
-    using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
-
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
 };
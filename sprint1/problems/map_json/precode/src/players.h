@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+#include "model.h"
+#include "token_table.h"
+
+namespace app {
+
+// Игрок - собака на карте, которой клиент управляет по выданному токену
+struct Player {
+    const model::Map* map;
+    std::size_t dog_id;
+};
+
+/*
+ * Игроки, вошедшие в игру. Игроки не удаляются, поэтому указатели на них
+ * действительны всё время жизни объекта.
+ * Поиск по токену не берёт блокировок и может выполняться одновременно с добавлением.
+ */
+class Players {
+public:
+    Players() = default;
+
+    Players(const Players&) = delete;
+    Players& operator=(const Players&) = delete;
+
+    // Добавляет игрока и возвращает выданный ему токен. Потокобезопасен
+    Token Add(const model::Map& map, std::size_t dog_id) {
+        std::lock_guard lock{mutex_};
+        const Player& player = players_.emplace_back(Player{&map, dog_id});
+        Token token = generator_.Generate();
+        // Совпадение 128-битных случайных токенов практически невозможно, но не исключено
+        while (!tokens_.Insert(token, &player)) {
+            token = generator_.Generate();
+        }
+        return token;
+    }
+
+    // Возвращает игрока по токену или nullptr
+    const Player* FindByToken(const Token& token) const noexcept {
+        return tokens_.Find(token);
+    }
+
+private:
+    std::mutex mutex_;
+    TokenGenerator generator_;
+    // std::deque не перемещает элементы при добавлении в конец
+    std::deque<Player> players_;
+    TokenTable<const Player> tokens_;
+};
+
+}  // namespace app
@@ -1,5 +1,392 @@
 #include "request_handler.h"
 
+#include <boost/json.hpp>
+#include <charconv>
+#include <chrono>
+#include <optional>
+
+#include "stream_session.h"
+
 namespace http_handler {
 
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+struct ContentType {
+    ContentType() = delete;
+    constexpr static std::string_view APPLICATION_JSON = "application/json"sv;
+};
+
+struct Endpoint {
+    Endpoint() = delete;
+    constexpr static std::string_view API_PREFIX = "/api/"sv;
+};
+
+constexpr std::uint64_t GET_HEAD = MethodBit(http::verb::get) | MethodBit(http::verb::head);
+
+// Маршруты API. Порядок совпадает с порядком значений Route
+constexpr std::array API_ROUTES{
+    RouteSpec{"/api/v1/maps"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/maps/{id}"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/tick-stats"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/route-stats"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/state"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/stream"sv, MethodBit(http::verb::get), "GET"sv},
+    RouteSpec{"/api/v1/game/stream-stats"sv, GET_HEAD, "GET, HEAD"sv},
+    RouteSpec{"/api/v1/game/join"sv, MethodBit(http::verb::post), "POST"sv},
+};
+
+enum Route : size_t {
+    MAP_LIST,
+    MAP,
+    TICK_STATS,
+    ROUTE_STATS,
+    GAME_STATE,
+    GAME_STREAM,
+    STREAM_STATS,
+    JOIN,
+};
+
+constexpr auto API_ROUTER = MakeRouter<API_ROUTES>();
+
+StringResponse MakeStringResponse(http::status status, std::string_view body,
+                                  const RequestInfo& info,
+                                  std::string_view content_type = ContentType::APPLICATION_JSON) {
+    StringResponse response(status, info.version);
+    response.set(http::field::content_type, content_type);
+    response.body() = body;
+    response.content_length(body.size());
+    response.keep_alive(info.keep_alive);
+    return response;
+}
+
+StringResponse MakeErrorResponse(http::status status, std::string_view code,
+                                 std::string_view message, const RequestInfo& info) {
+    std::string body;
+    body.reserve(code.size() + message.size() + 26);
+    body.append(R"({"code":")"sv).append(code).append(R"(","message":")"sv).append(message).append(
+        R"("})"sv);
+    return MakeStringResponse(status, body, info);
+}
+
+// Формирует ответ на GET- или HEAD-запрос заранее сериализованного ресурса.
+// Тело ответа ссылается на буфер json без копирования.
+// Если клиенту уже известна актуальная версия ресурса, возвращает 304 Not Modified
+Response MakeCachedJsonResponse(const SerializedJson& json, const RequestInfo& info) {
+    if (IfNoneMatch(info.if_none_match, json.etag)) {
+        StringResponse response(http::status::not_modified, info.version);
+        response.set(http::field::etag, json.etag);
+        response.keep_alive(info.keep_alive);
+        return response;
+    }
+
+    BufferResponse response(http::status::ok, info.version);
+    response.set(http::field::content_type, ContentType::APPLICATION_JSON);
+    response.set(http::field::etag, json.etag);
+    response.content_length(json.body.size());
+    if (info.method == http::verb::get) {
+        response.body() = BufferResponse::body_type::value_type{json.body.data(), json.body.size()};
+    }
+    response.keep_alive(info.keep_alive);
+    return response;
+}
+
+// Возвращает значение параметра name из строки запроса target, не декодируя его
+std::optional<std::string_view> GetQueryParam(std::string_view target, std::string_view name) {
+    const size_t query_start = target.find('?');
+    if (query_start == std::string_view::npos) {
+        return std::nullopt;
+    }
+    std::string_view query = target.substr(query_start + 1);
+    while (!query.empty()) {
+        const size_t end = std::min(query.find('&'), query.size());
+        const std::string_view param = query.substr(0, end);
+        if (param.starts_with(name) && param.size() > name.size() && param[name.size()] == '=') {
+            return param.substr(name.size() + 1);
+        }
+        query.remove_prefix(std::min(end + 1, query.size()));
+    }
+    return std::nullopt;
+}
+
+json::array HistogramToJson(const app::DurationHistogram::Snapshot& durations) {
+    json::array histogram;
+    histogram.reserve(durations.counts.size());
+    for (size_t i = 0; i < durations.counts.size(); ++i) {
+        json::object bucket;
+        if (i < app::DurationHistogram::BUCKET_BOUNDS_US.size()) {
+            bucket.emplace("leUs"sv, app::DurationHistogram::BUCKET_BOUNDS_US[i]);
+        } else {
+            bucket.emplace("leUs"sv, nullptr);
+        }
+        bucket.emplace("count"sv, durations.counts[i]);
+        histogram.emplace_back(std::move(bucket));
+    }
+    return histogram;
+}
+
+json::object TickStatsToJson(const app::TickStats& stats) {
+    const auto durations = stats.durations.GetSnapshot();
+    return {{"ticks"sv, stats.ticks.load(std::memory_order_relaxed)},
+            {"lateTicks"sv, stats.late_ticks.load(std::memory_order_relaxed)},
+            {"skippedTicks"sv, stats.skipped_ticks.load(std::memory_order_relaxed)},
+            {"totalUs"sv, durations.total_us},
+            {"maxUs"sv, durations.max_us},
+            {"histogram"sv, HistogramToJson(durations)}};
+}
+
+json::object DurationsToJson(const app::DurationHistogram& histogram) {
+    const auto durations = histogram.GetSnapshot();
+    return {{"count"sv, durations.count},
+            {"totalUs"sv, durations.total_us},
+            {"maxUs"sv, durations.max_us},
+            {"histogram"sv, HistogramToJson(durations)}};
+}
+
+json::object StreamStatsToJson(const app::StreamStats& stats) {
+    return {{"subscribers"sv, stats.subscribers.load(std::memory_order_relaxed)},
+            {"framesPublished"sv, stats.frames_published.load(std::memory_order_relaxed)},
+            {"framesSent"sv, stats.frames_sent.load(std::memory_order_relaxed)},
+            {"framesDropped"sv, stats.frames_dropped.load(std::memory_order_relaxed)},
+            {"fullFramesSent"sv, stats.full_frames_sent.load(std::memory_order_relaxed)},
+            {"fanOut"sv, DurationsToJson(stats.fan_out)},
+            {"delivery"sv, DurationsToJson(stats.delivery)}};
+}
+
+}  // namespace
+
+Response RequestHandler::HandleRequest(const RequestInfo& info) {
+    // Учитывается время формирования ответа, без его отправки клиенту
+    const auto start = std::chrono::steady_clock::now();
+    const std::string_view path = info.target.substr(0, info.target.find('?'));
+
+    size_t counter = STATIC_FILES_COUNTER;
+    Response response = path.starts_with(Endpoint::API_PREFIX)
+                            ? HandleApiRequest(info, path, counter)
+                            : std::visit(
+                                [](auto&& file_response) -> Response {
+                                    return std::move(file_response);
+                                },
+                                static_files_.HandleRequest({info.method, info.target,
+                                                             info.accept_encoding, info.range,
+                                                             info.version, info.keep_alive}));
+    counters_[counter].Record(std::chrono::steady_clock::now() - start);
+    return response;
+}
+
+Response RequestHandler::HandleApiRequest(const RequestInfo& info, std::string_view path,
+                                          size_t& counter) {
+    static_assert(API_ROUTES.size() == NUM_API_ROUTES);
+    const RouteMatch match = API_ROUTER.Match(info.method, path);
+    // Статистика тиков и состояние игры доступны, только если задан планировщик тиков
+    const bool needs_ticks = match.route == TICK_STATS || match.route == GAME_STATE
+                             || match.route == GAME_STREAM || match.route == STREAM_STATS
+                             || match.route == JOIN;
+    if (match.route == RouteMatch::NOT_FOUND || (needs_ticks && !tick_scheduler_)) {
+        counter = UNMATCHED_COUNTER;
+        return MakeErrorResponse(http::status::bad_request, "badRequest"sv, "Bad request"sv, info);
+    }
+
+    counter = match.route;
+    if (!match.method_allowed) {
+        StringResponse response = MakeErrorResponse(http::status::method_not_allowed,
+                                                     "invalidMethod"sv, "Invalid method"sv, info);
+        response.set(http::field::allow, API_ROUTER.GetRoute(match.route).allow);
+        return response;
+    }
+
+    switch (static_cast<Route>(match.route)) {
+        case MAP_LIST:
+            return MakeCachedJsonResponse(maps_cache_.GetMapList(), info);
+        case MAP:
+            if (const SerializedJson* map = maps_cache_.FindMap(match.params[0])) {
+                return MakeCachedJsonResponse(*map, info);
+            }
+            return MakeErrorResponse(http::status::not_found, "mapNotFound"sv, "Map not found"sv,
+                                     info);
+        case TICK_STATS:
+            return HandleTickStatsRequest(info);
+        case ROUTE_STATS:
+            return HandleRouteStatsRequest(info);
+        case GAME_STATE:
+            return HandleGameStateRequest(info);
+        case GAME_STREAM:
+            return HandleGameStreamRequest(info);
+        case STREAM_STATS:
+            return HandleStreamStatsRequest(info);
+        case JOIN:
+            return HandleJoinRequest(info);
+    }
+    return MakeErrorResponse(http::status::bad_request, "badRequest"sv, "Bad request"sv, info);
+}
+
+StringResponse RequestHandler::HandleTickStatsRequest(const RequestInfo& info) const {
+    // Статистика меняется с каждым тиком, поэтому сериализуется при каждом запросе
+    json::object maps;
+    tick_scheduler_->ForEachStats([&maps](const model::GameSession& session,
+                                          const app::TickStats& stats) {
+        maps.emplace(session.GetMap().GetId()->GetView(), TickStatsToJson(stats));
+    });
+    const json::object body{
+        {"periodMs"sv, tick_scheduler_->GetOptions().period.count()},
+        {"maps"sv, std::move(maps)}};
+
+    StringResponse response =
+        MakeStringResponse(http::status::ok, json::serialize(body), info);
+    response.set(http::field::cache_control, "no-cache"sv);
+    if (info.method == http::verb::head) {
+        response.body().clear();
+    }
+    return response;
+}
+
+Response RequestHandler::HandleGameStateRequest(const RequestInfo& info) const {
+    // Состояние отдаётся только игрокам - по токену, выданному при входе в игру
+    const auto token = app::Token::ParseBearer(info.authorization);
+    if (!token) {
+        return MakeErrorResponse(http::status::unauthorized, "invalidToken"sv,
+                                 "Authorization header is missing or malformed"sv, info);
+    }
+    const app::Player* player = players_.FindByToken(*token);
+    if (!player) {
+        return MakeErrorResponse(http::status::unauthorized, "unknownToken"sv,
+                                 "Player token has not been found"sv, info);
+    }
+    const app::StateJournal* journal = tick_scheduler_->FindJournal(*player->map);
+    if (!journal) {
+        return MakeErrorResponse(http::status::not_found, "mapNotFound"sv, "Map not found"sv, info);
+    }
+
+    // Параметр since - последний тик, состояние на который уже есть у клиента.
+    // Без него отправляется полное состояние
+    std::optional<std::uint64_t> since;
+    if (const auto since_param = GetQueryParam(info.target, "since"sv)) {
+        std::uint64_t value = 0;
+        const auto [ptr, ec] =
+            std::from_chars(since_param->data(), since_param->data() + since_param->size(), value);
+        if (ec != std::errc{} || ptr != since_param->data() + since_param->size()) {
+            return MakeErrorResponse(http::status::bad_request, "invalidArgument"sv,
+                                     "Invalid since parameter"sv, info);
+        }
+        since = value;
+    }
+
+    StringResponse response = MakeStringResponse(
+        http::status::ok, app::SerializeState(journal->GetState(since)), info);
+    response.set(http::field::cache_control, "no-cache"sv);
+    if (info.method == http::verb::head) {
+        response.body().clear();
+    }
+    return response;
+}
+
+Response RequestHandler::HandleGameStreamRequest(const RequestInfo& info) const {
+    if (!info.websocket_upgrade) {
+        StringResponse response =
+            MakeErrorResponse(http::status::upgrade_required, "upgradeRequired"sv,
+                              "WebSocket upgrade expected"sv, info);
+        response.set(http::field::upgrade, "websocket"sv);
+        return response;
+    }
+    const auto map_id = GetQueryParam(info.target, "map"sv);
+    const model::Map* map = map_id ? game_.FindMap(*map_id) : nullptr;
+    app::StateStream* stream = map ? tick_scheduler_->FindStream(*map) : nullptr;
+    if (!stream) {
+        return MakeErrorResponse(http::status::not_found, "mapNotFound"sv, "Map not found"sv, info);
+    }
+
+    return http_server::WebSocketUpgrade{
+        [stream](beast::tcp_stream&& socket, http_server::Request& request,
+                 http_server::ConnectionSlot&& slot) {
+            std::make_shared<app::StreamSession>(std::move(socket), *stream, std::move(slot))
+                ->Run(request);
+        }};
+}
+
+StringResponse RequestHandler::HandleStreamStatsRequest(const RequestInfo& info) const {
+    json::object maps;
+    for (const auto& map : game_.GetMaps()) {
+        if (const app::StateStream* stream = tick_scheduler_->FindStream(map)) {
+            maps.emplace(map.GetId()->GetView(), StreamStatsToJson(stream->GetStats()));
+        }
+    }
+    const json::object body{{"maps"sv, std::move(maps)}};
+
+    StringResponse response = MakeStringResponse(http::status::ok, json::serialize(body), info);
+    response.set(http::field::cache_control, "no-cache"sv);
+    if (info.method == http::verb::head) {
+        response.body().clear();
+    }
+    return response;
+}
+
+Response RequestHandler::HandleJoinRequest(const RequestInfo& info) {
+    const auto map_id = GetQueryParam(info.target, "map"sv);
+    const model::Map* map = map_id ? game_.FindMap(*map_id) : nullptr;
+    if (!map) {
+        return MakeErrorResponse(http::status::not_found, "mapNotFound"sv, "Map not found"sv, info);
+    }
+    if (map->GetRoads().empty()) {
+        return MakeErrorResponse(http::status::bad_request, "invalidArgument"sv,
+                                 "Map has no roads"sv, info);
+    }
+
+    // Собака появляется в начале первой дороги карты
+    const model::Point start = map->GetRoads().front().GetStart();
+    const geom::Point2D position{static_cast<double>(start.x), static_cast<double>(start.y)};
+    // Сессия изменяется только в своём strand, поэтому ответ отправляется оттуда.
+    // Строки info ссылаются на запрос, который действителен до отправки ответа
+    using Deferred = DeferredResponse<StringResponse>;
+    return Deferred{[this, map, position, info](Deferred::Respond respond) {
+        const bool found = tick_scheduler_->AddDog(
+            *map, position, [this, map, info, respond](std::optional<size_t> dog) {
+                if (!dog) {
+                    return respond(MakeErrorResponse(http::status::service_unavailable,
+                                                     "sessionStopped"sv,
+                                                     "Game session is stopped"sv, info));
+                }
+                // Токен выдаётся после появления собаки, поэтому по любому выданному
+                // токену находится существующая собака
+                const auto token = players_.Add(*map, *dog).ToHex();
+                const json::object body{
+                    {"authToken"sv, json::string_view{token.data(), token.size()}},
+                    {"dogId"sv, *dog}};
+                StringResponse response =
+                    MakeStringResponse(http::status::ok, json::serialize(body), info);
+                response.set(http::field::cache_control, "no-cache"sv);
+                respond(std::move(response));
+            });
+        if (!found) {
+            respond(MakeErrorResponse(http::status::not_found, "mapNotFound"sv,
+                                      "Map not found"sv, info));
+        }
+    }};
+}
+
+StringResponse RequestHandler::HandleRouteStatsRequest(const RequestInfo& info) const {
+    const auto counters_to_json = [](std::string_view route, const RouteCounters& counters) {
+        return json::object{{"route"sv, route},
+                            {"hits"sv, counters.GetHits()},
+                            {"totalNs"sv, counters.GetTotalNs()},
+                            {"maxNs"sv, counters.GetMaxNs()}};
+    };
+    json::array routes;
+    routes.reserve(counters_.size());
+    for (size_t i = 0; i < NUM_API_ROUTES; ++i) {
+        routes.emplace_back(counters_to_json(API_ROUTER.GetRoute(i).pattern, counters_[i]));
+    }
+    routes.emplace_back(counters_to_json("unmatched"sv, counters_[UNMATCHED_COUNTER]));
+    routes.emplace_back(counters_to_json("static"sv, counters_[STATIC_FILES_COUNTER]));
+
+    const json::object body{{"routes"sv, std::move(routes)}};
+    StringResponse response = MakeStringResponse(http::status::ok, json::serialize(body), info);
+    response.set(http::field::cache_control, "no-cache"sv);
+    if (info.method == http::verb::head) {
+        response.body().clear();
+    }
+    return response;
+}
+
 }  // namespace http_handler
@@ -1,15 +1,56 @@
 #pragma once
+#include <array>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+#include "deferred_response.h"
 #include "http_server.h"
+#include "maps_cache.h"
 #include "model.h"
+#include "players.h"
+#include "router.h"
+#include "static_files.h"
+#include "tick_scheduler.h"
 
 namespace http_handler {
 namespace beast = boost::beast;
 namespace http = beast::http;
 
+// Ответ, тело которого представлено в виде строки
+using StringResponse = http::response<http::string_body>;
+// Ответ, тело которого ссылается на неизменяемый буфер без копирования
+using BufferResponse = http::response<http::span_body<const char>>;
+using Response = std::variant<StringResponse, BufferResponse, FileResponse,
+                              http_server::WebSocketUpgrade, DeferredResponse<StringResponse>,
+                              DeferredResponse<FileResponse>>;
+
+// Параметры запроса, от которых зависит ответ.
+// Все строки ссылаются на память запроса
+struct RequestInfo {
+    http::verb method;
+    std::string_view target;
+    std::string_view if_none_match;
+    std::string_view accept_encoding;
+    std::string_view range;
+    std::string_view authorization;
+    unsigned version;
+    bool keep_alive;
+    // Клиент просит перевести соединение на протокол WebSocket
+    bool websocket_upgrade;
+};
+
 class RequestHandler {
 public:
-    explicit RequestHandler(model::Game& game)
-        : game_{game} {
+    // Если static_root не задан, сервер не отдаёт статические файлы.
+    // Если tick_scheduler не задан, статистика тиков и состояние игры не отдаются
+    explicit RequestHandler(model::Game& game, std::filesystem::path static_root = {},
+                            const app::TickScheduler* tick_scheduler = nullptr)
+        : game_{game}
+        , maps_cache_{game}
+        , static_files_{std::move(static_root)}
+        , tick_scheduler_{tick_scheduler} {
     }
 
     RequestHandler(const RequestHandler&) = delete;
@@ -17,11 +58,51 @@ public:
 
     template <typename Body, typename Allocator, typename Send>
     void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-        // Обработать запрос request и отправить ответ, используя send
+        const RequestInfo info{req.method(),
+                               req.target(),
+                               req[http::field::if_none_match],
+                               req[http::field::accept_encoding],
+                               req[http::field::range],
+                               req[http::field::authorization],
+                               req.version(),
+                               req.keep_alive(),
+                               beast::websocket::is_upgrade(req)};
+        std::visit(
+            [&send](auto&& response) {
+                if constexpr (IS_DEFERRED_RESPONSE<std::decay_t<decltype(response)>>) {
+                    response.run([send](auto&& deferred) mutable {
+                        send(std::move(deferred));
+                    });
+                } else {
+                    send(std::move(response));
+                }
+            },
+            HandleRequest(info));
     }
 
 private:
+    // Счётчики маршрутов API, а после них - счётчики запросов, не соответствующих
+    // ни одному маршруту API, и запросов статических файлов
+    constexpr static size_t NUM_API_ROUTES = 8;
+    constexpr static size_t UNMATCHED_COUNTER = NUM_API_ROUTES;
+    constexpr static size_t STATIC_FILES_COUNTER = NUM_API_ROUTES + 1;
+    using Counters = std::array<RouteCounters, NUM_API_ROUTES + 2>;
+
+    Response HandleRequest(const RequestInfo& info);
+    Response HandleApiRequest(const RequestInfo& info, std::string_view path, size_t& counter);
+    StringResponse HandleTickStatsRequest(const RequestInfo& info) const;
+    StringResponse HandleRouteStatsRequest(const RequestInfo& info) const;
+    Response HandleGameStateRequest(const RequestInfo& info) const;
+    Response HandleGameStreamRequest(const RequestInfo& info) const;
+    StringResponse HandleStreamStatsRequest(const RequestInfo& info) const;
+    Response HandleJoinRequest(const RequestInfo& info);
+
     model::Game& game_;
+    MapsCache maps_cache_;
+    StaticFiles static_files_;
+    const app::TickScheduler* tick_scheduler_;
+    app::Players players_;
+    Counters counters_;
 };
 
 }  // namespace http_handler
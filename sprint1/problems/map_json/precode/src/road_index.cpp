@@ -0,0 +1,118 @@
+#include "road_index.h"
+
+namespace model {
+
+using namespace std::literals;
+
+std::string_view DirectionToString(Direction direction) {
+    switch (direction) {
+        case Direction::NORTH:
+            return "U"sv;
+        case Direction::SOUTH:
+            return "D"sv;
+        case Direction::WEST:
+            return "L"sv;
+        case Direction::EAST:
+            return "R"sv;
+    }
+    return ""sv;
+}
+
+void RoadIndex::AddHorizontalRoad(int y, int x0, int x1, size_t road_index) {
+    const auto [start, end] = std::minmax(x0, x1);
+    AddBounds({start - HALF_WIDTH, end + HALF_WIDTH, y - HALF_WIDTH, y + HALF_WIDTH}, road_index);
+    AddSegment(horizontal_, y, start, end, road_index);
+}
+
+void RoadIndex::AddVerticalRoad(int x, int y0, int y1, size_t road_index) {
+    const auto [start, end] = std::minmax(y0, y1);
+    AddBounds({x - HALF_WIDTH, x + HALF_WIDTH, start - HALF_WIDTH, end + HALF_WIDTH}, road_index);
+    AddSegment(vertical_, x, start, end, road_index);
+}
+
+void RoadIndex::AddBounds(RoadBounds bounds, size_t road_index) {
+    if (bounds_.size() <= road_index) {
+        bounds_.resize(road_index + 1);
+    }
+    bounds_[road_index] = bounds;
+}
+
+void RoadIndex::AddSegment(Lines& lines, int line_coord, int start, int end, size_t road_index) {
+    Line& line = lines[line_coord];
+    const Segment segment{start, end, road_index};
+    const auto pos = std::upper_bound(line.segments.begin(), line.segments.end(), segment,
+                                      [](const Segment& lhs, const Segment& rhs) {
+                                          return lhs.start < rhs.start;
+                                      });
+    line.segments.insert(pos, segment);
+    line.max_length = std::max(line.max_length, end - start);
+}
+
+std::vector<size_t> RoadIndex::FindRoadsCovering(geom::Point2D p) const {
+    std::vector<size_t> result;
+    ForEachRoadCovering(p, [&result](size_t road_index) {
+        result.push_back(road_index);
+    });
+    return result;
+}
+
+geom::Point2D RoadIndex::GetFurthestPoint(geom::Point2D p, Direction direction) const {
+    // Продвигаемся до дальней границы покрывающих точку дорог. Если в этой точке
+    // начинается другая дорога, уходящая дальше, продолжаем движение по ней
+    geom::Point2D furthest = p;
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        geom::Point2D next = furthest;
+        ForEachRoadCovering(furthest, [this, direction, &next](size_t road_index) {
+            const RoadBounds& bounds = bounds_[road_index];
+            switch (direction) {
+                case Direction::NORTH:
+                    next.y = std::min(next.y, bounds.min_y);
+                    break;
+                case Direction::SOUTH:
+                    next.y = std::max(next.y, bounds.max_y);
+                    break;
+                case Direction::WEST:
+                    next.x = std::min(next.x, bounds.min_x);
+                    break;
+                case Direction::EAST:
+                    next.x = std::max(next.x, bounds.max_x);
+                    break;
+            }
+        });
+        if (std::abs(next.x - furthest.x) > COORD_EPSILON
+            || std::abs(next.y - furthest.y) > COORD_EPSILON) {
+            furthest = next;
+            moved = true;
+        }
+    }
+    return furthest;
+}
+
+RoadIndex::MoveResult RoadIndex::Move(geom::Point2D p, Direction direction,
+                                      double distance) const {
+    const geom::Point2D furthest = GetFurthestPoint(p, direction);
+    const double available = std::abs(furthest.x - p.x) + std::abs(furthest.y - p.y);
+    if (distance >= available) {
+        return {furthest, true};
+    }
+
+    switch (direction) {
+        case Direction::NORTH:
+            p.y -= distance;
+            break;
+        case Direction::SOUTH:
+            p.y += distance;
+            break;
+        case Direction::WEST:
+            p.x -= distance;
+            break;
+        case Direction::EAST:
+            p.x += distance;
+            break;
+    }
+    return {p, false};
+}
+
+}  // namespace model
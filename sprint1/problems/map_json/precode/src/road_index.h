@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "geom.h"
+
+namespace model {
+
+enum class Direction {
+    NORTH,
+    EAST,
+    WEST,
+    SOUTH,
+};
+
+// Возвращает обозначение направления, передаваемое клиентам: "U", "D", "L" или "R"
+std::string_view DirectionToString(Direction direction);
+
+/*
+ * Пространственный индекс дорог карты.
+ * Дороги делятся на горизонтальные и вертикальные. Дороги каждого вида группируются
+ * по линиям (одинаковая координата y для горизонтальных, x - для вертикальных),
+ * а внутри линии хранятся отсортированными по началу отрезка.
+ * Дорога покрывает прямоугольник шириной 2 * HALF_WIDTH вокруг своего отрезка.
+ *
+ * Поиск дорог, покрывающих точку, выполняется за O(log k + m), где k - количество дорог
+ * на линии, а m - количество дорог, длина которых позволяет им покрыть точку.
+ */
+class RoadIndex {
+public:
+    // Половина ширины дороги
+    constexpr static double HALF_WIDTH = 0.4;
+    // Погрешность сравнения координат
+    constexpr static double COORD_EPSILON = 1e-9;
+
+    // Результат перемещения вдоль дорог
+    struct MoveResult {
+        geom::Point2D position;
+        // Перемещение было остановлено границей дороги
+        bool stopped;
+    };
+
+    // Добавляют в индекс дорогу с индексом road_index в массиве дорог карты
+    void AddHorizontalRoad(int y, int x0, int x1, size_t road_index);
+    void AddVerticalRoad(int x, int y0, int y1, size_t road_index);
+
+    // Вызывает fn(road_index) для каждой дороги, покрывающей точку p
+    template <typename Fn>
+    void ForEachRoadCovering(geom::Point2D p, Fn&& fn) const {
+        ForEachCovering(horizontal_, p.y, p.x, fn);
+        ForEachCovering(vertical_, p.x, p.y, fn);
+    }
+
+    // Возвращает индексы дорог, покрывающих точку p
+    std::vector<size_t> FindRoadsCovering(geom::Point2D p) const;
+
+    // Возвращает самую дальнюю точку, в которую можно попасть из p, двигаясь в направлении
+    // direction и не покидая дорог. Если точка p не лежит на дороге, возвращает p
+    geom::Point2D GetFurthestPoint(geom::Point2D p, Direction direction) const;
+
+    // Перемещает точку p на distance в направлении direction, не выходя за пределы дорог
+    MoveResult Move(geom::Point2D p, Direction direction, double distance) const;
+
+private:
+    struct Segment {
+        // Координаты концов отрезка вдоль линии, start <= end
+        int start;
+        int end;
+        size_t road_index;
+    };
+
+    struct Line {
+        // Отрезки, упорядоченные по start
+        std::vector<Segment> segments;
+        // Максимальная длина отрезка на линии. Ограничивает область поиска влево
+        int max_length = 0;
+    };
+
+    // Ключ - координата линии поперёк её направления
+    using Lines = std::unordered_map<int, Line>;
+
+    // Прямоугольник, покрываемый дорогой, с учётом её ширины
+    struct RoadBounds {
+        double min_x;
+        double max_x;
+        double min_y;
+        double max_y;
+    };
+
+    static void AddSegment(Lines& lines, int line_coord, int start, int end, size_t road_index);
+    void AddBounds(RoadBounds bounds, size_t road_index);
+
+    template <typename Fn>
+    static void ForEachCovering(const Lines& lines, double across, double along, Fn& fn) {
+        // Ширина дороги меньше 1, поэтому точку могут покрывать лишь линии с координатой
+        // из отрезка [across - HALF_WIDTH, across + HALF_WIDTH]. Отрезок расширен на
+        // COORD_EPSILON, чтобы не потерять линию из-за погрешности вычислений.
+        // Сами проверки покрытия выполняются теми же выражениями, что и при расчёте границ
+        // дороги, поэтому точка на границе дороги всегда считается покрытой
+        const auto first_line = static_cast<int>(std::ceil(across - HALF_WIDTH - COORD_EPSILON));
+        const auto last_line = static_cast<int>(std::floor(across + HALF_WIDTH + COORD_EPSILON));
+        for (int line_coord = first_line; line_coord <= last_line; ++line_coord) {
+            const auto line_it = lines.find(line_coord);
+            if (line_it == lines.end() || across < line_coord - HALF_WIDTH
+                || across > line_coord + HALF_WIDTH) {
+                continue;
+            }
+            const Line& line = line_it->second;
+            // Первый отрезок, начало которого с учётом ширины дороги лежит дальше точки
+            auto it = std::upper_bound(line.segments.begin(), line.segments.end(), along,
+                                       [](double value, const Segment& segment) {
+                                           return value < segment.start - HALF_WIDTH;
+                                       });
+            const double min_start = along - HALF_WIDTH - line.max_length - COORD_EPSILON;
+            while (it != line.segments.begin()) {
+                --it;
+                if (it->start < min_start) {
+                    break;
+                }
+                if (it->end + HALF_WIDTH >= along) {
+                    fn(it->road_index);
+                }
+            }
+        }
+    }
+
+    Lines horizontal_;
+    Lines vertical_;
+    // Индекс в векторе совпадает с индексом дороги на карте
+    std::vector<RoadBounds> bounds_;
+};
+
+}  // namespace model
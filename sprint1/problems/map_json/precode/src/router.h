@@ -0,0 +1,328 @@
+#pragma once
+#include <boost/beast/http/verb.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace http_handler {
+
+namespace http = boost::beast::http;
+
+// Тип параметра пути. Параметр задаётся в шаблоне маршрута как {name} или {name:uint}
+enum class ParamType {
+    // Непустой сегмент пути
+    STRING,
+    // Десятичное число без знака
+    UINT,
+};
+
+constexpr std::uint64_t MethodBit(http::verb method) noexcept {
+    return std::uint64_t{1} << static_cast<unsigned>(method);
+}
+
+// Описание маршрута: шаблон пути, например "/api/v1/maps/{id}", допустимые методы
+// и значение заголовка Allow, отправляемое при запросе другим методом
+struct RouteSpec {
+    std::string_view pattern;
+    std::uint64_t methods;
+    std::string_view allow;
+};
+
+// Результат сопоставления запроса с маршрутами.
+// Параметры пути ссылаются на память запроса
+struct RouteMatch {
+    constexpr static size_t MAX_PARAMS = 4;
+    constexpr static size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // Индекс маршрута в таблице или NOT_FOUND, если путь не соответствует ни одному маршруту
+    size_t route = NOT_FOUND;
+    // Допускает ли маршрут метод запроса
+    bool method_allowed = false;
+    std::array<std::string_view, MAX_PARAMS> params{};
+    size_t param_count = 0;
+
+    // Значение параметра типа UINT. Возвращает std::nullopt, если число не помещается
+    // в std::uint64_t
+    std::optional<std::uint64_t> GetUint(size_t index) const noexcept {
+        const std::string_view param = params[index];
+        std::uint64_t value = 0;
+        const auto [ptr, ec] = std::from_chars(param.data(), param.data() + param.size(), value);
+        if (ec != std::errc{} || ptr != param.data() + param.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+};
+
+/*
+ * Префиксное дерево маршрутов по сегментам пути.
+ * Цепочки литералов без ветвлений, например "api/v1", сжимаются в один узел.
+ *
+ * Дерево строится на этапе компиляции из таблицы маршрутов Routes (см. MakeRouter),
+ * поэтому ошибки в таблице, например повторяющиеся маршруты, обнаруживаются
+ * компилятором. Сопоставление пути не выделяет динамическую память, а его время
+ * зависит от глубины пути и числа вариантов на каждом уровне, а не от общего числа
+ * маршрутов. Сегменты-литералы проверяются раньше параметров.
+ */
+template <size_t NumRoutes, size_t MaxNodes>
+class Router {
+public:
+    constexpr explicit Router(const std::array<RouteSpec, NumRoutes>& routes)
+        : routes_{routes} {
+        nodes_[0] = Node{};
+        node_count_ = 1;
+        for (size_t route = 0; route < NumRoutes; ++route) {
+            AddRoute(route);
+        }
+        CompressChildren(0);
+    }
+
+    constexpr const RouteSpec& GetRoute(size_t index) const noexcept {
+        return routes_[index];
+    }
+
+    constexpr static size_t GetRouteCount() noexcept {
+        return NumRoutes;
+    }
+
+    // Сопоставляет путь запроса (без строки запроса) с маршрутами
+    RouteMatch Match(http::verb method, std::string_view path) const noexcept {
+        RouteMatch match;
+        if (!path.starts_with('/') || !MatchNode(0, path.substr(1), match)) {
+            return {};
+        }
+        match.method_allowed = (routes_[match.route].methods & MethodBit(method)) != 0;
+        return match;
+    }
+
+private:
+    constexpr static std::uint16_t NONE = 0xFFFF;
+
+    struct Node {
+        // Литерал: один или несколько сегментов, разделённых '/'. Для параметра не используется
+        std::string_view segment;
+        bool is_param = false;
+        ParamType param_type = ParamType::STRING;
+        // Маршрут, заканчивающийся в этом узле
+        size_t route = RouteMatch::NOT_FOUND;
+        std::uint16_t first_child = NONE;
+        std::uint16_t next_sibling = NONE;
+    };
+
+    constexpr static Node ParseSegment(std::string_view segment) {
+        Node node;
+        if (!segment.starts_with('{')) {
+            node.segment = segment;
+            return node;
+        }
+        if (!segment.ends_with('}')) {
+            throw std::logic_error("Unterminated route parameter");
+        }
+        node.is_param = true;
+        const std::string_view param = segment.substr(1, segment.size() - 2);
+        if (const size_t colon = param.find(':'); colon != std::string_view::npos) {
+            const std::string_view type = param.substr(colon + 1);
+            if (type == "uint") {
+                node.param_type = ParamType::UINT;
+            } else if (type != "string") {
+                throw std::logic_error("Unknown route parameter type");
+            }
+        }
+        return node;
+    }
+
+    constexpr static bool IsSameSegment(const Node& lhs, const Node& rhs) noexcept {
+        return lhs.is_param == rhs.is_param
+               && (lhs.is_param ? lhs.param_type == rhs.param_type : lhs.segment == rhs.segment);
+    }
+
+    constexpr void AddRoute(size_t route) {
+        std::string_view pattern = routes_[route].pattern;
+        if (!pattern.starts_with('/')) {
+            throw std::logic_error("Route pattern must start with '/'");
+        }
+        size_t node = 0;
+        size_t params = 0;
+        while (!pattern.empty()) {
+            pattern.remove_prefix(1);
+            const size_t end = std::min(pattern.find('/'), pattern.size());
+            const Node segment = ParseSegment(pattern.substr(0, end));
+            pattern.remove_prefix(end);
+            if (segment.is_param && ++params > RouteMatch::MAX_PARAMS) {
+                throw std::logic_error("Too many route parameters");
+            }
+            node = FindOrAddChild(node, segment);
+        }
+        if (nodes_[node].route != RouteMatch::NOT_FOUND) {
+            throw std::logic_error("Duplicate route");
+        }
+        nodes_[node].route = route;
+    }
+
+    // Возвращает потомка узла parent, соответствующего сегменту, добавляя его при необходимости.
+    // Новый литерал вставляется перед первым параметром, чтобы при сопоставлении
+    // литералы проверялись раньше параметров за один проход по списку
+    constexpr size_t FindOrAddChild(size_t parent, const Node& segment) {
+        std::uint16_t* link = &nodes_[parent].first_child;
+        std::uint16_t* insert_link = nullptr;
+        while (*link != NONE) {
+            if (IsSameSegment(nodes_[*link], segment)) {
+                return *link;
+            }
+            if (!insert_link && !segment.is_param && nodes_[*link].is_param) {
+                insert_link = link;
+            }
+            link = &nodes_[*link].next_sibling;
+        }
+        if (!insert_link) {
+            insert_link = link;
+        }
+        const auto index = static_cast<std::uint16_t>(node_count_++);
+        nodes_[index] = segment;
+        nodes_[index].next_sibling = *insert_link;
+        *insert_link = index;
+        return index;
+    }
+
+    // Сливает литерал, у которого единственный потомок - тоже литерал, с этим потомком.
+    // Литералы узла и потомка идут в шаблоне маршрута подряд через '/', поэтому
+    // объединённый литерал ссылается на тот же шаблон
+    constexpr void CompressChildren(size_t node) {
+        for (auto child = nodes_[node].first_child; child != NONE;
+             child = nodes_[child].next_sibling) {
+            Node& current = nodes_[child];
+            while (!current.is_param && current.route == RouteMatch::NOT_FOUND
+                   && current.first_child != NONE
+                   && nodes_[current.first_child].next_sibling == NONE
+                   && !nodes_[current.first_child].is_param) {
+                const Node& only_child = nodes_[current.first_child];
+                current.segment = {current.segment.data(),
+                                   current.segment.size() + 1 + only_child.segment.size()};
+                current.route = only_child.route;
+                current.first_child = only_child.first_child;
+            }
+            CompressChildren(child);
+        }
+    }
+
+    static bool MatchesParam(ParamType type, std::string_view segment) noexcept {
+        if (segment.empty()) {
+            return false;
+        }
+        if (type == ParamType::UINT) {
+            for (const char c : segment) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Сопоставляет остаток пути rest (без ведущего '/') с потомками узла node.
+    // Если подходящий литерал не приводит к маршруту, пробует параметры
+    bool MatchNode(size_t node, std::string_view rest, RouteMatch& match) const noexcept {
+        // Продолжает сопоставление с потомка child, которому соответствует rest[0, end)
+        const auto try_child = [&](size_t child, size_t end) {
+            if (end == rest.size()) {
+                if (nodes_[child].route == RouteMatch::NOT_FOUND) {
+                    return false;
+                }
+                match.route = nodes_[child].route;
+                return true;
+            }
+            return MatchNode(child, rest.substr(end + 1), match);
+        };
+
+        // Литералы в списке потомков расположены раньше параметров
+        auto child = nodes_[node].first_child;
+        for (; child != NONE && !nodes_[child].is_param; child = nodes_[child].next_sibling) {
+            const std::string_view literal = nodes_[child].segment;
+            if (rest.starts_with(literal)
+                && (rest.size() == literal.size() || rest[literal.size()] == '/')
+                && try_child(child, literal.size())) {
+                return true;
+            }
+        }
+        if (child == NONE) {
+            return false;
+        }
+
+        const size_t end = std::min(rest.find('/'), rest.size());
+        const std::string_view segment = rest.substr(0, end);
+        for (; child != NONE; child = nodes_[child].next_sibling) {
+            if (MatchesParam(nodes_[child].param_type, segment)) {
+                match.params[match.param_count++] = segment;
+                if (try_child(child, end)) {
+                    return true;
+                }
+                --match.param_count;
+            }
+        }
+        return false;
+    }
+
+    std::array<RouteSpec, NumRoutes> routes_;
+    std::array<Node, MaxNodes> nodes_{};
+    size_t node_count_ = 0;
+};
+
+// Верхняя оценка числа узлов дерева: корень и по узлу на каждый сегмент каждого маршрута
+template <size_t NumRoutes>
+constexpr size_t CountRouteNodes(const std::array<RouteSpec, NumRoutes>& routes) noexcept {
+    size_t count = 1;
+    for (const auto& route : routes) {
+        for (const char c : route.pattern) {
+            count += c == '/' ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// Строит маршрутизатор по таблице маршрутов, объявленной как constexpr
+template <const auto& Routes>
+constexpr auto MakeRouter() {
+    return Router<Routes.size(), CountRouteNodes(Routes)>{Routes};
+}
+
+/*
+ * Счётчики обращений к маршруту и времени формирования ответа.
+ * Запись и чтение можно выполнять из разных потоков без блокировок.
+ */
+class RouteCounters {
+public:
+    void Record(std::chrono::nanoseconds duration) noexcept {
+        const auto ns = static_cast<std::uint64_t>(duration.count());
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add(ns, std::memory_order_relaxed);
+        auto max_ns = max_ns_.load(std::memory_order_relaxed);
+        while (ns > max_ns
+               && !max_ns_.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t GetHits() const noexcept {
+        return hits_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t GetTotalNs() const noexcept {
+        return total_ns_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t GetMaxNs() const noexcept {
+        return max_ns_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> total_ns_{0};
+    std::atomic<std::uint64_t> max_ns_{0};
+};
+
+}  // namespace http_handler
@@ -0,0 +1,246 @@
+#include "socket_handoff.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Байт, сопровождающий дескриптор: sendmsg не передаёт управляющие данные без обычных
+constexpr char HANDOFF_MARKER = 'L';
+constexpr std::chrono::seconds RECEIVE_TIMEOUT{5};
+
+bool SendDescriptor(int connection, int descriptor) {
+    char marker = HANDOFF_MARKER;
+    iovec iov{&marker, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+    return ::sendmsg(connection, &message, MSG_NOSIGNAL) == 1;
+}
+
+std::optional<int> ReceiveDescriptor(int connection) {
+    char marker = 0;
+    iovec iov{&marker, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (::recvmsg(connection, &message, MSG_CMSG_CLOEXEC) != 1 || marker != HANDOFF_MARKER) {
+        return std::nullopt;
+    }
+
+    const cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS
+        || header->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return std::nullopt;
+    }
+    int descriptor = -1;
+    std::memcpy(&descriptor, CMSG_DATA(header), sizeof(int));
+    return descriptor;
+}
+
+// Слушающий сокет передаётся только процессу того же пользователя
+bool IsSameUser(int connection) {
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) {
+        return false;
+    }
+    return credentials.uid == ::geteuid();
+}
+
+}  // namespace
+
+SocketHandoff::SocketHandoff(net::io_context& ioc, std::string path, ListeningSocket socket,
+                             std::function<void()> on_handoff)
+    : path_{std::move(path)}
+    , socket_{socket}
+    , on_handoff_{std::move(on_handoff)}
+    , acceptor_{net::make_strand(ioc)}
+    , successor_{ioc} {
+    // Файл сокета мог остаться от аварийно завершившегося процесса. Работающего
+    // предшественника здесь нет: иначе преемник получил бы его слушающий сокет
+    ::unlink(path_.c_str());
+    acceptor_.open();
+    acceptor_.bind(net::local::stream_protocol::endpoint{path_});
+    // Подключиться к сокету может только владелец. Подключение, успевшее произойти
+    // до смены прав, отсеивает проверка пользователя в OnAccept
+    if (::chmod(path_.c_str(), S_IRUSR | S_IWUSR) != 0) {
+        throw sys::system_error{errno, sys::system_category(), "chmod handoff socket"};
+    }
+    struct stat path_stat{};
+    if (::stat(path_.c_str(), &path_stat) != 0) {
+        throw sys::system_error{errno, sys::system_category(), "stat handoff socket"};
+    }
+    path_device_ = path_stat.st_dev;
+    path_inode_ = path_stat.st_ino;
+    acceptor_.listen(1);
+    Accept();
+}
+
+void SocketHandoff::Accept() {
+    acceptor_.async_accept(successor_, [this](sys::error_code ec) {
+        OnAccept(ec);
+    });
+}
+
+SocketHandoff::~SocketHandoff() {
+    sys::error_code ec;
+    acceptor_.close(ec);
+    if (!handed_off_) {
+        UnlinkPath();
+    }
+    successor_.close(ec);
+}
+
+void SocketHandoff::UnlinkPath() const {
+    // Получив сокет, преемник может успеть создать по тому же пути свой файл для следующего
+    // перезапуска. Удаляется только файл, созданный этим объектом
+    struct stat path_stat{};
+    if (::stat(path_.c_str(), &path_stat) == 0 && path_stat.st_dev == path_device_
+        && path_stat.st_ino == path_inode_) {
+        ::unlink(path_.c_str());
+    }
+}
+
+void SocketHandoff::Stop() {
+    net::dispatch(acceptor_.get_executor(), [this] {
+        sys::error_code ec;
+        acceptor_.close(ec);
+    });
+}
+
+void SocketHandoff::ReleaseSuccessor() {
+    net::dispatch(acceptor_.get_executor(), [this] {
+        sys::error_code ec;
+        successor_.close(ec);
+    });
+}
+
+void SocketHandoff::OnAccept(sys::error_code ec) {
+    if (ec) {
+        if (ec != net::error::operation_aborted) {
+            ReportError(ec, "handoff accept"sv);
+        }
+        return;
+    }
+    if (!IsSameUser(successor_.native_handle())) {
+        ReportError(net::error::access_denied, "handoff peer"sv);
+        successor_.close(ec);
+        if (acceptor_.is_open()) {
+            Accept();
+        }
+        return;
+    }
+    if (!SendDescriptor(successor_.native_handle(), socket_.handle)) {
+        // Путь и acceptor остаются: следующий преемник сможет повторить попытку
+        ReportError(sys::error_code{errno, sys::system_category()}, "handoff send"sv);
+        successor_.close(ec);
+        if (acceptor_.is_open()) {
+            Accept();
+        }
+        return;
+    }
+    handed_off_ = true;
+    acceptor_.close(ec);
+    UnlinkPath();
+    on_handoff_();
+}
+
+std::optional<Predecessor> Predecessor::Connect(const std::string& path, tcp protocol) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Handoff socket path is too long");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+
+    const int connection = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection < 0) {
+        throw std::runtime_error("Failed to create handoff socket");
+    }
+    if (::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        // Предшественник не запущен
+        ::close(connection);
+        return std::nullopt;
+    }
+
+    const timeval timeout{static_cast<time_t>(RECEIVE_TIMEOUT.count()), 0};
+    ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    const auto descriptor = ReceiveDescriptor(connection);
+    if (!descriptor) {
+        ::close(connection);
+        throw std::runtime_error("Predecessor did not hand off its listening socket");
+    }
+    return Predecessor{connection, {protocol, *descriptor}};
+}
+
+Predecessor::Predecessor(int connection, ListeningSocket listening_socket) noexcept
+    : connection_{connection}
+    , listening_socket_{listening_socket} {
+}
+
+Predecessor::Predecessor(Predecessor&& other) noexcept
+    : connection_{std::exchange(other.connection_, -1)}
+    , listening_socket_{other.listening_socket_} {
+}
+
+Predecessor& Predecessor::operator=(Predecessor&& other) noexcept {
+    std::swap(connection_, other.connection_);
+    std::swap(listening_socket_, other.listening_socket_);
+    return *this;
+}
+
+Predecessor::~Predecessor() {
+    if (connection_ >= 0) {
+        ::close(connection_);
+    }
+}
+
+bool Predecessor::WaitForRelease(std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (left <= std::chrono::milliseconds::zero()) {
+            return false;
+        }
+        pollfd descriptor{connection_, POLLIN, 0};
+        if (::poll(&descriptor, 1, static_cast<int>(left.count())) <= 0) {
+            continue;
+        }
+        // Предшественник ничего не пишет после передачи сокета: чтение вернёт 0,
+        // когда он закроет соединение
+        char byte = 0;
+        if (::recv(connection_, &byte, 1, 0) <= 0) {
+            return true;
+        }
+    }
+}
+
+}  // namespace http_server
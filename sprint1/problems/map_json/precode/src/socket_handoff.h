@@ -0,0 +1,93 @@
+#pragma once
+#include "http_server.h"
+//
+#include <sys/types.h>
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace http_server {
+
+/*
+ * Передача слушающего сокета процессу-преемнику для перезапуска сервера без простоя.
+ *
+ * Работающий сервер ожидает преемника на UNIX-сокете, доступном только владельцу, и передаёт
+ * сокет, только если преемник запущен тем же пользователем. Преемник, запущенный с тем же путём,
+ * подключается к нему и получает дескриптор слушающего сокета (SCM_RIGHTS). Оба процесса
+ * работают с одной и той же очередью соединений ядра, поэтому порт ни на мгновение
+ * не закрывается: предшественник перестаёт принимать соединения и плавно завершается,
+ * а преемник продолжает их принимать.
+ *
+ * Предшественник держит соединение с преемником открытым, пока не сохранит состояние игры,
+ * поэтому преемник может дождаться сохранения. Преемник начинает принимать соединения,
+ * пока предшественник ещё отвечает своим клиентам.
+ */
+class SocketHandoff {
+public:
+    // Ожидает преемника на UNIX-сокете path. Когда преемник подключится, передаёт ему
+    // socket и вызывает on_handoff в потоке, обслуживающем ioc
+    SocketHandoff(net::io_context& ioc, std::string path, ListeningSocket socket,
+                  std::function<void()> on_handoff);
+
+    SocketHandoff(const SocketHandoff&) = delete;
+    SocketHandoff& operator=(const SocketHandoff&) = delete;
+
+    // Закрывает соединение с преемником, если его не закрыл ReleaseSuccessor
+    ~SocketHandoff();
+
+    // Прекращает ожидание преемника, например, когда сервер завершается по сигналу
+    // и скоро закроет слушающий сокет. Метод можно вызывать из любого потока
+    void Stop();
+
+    // Закрывает соединение с преемником, сообщая ему, что состояние игры сохранено.
+    // Метод можно вызывать из любого потока
+    void ReleaseSuccessor();
+
+private:
+    void Accept();
+    void OnAccept(sys::error_code ec);
+    void UnlinkPath() const;
+
+    std::string path_;
+    ListeningSocket socket_;
+    std::function<void()> on_handoff_;
+    // Обработчики acceptor-а вызываются в своём strand, поэтому Stop не конкурирует с ними
+    net::local::stream_protocol::acceptor acceptor_;
+    net::local::stream_protocol::socket successor_;
+    bool handed_off_ = false;
+    // Файл сокета, созданный этим объектом
+    dev_t path_device_ = 0;
+    ino_t path_inode_ = 0;
+};
+
+// Соединение преемника с работающим предшественником
+class Predecessor {
+public:
+    // Подключается к предшественнику через UNIX-сокет path и получает его слушающий сокет.
+    // Возвращает nullopt, если предшественника нет
+    static std::optional<Predecessor> Connect(const std::string& path, tcp protocol);
+
+    Predecessor(Predecessor&& other) noexcept;
+    Predecessor& operator=(Predecessor&& other) noexcept;
+
+    ~Predecessor();
+
+    const ListeningSocket& GetListeningSocket() const noexcept {
+        return listening_socket_;
+    }
+
+    // Ожидает, пока предшественник сохранит состояние игры и закроет соединение,
+    // но не дольше timeout. Возвращает false, если соединение не закрылось за это время
+    bool WaitForRelease(std::chrono::milliseconds timeout);
+
+private:
+    Predecessor(int connection, ListeningSocket listening_socket) noexcept;
+
+    int connection_;
+    ListeningSocket listening_socket_;
+};
+
+}  // namespace http_server
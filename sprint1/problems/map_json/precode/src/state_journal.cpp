@@ -0,0 +1,122 @@
+#include "state_journal.h"
+
+#include <boost/json.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace app {
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+DogState GetDogState(const model::DogStates& dogs, size_t dog) {
+    return {dog, dogs.GetPosition(dog), dogs.GetSpeed(dog), dogs.direction[dog]};
+}
+
+}  // namespace
+
+StateJournal::StateJournal(std::chrono::milliseconds tick_period, size_t history_size)
+    : tick_period_{tick_period}
+    , changes_(history_size) {
+    if (tick_period <= std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("State journal tick period must be positive");
+    }
+    if (history_size == 0) {
+        throw std::invalid_argument("State journal history size must be positive");
+    }
+}
+
+void StateJournal::RecordChanges(model::GameSession& session) {
+    const std::uint64_t tick = session.GetTickCount();
+    auto changes = std::make_shared<TickChanges>();
+    changes->tick = tick;
+    changes->dogs = session.TakeChangedDogs();
+
+    std::lock_guard lock{mutex_};
+    changes_[tick % changes_.size()] = std::move(changes);
+}
+
+void StateJournal::RecordState(const model::GameSession& session) {
+    const model::DogStates& dogs = session.GetDogs();
+    const std::uint64_t tick = session.GetTickCount();
+
+    auto full_state = std::make_shared<StateView>();
+    full_state->tick = tick;
+    full_state->tick_period = tick_period_;
+    full_state->dogs.reserve(dogs.Size());
+    for (size_t dog = 0; dog < dogs.Size(); ++dog) {
+        full_state->dogs.push_back(GetDogState(dogs, dog));
+    }
+
+    std::lock_guard lock{mutex_};
+    full_state_ = std::move(full_state);
+}
+
+StateView StateJournal::GetState(std::optional<std::uint64_t> since) const {
+    std::shared_ptr<const StateView> full_state;
+    std::vector<TickChangesPtr> changes;
+    bool is_delta = false;
+    {
+        std::lock_guard lock{mutex_};
+        full_state = full_state_;
+        if (!full_state) {
+            return {};
+        }
+        const std::uint64_t tick = full_state->tick;
+        if (since && *since <= tick && tick - *since < changes_.size()) {
+            changes.reserve(tick - *since);
+            is_delta = true;
+            for (std::uint64_t t = *since + 1; t <= tick && is_delta; ++t) {
+                // Набор изменений тика мог быть не записан, если журнал начал вести
+                // записи позже этого тика
+                const TickChangesPtr& tick_changes = changes_[t % changes_.size()];
+                is_delta = tick_changes && tick_changes->tick == t;
+                changes.push_back(tick_changes);
+            }
+        }
+    }
+    if (!is_delta) {
+        return *full_state;
+    }
+
+    // Собака могла меняться в нескольких тиках, а после изменения продолжить движение,
+    // поэтому отправляется её состояние из полного состояния на тик ответа
+    StateView view{full_state->tick, false, {}, tick_period_};
+    std::vector<bool> is_added(full_state->dogs.size());
+    for (const TickChangesPtr& tick_changes : changes) {
+        for (const size_t dog : tick_changes->dogs) {
+            if (!is_added[dog]) {
+                is_added[dog] = true;
+                view.dogs.push_back(full_state->dogs[dog]);
+            }
+        }
+    }
+    std::sort(view.dogs.begin(), view.dogs.end(), [](const DogState& lhs, const DogState& rhs) {
+        return lhs.id < rhs.id;
+    });
+    return view;
+}
+
+std::shared_ptr<const StateView> StateJournal::GetFullState() const {
+    std::lock_guard lock{mutex_};
+    return full_state_;
+}
+
+std::string SerializeState(const StateView& state) {
+    json::object players;
+    players.reserve(state.dogs.size());
+    for (const DogState& dog : state.dogs) {
+        players.emplace(std::to_string(dog.id),
+                        json::object{{"pos"sv, json::array{dog.position.x, dog.position.y}},
+                                     {"speed"sv, json::array{dog.speed.x, dog.speed.y}},
+                                     {"dir"sv, model::DirectionToString(dog.direction)}});
+    }
+    return json::serialize(json::object{{"tick"sv, state.tick},
+                                        {"full"sv, state.full},
+                                        {"tickPeriod"sv, state.tick_period.count()},
+                                        {"players"sv, std::move(players)}});
+}
+
+}  // namespace app
@@ -0,0 +1,93 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "game_session.h"
+
+namespace app {
+
+// Состояние собаки, передаваемое клиентам
+struct DogState {
+    size_t id;
+    geom::Point2D position;
+    geom::Vec2D speed;
+    model::Direction direction;
+};
+
+// Состояние сессии, отправляемое клиенту: полное или только изменившиеся собаки
+struct StateView {
+    // Тик, по состоянию на который сформировано состояние
+    std::uint64_t tick = 0;
+    // true - dogs содержит всех собак, false - только изменившихся после запрошенного тика
+    bool full = true;
+    std::vector<DogState> dogs;
+    // Длительность тика, по которой клиент вычисляет положение движущихся собак
+    std::chrono::milliseconds tick_period{0};
+};
+
+/*
+ * Журнал состояний игровой сессии для ответов на запросы состояния игры.
+ *
+ * После каждого тика сессии журнал сохраняет номера собак, изменившихся за этот тик, а полное
+ * состояние сохраняется реже - один раз на срабатывание таймера, даже если сессия догоняла
+ * реальное время несколькими тиками. Наборы изменений последних history_size тиков хранятся
+ * в кольцевом буфере,
+ * поэтому клиенту, сообщившему последний полученный тик, можно отправить только собак,
+ * изменившихся после него. Если клиент отстал больше чем на history_size тиков,
+ * он получает полное состояние.
+ *
+ * Движение с постоянной скоростью изменением не считается: изменившимися считаются
+ * добавленные собаки, собаки с новым действием и остановившиеся у края дороги.
+ * Изменения содержат состояние собак на тик ответа, а положение остальных собак клиент
+ * вычисляет сам: position + speed * (tick - since) * tick_period.
+ *
+ * RecordChanges и RecordState вызываются в strand сессии, GetState - из любого потока. Под мьютексом
+ * выполняется только копирование указателей на неизменяемые наборы изменений.
+ */
+class StateJournal {
+public:
+    constexpr static size_t DEFAULT_HISTORY_SIZE = 128;
+
+    explicit StateJournal(std::chrono::milliseconds tick_period,
+                          size_t history_size = DEFAULT_HISTORY_SIZE);
+
+    // Сохраняет номера собак, изменившихся с предыдущего вызова. Вызывается после каждого тика
+    void RecordChanges(model::GameSession& session);
+
+    // Сохраняет полное состояние сессии. Клиентам отправляется состояние на тик последнего
+    // вызова, поэтому после серии тиков достаточно одного вызова
+    void RecordState(const model::GameSession& session);
+
+    // Возвращает изменения после тика since, либо полное состояние, если since не задан,
+    // слишком стар или ещё не наступил
+    StateView GetState(std::optional<std::uint64_t> since) const;
+
+    // Возвращает последнее сохранённое полное состояние без копирования списка собак
+    // или nullptr, если состояние ещё не сохранялось
+    std::shared_ptr<const StateView> GetFullState() const;
+
+private:
+    struct TickChanges {
+        std::uint64_t tick;
+        std::vector<size_t> dogs;
+    };
+
+    using TickChangesPtr = std::shared_ptr<const TickChanges>;
+
+    std::chrono::milliseconds tick_period_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const StateView> full_state_;
+    // Наборы изменений: changes_[tick % changes_.size()] хранит изменения тика tick
+    std::vector<TickChangesPtr> changes_;
+};
+
+// Сериализует состояние в JSON вида {"tick": 10, "full": false, "tickPeriod": 50,
+// "players": {"0": {"pos": [x, y], "speed": [vx, vy], "dir": "U"}}}. tickPeriod - в миллисекундах
+std::string SerializeState(const StateView& state);
+
+}  // namespace app
@@ -0,0 +1,114 @@
+#include "state_snapshot.h"
+
+#include <boost/json.hpp>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace app {
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+model::Direction DirectionFromString(std::string_view direction) {
+    if (direction == "U"sv) {
+        return model::Direction::NORTH;
+    }
+    if (direction == "D"sv) {
+        return model::Direction::SOUTH;
+    }
+    if (direction == "L"sv) {
+        return model::Direction::WEST;
+    }
+    if (direction == "R"sv) {
+        return model::Direction::EAST;
+    }
+    throw std::runtime_error("Invalid dog direction in state snapshot: "s
+                             + std::string{direction});
+}
+
+json::object SessionToJson(const model::GameSession& session) {
+    const model::DogStates& dogs = session.GetDogs();
+    json::array dogs_json;
+    dogs_json.reserve(dogs.Size());
+    for (size_t dog = 0; dog < dogs.Size(); ++dog) {
+        dogs_json.emplace_back(json::object{{"pos"sv, json::array{dogs.x[dog], dogs.y[dog]}},
+                                            {"speed"sv, json::array{dogs.speed_x[dog],
+                                                                    dogs.speed_y[dog]}},
+                                            {"dir"sv, model::DirectionToString(dogs.direction[dog])}});
+    }
+    return {{"id"sv, session.GetMap().GetId()->GetView()},
+            {"tick"sv, session.GetTickCount()},
+            {"dogs"sv, std::move(dogs_json)}};
+}
+
+void RestoreSession(model::GameSession& session, const json::object& snapshot) {
+    if (session.GetDogs().Size() != 0) {
+        throw std::logic_error("State snapshot can be loaded only into empty sessions");
+    }
+    for (const json::value& dog_value : snapshot.at("dogs"sv).as_array()) {
+        const json::object& dog_json = dog_value.as_object();
+        const json::array& pos = dog_json.at("pos"sv).as_array();
+        const json::array& speed = dog_json.at("speed"sv).as_array();
+        const size_t dog = session.AddDog({pos.at(0).to_number<double>(),
+                                           pos.at(1).to_number<double>()});
+        // Собака движется вдоль одной из осей, поэтому модуль скорости - сумма модулей
+        // её проекций
+        session.SetDogAction(
+            dog, DirectionFromString(dog_json.at("dir"sv).as_string()),
+            std::abs(speed.at(0).to_number<double>()) + std::abs(speed.at(1).to_number<double>()));
+    }
+    session.SetTickCount(snapshot.at("tick"sv).to_number<std::uint64_t>());
+}
+
+}  // namespace
+
+void SaveStateSnapshot(const GameSessions& sessions, const std::filesystem::path& path) {
+    json::array maps;
+    maps.reserve(sessions.size());
+    for (const auto& session : sessions) {
+        maps.emplace_back(SessionToJson(*session));
+    }
+    const std::string content = json::serialize(json::object{{"maps"sv, std::move(maps)}});
+
+    // Снимок пишется во временный файл и заменяет прежний только после успешной записи
+    std::filesystem::path tmp_path = path;
+    tmp_path += ".tmp"sv;
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Failed to write state snapshot "s + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+bool LoadStateSnapshot(const GameSessions& sessions, const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+
+    const json::value snapshot = json::parse(content.str());
+    for (const json::value& map_value : snapshot.at("maps"sv).as_array()) {
+        const json::object& map_json = map_value.as_object();
+        const std::string_view id = map_json.at("id"sv).as_string();
+        for (const auto& session : sessions) {
+            if (session->GetMap().GetId()->GetView() == id) {
+                RestoreSession(*session, map_json);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace app
@@ -0,0 +1,22 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "game_session.h"
+
+namespace app {
+
+using GameSessions = std::vector<std::unique_ptr<model::GameSession>>;
+
+// Сохраняет состояние игровых сессий в файл path в формате JSON.
+// Файл заменяется атомарно, поэтому прерванная запись не портит предыдущий снимок.
+// Сессии не должны изменяться во время записи
+void SaveStateSnapshot(const GameSessions& sessions, const std::filesystem::path& path);
+
+// Восстанавливает состояние сессий из снимка, сохранённого SaveStateSnapshot.
+// Сессии сопоставляются по идентификатору карты и должны быть пустыми. Сессии карт,
+// которых нет в снимке, не изменяются. Возвращает false, если файла снимка нет
+bool LoadStateSnapshot(const GameSessions& sessions, const std::filesystem::path& path);
+
+}  // namespace app
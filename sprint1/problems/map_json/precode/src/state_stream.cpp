@@ -0,0 +1,74 @@
+#include "state_stream.h"
+
+#include <algorithm>
+
+namespace app {
+
+StateFrame::StateFrame(const StateView& changes, std::optional<std::uint64_t> base,
+                       std::shared_ptr<const StateView> full_state,
+                       Clock::time_point publish_time)
+    : tick_{changes.tick}
+    , base_{base}
+    , changes_{SerializeState(changes)}
+    , full_state_{std::move(full_state)}
+    , publish_time_{publish_time} {
+}
+
+const std::string& StateFrame::GetFullState() const {
+    if (!base_) {
+        return changes_;
+    }
+    std::call_once(full_state_once_, [this] {
+        serialized_full_state_ = SerializeState(*full_state_);
+    });
+    return serialized_full_state_;
+}
+
+void StateStream::Subscribe(const std::shared_ptr<StreamSubscriber>& subscriber) {
+    std::lock_guard lock{mutex_};
+    subscribers_.push_back(subscriber);
+    stats_.subscribers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StateStream::Publish(const StateJournal& journal) {
+    const auto start = StateFrame::Clock::now();
+    active_.clear();
+    {
+        std::lock_guard lock{mutex_};
+        const auto expired = std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                            [this](const std::weak_ptr<StreamSubscriber>& s) {
+                                                auto subscriber = s.lock();
+                                                if (!subscriber) {
+                                                    return true;
+                                                }
+                                                active_.push_back(std::move(subscriber));
+                                                return false;
+                                            });
+        stats_.subscribers.fetch_sub(subscribers_.end() - expired, std::memory_order_relaxed);
+        subscribers_.erase(expired, subscribers_.end());
+    }
+    if (active_.empty()) {
+        // Следующий подписчик всё равно начнёт с полного состояния
+        last_published_.reset();
+        return;
+    }
+
+    const StateView changes = journal.GetState(last_published_);
+    if (last_published_ && changes.tick == *last_published_) {
+        // После предыдущей публикации тиков не было
+        return;
+    }
+    auto frame = std::make_shared<const StateFrame>(
+        changes, changes.full ? std::nullopt : last_published_, journal.GetFullState(), start);
+    last_published_ = changes.tick;
+    for (const auto& subscriber : active_) {
+        subscriber->Push(frame);
+    }
+    // Подписчики освобождаются вне мьютекса: деструктор подписчика может быть нетривиальным
+    active_.clear();
+
+    stats_.frames_published.fetch_add(1, std::memory_order_relaxed);
+    stats_.fan_out.Record(StateFrame::Clock::now() - start);
+}
+
+}  // namespace app
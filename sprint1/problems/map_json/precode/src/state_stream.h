@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "duration_histogram.h"
+#include "state_journal.h"
+
+namespace app {
+
+/*
+ * Кадр с состоянием игровой сессии после тика.
+ * Создаётся один раз на тик и разделяется всеми подписчиками сессии, поэтому изменения
+ * сериализуются однократно, сколько бы клиентов ни было подключено.
+ */
+class StateFrame {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StateFrame(const StateView& changes, std::optional<std::uint64_t> base,
+               std::shared_ptr<const StateView> full_state, Clock::time_point publish_time);
+
+    std::uint64_t GetTick() const noexcept {
+        return tick_;
+    }
+
+    // Тик, после которого накоплены изменения кадра.
+    // nullopt, если кадр сам содержит полное состояние
+    std::optional<std::uint64_t> GetBase() const noexcept {
+        return base_;
+    }
+
+    // Подходит ли кадр клиенту, последним получившим состояние на тик last_sent
+    bool IsApplicable(std::optional<std::uint64_t> last_sent) const noexcept {
+        return !base_ || (last_sent && *last_sent >= *base_);
+    }
+
+    // Сериализованные изменения (либо полное состояние, если GetBase() пуст)
+    const std::string& GetChanges() const noexcept {
+        return changes_;
+    }
+
+    // Сериализованное полное состояние на тик кадра. Нужно только клиентам, пропустившим
+    // кадры, поэтому сериализуется при первом обращении, один раз для всех
+    const std::string& GetFullState() const;
+
+    Clock::time_point GetPublishTime() const noexcept {
+        return publish_time_;
+    }
+
+private:
+    std::uint64_t tick_;
+    std::optional<std::uint64_t> base_;
+    std::string changes_;
+    std::shared_ptr<const StateView> full_state_;
+    mutable std::once_flag full_state_once_;
+    mutable std::string serialized_full_state_;
+    Clock::time_point publish_time_;
+};
+
+using StateFramePtr = std::shared_ptr<const StateFrame>;
+
+// Получатель кадров состояния
+class StreamSubscriber {
+public:
+    // Вызывается в strand игровой сессии и не должен блокироваться
+    virtual void Push(StateFramePtr frame) = 0;
+
+protected:
+    ~StreamSubscriber() = default;
+};
+
+// Статистика рассылки состояния одной игровой сессии
+struct StreamStats {
+    // Подписчики, подключённые в данный момент
+    std::atomic<std::uint64_t> subscribers{0};
+    std::atomic<std::uint64_t> frames_published{0};
+    std::atomic<std::uint64_t> frames_sent{0};
+    // Кадры, вытесненные более новым кадром, пока клиент не успевал их принять
+    std::atomic<std::uint64_t> frames_dropped{0};
+    // Полные состояния, отправленные клиентам вместо изменений после пропуска кадров
+    std::atomic<std::uint64_t> full_frames_sent{0};
+    // Сериализация кадра и передача его всем подписчикам
+    DurationHistogram fan_out;
+    // Время от публикации кадра до окончания его отправки клиенту
+    DurationHistogram delivery;
+};
+
+/*
+ * Рассылка состояния игровой сессии подписчикам.
+ *
+ * Publish вызывается в strand сессии после тика: формирует кадр с изменениями после
+ * предыдущего опубликованного тика и передаёт его каждому подписчику. Пока подписчиков
+ * нет, кадры не формируются. Subscribe можно вызывать из любого потока.
+ */
+class StateStream {
+public:
+    StateStream() = default;
+
+    StateStream(const StateStream&) = delete;
+    StateStream& operator=(const StateStream&) = delete;
+
+    // Подписчик остаётся подписанным, пока существует объект, на который указывает subscriber
+    void Subscribe(const std::shared_ptr<StreamSubscriber>& subscriber);
+
+    void Publish(const StateJournal& journal);
+
+    StreamStats& GetStats() noexcept {
+        return stats_;
+    }
+
+    const StreamStats& GetStats() const noexcept {
+        return stats_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::weak_ptr<StreamSubscriber>> subscribers_;
+    // Подписчики, полученные при последней публикации. Переиспользуется между тиками
+    std::vector<std::shared_ptr<StreamSubscriber>> active_;
+    // Тик последнего опубликованного кадра. Используется только в strand сессии
+    std::optional<std::uint64_t> last_published_;
+    StreamStats stats_;
+};
+
+}  // namespace app
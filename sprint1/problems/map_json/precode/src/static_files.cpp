@@ -0,0 +1,558 @@
+#include "static_files.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <boost/asio/post.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace http_handler {
+
+namespace fs = std::filesystem;
+namespace bip = boost::interprocess;
+using namespace std::literals;
+
+struct StaticFiles::FileEntry {
+    fs::path path;
+    std::uint64_t size = 0;
+    std::string_view mime_type;
+    // Содержимое больших файлов отображается в память при индексации
+    std::shared_ptr<const bip::mapped_region> mapping;
+    FileContent gzip;
+    FileContent brotli;
+};
+
+namespace {
+
+struct ContentType {
+    ContentType() = delete;
+    constexpr static std::string_view TEXT_PLAIN = "text/plain"sv;
+    constexpr static std::string_view OCTET_STREAM = "application/octet-stream"sv;
+};
+
+constexpr std::array<std::pair<std::string_view, std::string_view>, 21> MIME_TYPES{{
+    {"htm"sv, "text/html"sv},
+    {"html"sv, "text/html"sv},
+    {"css"sv, "text/css"sv},
+    {"txt"sv, "text/plain"sv},
+    {"js"sv, "text/javascript"sv},
+    {"json"sv, "application/json"sv},
+    {"xml"sv, "application/xml"sv},
+    {"png"sv, "image/png"sv},
+    {"jpg"sv, "image/jpeg"sv},
+    {"jpe"sv, "image/jpeg"sv},
+    {"jpeg"sv, "image/jpeg"sv},
+    {"gif"sv, "image/gif"sv},
+    {"bmp"sv, "image/bmp"sv},
+    {"ico"sv, "image/vnd.microsoft.icon"sv},
+    {"tiff"sv, "image/tiff"sv},
+    {"tif"sv, "image/tiff"sv},
+    {"svg"sv, "image/svg+xml"sv},
+    {"svgz"sv, "image/svg+xml"sv},
+    {"mp3"sv, "audio/mpeg"sv},
+    {"gz"sv, "application/gzip"sv},
+    {"br"sv, "application/x-brotli"sv},
+}};
+
+// Форматы, которые уже сжаты и не выигрывают от gzip. Сюда входят и готовые файлы .gz/.br,
+// лежащие рядом с исходными: сжимать их повторно бессмысленно
+constexpr std::array<std::string_view, 7> COMPRESSED_MIME_TYPES{
+    "image/png"sv,
+    "image/jpeg"sv,
+    "image/gif"sv,
+    "audio/mpeg"sv,
+    "image/vnd.microsoft.icon"sv,
+    "application/gzip"sv,
+    "application/x-brotli"sv,
+};
+
+// Файлы меньше этого размера не сжимаются: выигрыш не окупает заголовок Content-Encoding
+constexpr std::uint64_t MIN_COMPRESSIBLE_SIZE = 256;
+
+char ToLower(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char l, char r) {
+        return ToLower(l) == ToLower(r);
+    });
+}
+
+std::string_view Trim(std::string_view str) noexcept {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+int HexToInt(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = ToLower(c);
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Проверяет, что параметр q в элементе Accept-Encoding равен нулю ("q=0", "q=0.000")
+bool HasZeroQuality(std::string_view params) noexcept {
+    while (!params.empty()) {
+        const auto semicolon_pos = params.find(';');
+        auto param = Trim(params.substr(0, semicolon_pos));
+        params = semicolon_pos == std::string_view::npos ? ""sv : params.substr(semicolon_pos + 1);
+        if (param.size() < 2 || ToLower(param[0]) != 'q' || param[1] != '=') {
+            continue;
+        }
+        param.remove_prefix(2);
+        return !param.empty() && std::all_of(param.begin(), param.end(), [](char c) {
+            return c == '0' || c == '.';
+        });
+    }
+    return false;
+}
+
+// Проверяет, содержит ли путь сегмент "..", ведущий за пределы корневого каталога
+bool HasParentSegment(std::string_view path) noexcept {
+    while (!path.empty()) {
+        const auto slash_pos = path.find('/');
+        if (path.substr(0, slash_pos) == ".."sv) {
+            return true;
+        }
+        if (slash_pos == std::string_view::npos) {
+            break;
+        }
+        path.remove_prefix(slash_pos + 1);
+    }
+    return false;
+}
+
+bool IsCompressible(std::string_view mime_type) noexcept {
+    return std::find(COMPRESSED_MIME_TYPES.begin(), COMPRESSED_MIME_TYPES.end(), mime_type)
+           == COMPRESSED_MIME_TYPES.end();
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("Failed to open file "s + path.string());
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return std::move(content).str();
+}
+
+// Сжимает data в формате gzip
+std::optional<std::string> Gzip(std::string_view data) {
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+        return std::nullopt;
+    }
+
+    std::string compressed(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+
+    const int result = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        return std::nullopt;
+    }
+    compressed.resize(stream.total_out);
+    return compressed;
+}
+
+FileResponse MakeTextResponse(http::status status, std::string_view text,
+                              const StaticFileRequest& request) {
+    FileResponse response(status, request.version);
+    response.set(http::field::content_type, ContentType::TEXT_PLAIN);
+    // Текст ошибки - строковый литерал, поэтому владелец буфера не нужен
+    response.body() = {nullptr, text.data(), text.size()};
+    response.content_length(text.size());
+    response.keep_alive(request.keep_alive);
+    return response;
+}
+
+// Задаёт тело ответа на запрос файла размером file_size и заголовки, зависящие от диапазона
+void SetFileBody(FileResponse& response, SharedBufferBody::value_type body,
+                 RangeParseResult range_result, const ByteRange& range, std::uint64_t file_size,
+                 http::verb method) {
+    response.body() = std::move(body);
+    if (range_result == RangeParseResult::RANGE) {
+        std::array<char, 64> content_range;
+        const int size = std::snprintf(content_range.data(), content_range.size(),
+                                       "bytes %llu-%llu/%llu",
+                                       static_cast<unsigned long long>(range.first),
+                                       static_cast<unsigned long long>(range.last),
+                                       static_cast<unsigned long long>(file_size));
+        response.result(http::status::partial_content);
+        response.set(http::field::content_range,
+                     std::string_view{content_range.data(), static_cast<std::size_t>(size)});
+        response.body().data += range.first;
+        response.body().size = range.last - range.first + 1;
+    }
+
+    response.content_length(response.body().size);
+    if (method == http::verb::head) {
+        response.body() = {};
+    }
+}
+
+}  // namespace
+
+std::optional<std::string_view> UrlDecode(std::string_view encoded,
+                                          std::span<char> out) noexcept {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < encoded.size(); ++i) {
+        if (size == out.size()) {
+            return std::nullopt;
+        }
+        char c = encoded[i];
+        if (c == '%') {
+            if (i + 2 >= encoded.size()) {
+                return std::nullopt;
+            }
+            const int high = HexToInt(encoded[i + 1]);
+            const int low = HexToInt(encoded[i + 2]);
+            if (high < 0 || low < 0) {
+                return std::nullopt;
+            }
+            c = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+        // Символ '+' в пути URL не заменяется на пробел: так кодируются только query-параметры
+        out[size++] = c;
+    }
+    return std::string_view{out.data(), size};
+}
+
+std::string_view GetMimeType(std::string_view path) noexcept {
+    const auto last_slash_pos = path.rfind('/');
+    const auto file_name
+        = last_slash_pos == std::string_view::npos ? path : path.substr(last_slash_pos + 1);
+    const auto dot_pos = file_name.rfind('.');
+    if (dot_pos == std::string_view::npos) {
+        return ContentType::OCTET_STREAM;
+    }
+    const auto extension = file_name.substr(dot_pos + 1);
+    for (const auto& [ext, mime_type] : MIME_TYPES) {
+        if (EqualsIgnoreCase(ext, extension)) {
+            return mime_type;
+        }
+    }
+    return ContentType::OCTET_STREAM;
+}
+
+ContentEncoding ChooseEncoding(std::string_view accept_encoding, bool has_gzip,
+                               bool has_brotli) noexcept {
+    bool accepts_gzip = false;
+    bool accepts_brotli = false;
+    while (!accept_encoding.empty()) {
+        const auto comma_pos = accept_encoding.find(',');
+        const auto item = accept_encoding.substr(0, comma_pos);
+        accept_encoding
+            = comma_pos == std::string_view::npos ? ""sv : accept_encoding.substr(comma_pos + 1);
+
+        const auto semicolon_pos = item.find(';');
+        const auto coding = Trim(item.substr(0, semicolon_pos));
+        if (semicolon_pos != std::string_view::npos
+            && HasZeroQuality(item.substr(semicolon_pos + 1))) {
+            continue;
+        }
+        if (EqualsIgnoreCase(coding, "br"sv)) {
+            accepts_brotli = true;
+        } else if (EqualsIgnoreCase(coding, "gzip"sv)) {
+            accepts_gzip = true;
+        }
+    }
+
+    if (has_brotli && accepts_brotli) {
+        return ContentEncoding::BROTLI;
+    }
+    if (has_gzip && accepts_gzip) {
+        return ContentEncoding::GZIP;
+    }
+    return ContentEncoding::IDENTITY;
+}
+
+RangeParseResult ParseRange(std::string_view range, std::uint64_t file_size,
+                            ByteRange& result) noexcept {
+    constexpr auto UNIT_PREFIX = "bytes="sv;
+    range = Trim(range);
+    if (!range.starts_with(UNIT_PREFIX) || range.find(',') != std::string_view::npos) {
+        return RangeParseResult::NONE;
+    }
+    range.remove_prefix(UNIT_PREFIX.size());
+
+    const auto dash_pos = range.find('-');
+    if (dash_pos == std::string_view::npos) {
+        return RangeParseResult::NONE;
+    }
+    const auto first_str = Trim(range.substr(0, dash_pos));
+    const auto last_str = Trim(range.substr(dash_pos + 1));
+
+    auto parse = [](std::string_view str, std::uint64_t& value) {
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc{} && ptr == str.data() + str.size();
+    };
+
+    if (first_str.empty()) {
+        // bytes=-n: последние n байтов файла
+        std::uint64_t suffix_length = 0;
+        if (!parse(last_str, suffix_length)) {
+            return RangeParseResult::NONE;
+        }
+        if (suffix_length == 0 || file_size == 0) {
+            return RangeParseResult::UNSATISFIABLE;
+        }
+        result = {file_size - std::min(suffix_length, file_size), file_size - 1};
+        return RangeParseResult::RANGE;
+    }
+
+    std::uint64_t first = 0;
+    if (!parse(first_str, first)) {
+        return RangeParseResult::NONE;
+    }
+    std::uint64_t last = file_size == 0 ? 0 : file_size - 1;
+    if (!last_str.empty()) {
+        if (!parse(last_str, last)) {
+            return RangeParseResult::NONE;
+        }
+        if (last < first) {
+            return RangeParseResult::NONE;
+        }
+    }
+    if (first >= file_size) {
+        return RangeParseResult::UNSATISFIABLE;
+    }
+    result = {first, std::min(last, file_size - 1)};
+    return RangeParseResult::RANGE;
+}
+
+FileContent HotFileCache::Find(const void* key) {
+    std::lock_guard lock{mutex_};
+    const auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    return it->second.content;
+}
+
+void HotFileCache::Insert(const void* key, FileContent content) {
+    const std::size_t content_size = content->size();
+    if (content_size > capacity_) {
+        return;
+    }
+
+    std::lock_guard lock{mutex_};
+    if (entries_.contains(key)) {
+        // Файл уже успел добавить другой поток
+        return;
+    }
+    while (size_ + content_size > capacity_) {
+        const auto victim = entries_.find(lru_.back());
+        size_ -= victim->second.content->size();
+        entries_.erase(victim);
+        lru_.pop_back();
+    }
+    lru_.push_front(key);
+    entries_.emplace(key, CacheEntry{std::move(content), lru_.begin()});
+    size_ += content_size;
+}
+
+StaticFiles::StaticFiles(fs::path root, StaticFilesOptions options)
+    : root_{std::move(root)}
+    , options_{options}
+    , cache_{options.cache_capacity}
+    , blocking_pool_{std::max<std::size_t>(1, options.blocking_threads)} {
+    if (!root_.empty()) {
+        IndexDirectory();
+    }
+}
+
+StaticFiles::~StaticFiles() = default;
+
+void StaticFiles::IndexDirectory() {
+    root_ = fs::weakly_canonical(root_);
+    for (const auto& dir_entry : fs::recursive_directory_iterator(root_)) {
+        if (!dir_entry.is_regular_file()) {
+            continue;
+        }
+        auto entry = std::make_unique<FileEntry>();
+        entry->path = dir_entry.path();
+        entry->size = dir_entry.file_size();
+        std::string url_path = "/"s + entry->path.lexically_relative(root_).generic_string();
+        entry->mime_type = GetMimeType(url_path);
+        if (entry->size > options_.small_file_limit) {
+            const bip::file_mapping file{entry->path.string().c_str(), bip::read_only};
+            entry->mapping = std::make_shared<const bip::mapped_region>(file, bip::read_only);
+        }
+        files_.emplace(std::move(url_path), std::move(entry));
+    }
+
+    // Подготавливаем сжатые варианты файлов
+    for (auto& [url_path, entry] : files_) {
+        if (const auto it = files_.find(url_path + ".gz"s); it != files_.end()) {
+            entry->gzip = std::make_shared<const std::string>(ReadFile(it->second->path));
+        }
+        if (const auto it = files_.find(url_path + ".br"s); it != files_.end()) {
+            entry->brotli = std::make_shared<const std::string>(ReadFile(it->second->path));
+        }
+        if (entry->gzip || !options_.precompress || entry->size < MIN_COMPRESSIBLE_SIZE
+            || !IsCompressible(entry->mime_type)) {
+            continue;
+        }
+
+        const auto content = GetIdentityContent(*entry);
+        auto compressed = Gzip({content.data, content.size});
+        // Сжатый вариант хранится, только если он заметно меньше исходного файла
+        if (compressed && compressed->size() < entry->size / 10 * 9) {
+            entry->gzip = std::make_shared<const std::string>(std::move(*compressed));
+        }
+    }
+}
+
+std::optional<SharedBufferBody::value_type> StaticFiles::FindIdentityContent(
+    const FileEntry& entry) {
+    if (entry.mapping) {
+        return SharedBufferBody::value_type{
+            entry.mapping, static_cast<const char*>(entry.mapping->get_address()),
+            entry.mapping->get_size()};
+    }
+    if (FileContent content = cache_.Find(&entry)) {
+        const auto data = content->data();
+        const auto size = content->size();
+        return SharedBufferBody::value_type{std::move(content), data, size};
+    }
+    return std::nullopt;
+}
+
+SharedBufferBody::value_type StaticFiles::LoadIdentityContent(const FileEntry& entry) {
+    auto content = std::make_shared<const std::string>(ReadFile(entry.path));
+    cache_.Insert(&entry, content);
+    const auto data = content->data();
+    const auto size = content->size();
+    return {std::move(content), data, size};
+}
+
+SharedBufferBody::value_type StaticFiles::GetIdentityContent(const FileEntry& entry) {
+    if (auto content = FindIdentityContent(entry)) {
+        return std::move(*content);
+    }
+    return LoadIdentityContent(entry);
+}
+
+StaticFileResponse StaticFiles::HandleRequest(const StaticFileRequest& request) {
+    if (request.method != http::verb::get && request.method != http::verb::head) {
+        auto response
+            = MakeTextResponse(http::status::method_not_allowed, "Invalid method"sv, request);
+        response.set(http::field::allow, "GET, HEAD"sv);
+        return response;
+    }
+
+    // Путь декодируется в буфер на стеке
+    std::array<char, MAX_PATH_SIZE> path_buffer;
+    const auto encoded_path = request.target.substr(0, request.target.find('?'));
+    auto path = UrlDecode(encoded_path, path_buffer);
+    if (!path || !path->starts_with('/') || HasParentSegment(*path)) {
+        return MakeTextResponse(http::status::bad_request, "Bad request"sv, request);
+    }
+    if (path->ends_with('/')) {
+        constexpr auto INDEX_FILE = "index.html"sv;
+        if (path->size() + INDEX_FILE.size() > path_buffer.size()) {
+            return MakeTextResponse(http::status::bad_request, "Bad request"sv, request);
+        }
+        std::copy(INDEX_FILE.begin(), INDEX_FILE.end(), path_buffer.begin() + path->size());
+        path = std::string_view{path_buffer.data(), path->size() + INDEX_FILE.size()};
+    }
+
+    const auto it = files_.find(*path);
+    if (it == files_.end()) {
+        return MakeTextResponse(http::status::not_found, "File not found"sv, request);
+    }
+    const FileEntry& entry = *it->second;
+
+    FileResponse response(http::status::ok, request.version);
+    response.set(http::field::content_type, entry.mime_type);
+    response.set(http::field::accept_ranges, "bytes"sv);
+    if (entry.gzip || entry.brotli) {
+        response.set(http::field::vary, "Accept-Encoding"sv);
+    }
+    response.keep_alive(request.keep_alive);
+
+    ByteRange range{};
+    const auto range_result = ParseRange(request.range, entry.size, range);
+    // Диапазоны отдаются только из несжатого представления файла
+    const auto encoding = range_result == RangeParseResult::NONE
+                              ? ChooseEncoding(request.accept_encoding, entry.gzip != nullptr,
+                                               entry.brotli != nullptr)
+                              : ContentEncoding::IDENTITY;
+
+    if (range_result == RangeParseResult::UNSATISFIABLE) {
+        std::array<char, 32> content_range;
+        const int size = std::snprintf(content_range.data(), content_range.size(), "bytes */%llu",
+                                       static_cast<unsigned long long>(entry.size));
+        response.result(http::status::range_not_satisfiable);
+        response.set(http::field::content_range,
+                     std::string_view{content_range.data(), static_cast<std::size_t>(size)});
+        response.content_length(0);
+        return response;
+    }
+
+    SharedBufferBody::value_type body;
+    switch (encoding) {
+        case ContentEncoding::BROTLI:
+            response.set(http::field::content_encoding, "br"sv);
+            body = {entry.brotli, entry.brotli->data(), entry.brotli->size()};
+            break;
+        case ContentEncoding::GZIP:
+            response.set(http::field::content_encoding, "gzip"sv);
+            body = {entry.gzip, entry.gzip->data(), entry.gzip->size()};
+            break;
+        case ContentEncoding::IDENTITY:
+            if (auto content = FindIdentityContent(entry)) {
+                body = std::move(*content);
+                break;
+            }
+            // Небольшого файла нет в кеше. Чтение с диска блокирует поток, поэтому
+            // выполняется в пуле blocking_pool_, а не в потоке, обслуживающем соединения
+            using Deferred = DeferredResponse<FileResponse>;
+            return Deferred{[this, &entry, request, range_result, range,
+                             response = std::move(response)](Deferred::Respond respond) mutable {
+                net::post(blocking_pool_, [this, &entry, request, range_result, range,
+                                           response = std::move(response),
+                                           respond = std::move(respond)]() mutable {
+                    SharedBufferBody::value_type content;
+                    try {
+                        content = LoadIdentityContent(entry);
+                    } catch (const std::exception&) {
+                        return respond(MakeTextResponse(http::status::internal_server_error,
+                                                        "Failed to read file"sv, request));
+                    }
+                    SetFileBody(response, std::move(content), range_result, range, entry.size,
+                                request.method);
+                    respond(std::move(response));
+                });
+            }};
+    }
+
+    SetFileBody(response, std::move(body), range_result, range, entry.size, request.method);
+    return response;
+}
+
+}  // namespace http_handler
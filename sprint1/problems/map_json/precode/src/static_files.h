@@ -0,0 +1,227 @@
+#pragma once
+#include "http_server.h"
+//
+#include <boost/asio/thread_pool.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+#include "deferred_response.h"
+
+namespace http_handler {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+/*
+ * Тело HTTP-ответа, ссылающееся на неизменяемый буфер, которым владеет owner.
+ * Позволяет отдавать содержимое файла из кеша или из отображённой в память области
+ * без копирования. Буфер остаётся действительным, пока ответ не будет отправлен,
+ * даже если файл за это время вытеснят из кеша.
+ */
+struct SharedBufferBody {
+    struct value_type {
+        std::shared_ptr<const void> owner;
+        const char* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) noexcept {
+        return body.size;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        explicit writer(const http::header<isRequest, Fields>&, const value_type& body)
+            : body_(body) {
+        }
+
+        void init(beast::error_code& ec) {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            return {{{body_.data, body_.size}, false}};
+        }
+
+    private:
+        const value_type& body_;
+    };
+};
+
+using FileResponse = http::response<SharedBufferBody>;
+// Ответ на запрос файла: готовый либо ожидающий чтения файла с диска
+using StaticFileResponse = std::variant<FileResponse, DeferredResponse<FileResponse>>;
+
+/*
+ * Декодирует URL-кодированную строку encoded в буфер out, не выделяя динамическую память.
+ * Возвращает декодированную строку, размещённую в out, либо std::nullopt, если encoded
+ * содержит некорректную %-последовательность или не помещается в out.
+ */
+std::optional<std::string_view> UrlDecode(std::string_view encoded, std::span<char> out) noexcept;
+
+// Возвращает MIME-тип файла по его расширению (без учёта регистра)
+std::string_view GetMimeType(std::string_view path) noexcept;
+
+// Кодировка содержимого, в которой отдаётся файл
+enum class ContentEncoding {
+    IDENTITY,
+    GZIP,
+    BROTLI,
+};
+
+// Выбирает лучшую кодировку из доступных с учётом заголовка Accept-Encoding
+ContentEncoding ChooseEncoding(std::string_view accept_encoding, bool has_gzip,
+                               bool has_brotli) noexcept;
+
+// Диапазон байтов [first, last] из заголовка Range
+struct ByteRange {
+    std::uint64_t first;
+    std::uint64_t last;
+};
+
+enum class RangeParseResult {
+    // Заголовка нет, либо его формат не поддерживается: отдаётся весь файл
+    NONE,
+    // Запрошен корректный диапазон
+    RANGE,
+    // Диапазон лежит за пределами файла
+    UNSATISFIABLE,
+};
+
+// Разбирает заголовок Range вида bytes=a-b, bytes=a- или bytes=-n.
+// Запросы нескольких диапазонов не поддерживаются и обрабатываются как запрос всего файла
+RangeParseResult ParseRange(std::string_view range, std::uint64_t file_size,
+                            ByteRange& result) noexcept;
+
+struct StaticFilesOptions {
+    // Файлы не больше этого размера читаются в память и хранятся в кеше,
+    // файлы большего размера отображаются в память
+    std::size_t small_file_limit = 256 * 1024;
+    // Максимальный суммарный размер файлов в кеше
+    std::size_t cache_capacity = 16 * 1024 * 1024;
+    // Сжимать ли файлы в gzip при запуске, если рядом нет готового файла .gz
+    bool precompress = true;
+    // Потоки, читающие с диска небольшие файлы, которых нет в кеше
+    std::size_t blocking_threads = 1;
+};
+
+// Кешируемое содержимое файла
+using FileContent = std::shared_ptr<const std::string>;
+
+/*
+ * Size-bounded LRU-кеш содержимого небольших файлов.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class HotFileCache {
+public:
+    explicit HotFileCache(std::size_t capacity)
+        : capacity_{capacity} {
+    }
+
+    HotFileCache(const HotFileCache&) = delete;
+    HotFileCache& operator=(const HotFileCache&) = delete;
+
+    // Возвращает содержимое файла из кеша и помечает его как недавно использованное.
+    // Возвращает nullptr, если файла в кеше нет
+    FileContent Find(const void* key);
+
+    // Помещает содержимое в кеш, вытесняя давно не использованные файлы
+    void Insert(const void* key, FileContent content);
+
+private:
+    using Lru = std::list<const void*>;
+
+    struct CacheEntry {
+        FileContent content;
+        Lru::iterator lru_pos;
+    };
+
+    std::mutex mutex_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+    // Ключи в порядке использования: в начале - самый свежий
+    Lru lru_;
+    std::unordered_map<const void*, CacheEntry> entries_;
+};
+
+// Параметры запроса статического файла. Все строки ссылаются на память запроса
+struct StaticFileRequest {
+    http::verb method;
+    std::string_view target;
+    std::string_view accept_encoding;
+    std::string_view range;
+    unsigned version;
+    bool keep_alive;
+};
+
+/*
+ * Хранилище статических файлов.
+ * Каталог root индексируется при создании объекта: отдаются только файлы, найденные
+ * при индексации, поэтому выйти за пределы root с помощью ".." невозможно, а поиск
+ * файла по пути из запроса не требует обращения к файловой системе.
+ * Для каждого файла заранее подготавливаются сжатые варианты: готовые файлы .gz/.br,
+ * лежащие рядом с ним, либо gzip-представление, созданное при запуске.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class StaticFiles {
+public:
+    // Максимальная длина пути в запросе
+    constexpr static std::size_t MAX_PATH_SIZE = 1024;
+
+    explicit StaticFiles(std::filesystem::path root, StaticFilesOptions options = {});
+
+    StaticFiles(const StaticFiles&) = delete;
+    StaticFiles& operator=(const StaticFiles&) = delete;
+
+    ~StaticFiles();
+
+    // Формирует ответ на запрос файла. В случае ошибки возвращает ответ
+    // с соответствующим кодом состояния. Если небольшого файла нет в кеше, он читается
+    // в пуле потоков, не занимая поток ввода-вывода, и возвращается DeferredResponse.
+    // Строки request должны оставаться действительными до отправки ответа
+    StaticFileResponse HandleRequest(const StaticFileRequest& request);
+
+private:
+    struct FileEntry;
+
+    struct StringHasher {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const noexcept {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    void IndexDirectory();
+    // Возвращает несжатое содержимое файла, если его не нужно читать с диска
+    std::optional<SharedBufferBody::value_type> FindIdentityContent(const FileEntry& entry);
+    // Читает содержимое небольшого файла с диска и помещает его в кеш. Блокирует поток
+    SharedBufferBody::value_type LoadIdentityContent(const FileEntry& entry);
+    SharedBufferBody::value_type GetIdentityContent(const FileEntry& entry);
+
+    std::filesystem::path root_;
+    StaticFilesOptions options_;
+    // Ключ - путь к файлу относительно root_ в формате URL, например "/js/game.js"
+    std::unordered_map<std::string, std::unique_ptr<FileEntry>, StringHasher, std::equal_to<>>
+        files_;
+    HotFileCache cache_;
+    // Объявлен последним, чтобы остановиться раньше, чем будут разрушены файлы и кеш
+    net::thread_pool blocking_pool_;
+};
+
+}  // namespace http_handler
@@ -0,0 +1,106 @@
+#include "stream_session.h"
+
+#include <boost/asio/post.hpp>
+
+namespace app {
+
+using namespace std::literals;
+
+StreamSession::StreamSession(beast::tcp_stream&& stream, StateStream& state_stream,
+                             http_server::ConnectionSlot&& slot)
+    : ws_{std::move(stream)}
+    , state_stream_{state_stream}
+    , slot_{std::move(slot)} {
+}
+
+void StreamSession::Run(const http_server::Request& request) {
+    // WebSocket следит за таймаутами сам, таймер tcp_stream ему только мешает
+    beast::get_lowest_layer(ws_).expires_never();
+    ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws_.text(true);
+    // Ответ на рукопожатие формируется при вызове async_accept, поэтому запрос
+    // не должен жить дольше этого вызова
+    ws_.async_accept(request, beast::bind_front_handler(&StreamSession::OnAccept,
+                                                        shared_from_this()));
+}
+
+void StreamSession::Push(StateFramePtr frame) {
+    net::post(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        self->OnFrame(std::move(frame));
+    });
+}
+
+void StreamSession::OnAccept(beast::error_code ec) {
+    if (ec) {
+        return http_server::ReportError(ec, "websocket accept"sv);
+    }
+    state_stream_.Subscribe(shared_from_this());
+    Read();
+}
+
+void StreamSession::Read() {
+    ws_.async_read(read_buffer_,
+                   beast::bind_front_handler(&StreamSession::OnRead, shared_from_this()));
+}
+
+void StreamSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    if (ec) {
+        // Клиент закрыл соединение. Сессия будет удалена, когда завершится отправка
+        // и кадры перестанут её удерживать, а подписка будет снята при следующей публикации
+        closed_ = true;
+        if (ec != websocket::error::closed) {
+            http_server::ReportError(ec, "websocket read"sv);
+        }
+        return;
+    }
+    read_buffer_.consume(read_buffer_.size());
+    Read();
+}
+
+void StreamSession::OnFrame(StateFramePtr frame) {
+    if (closed_) {
+        return;
+    }
+    if (pending_frame_) {
+        state_stream_.GetStats().frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    pending_frame_ = std::move(frame);
+    if (!writing_frame_) {
+        WriteNextFrame();
+    }
+}
+
+void StreamSession::WriteNextFrame() {
+    writing_frame_ = std::move(pending_frame_);
+    pending_frame_.reset();
+
+    const std::string* body = &writing_frame_->GetChanges();
+    if (!writing_frame_->IsApplicable(last_sent_tick_)) {
+        body = &writing_frame_->GetFullState();
+        state_stream_.GetStats().full_frames_sent.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Буфер принадлежит кадру, который удерживается до окончания записи
+    ws_.async_write(net::buffer(*body),
+                    beast::bind_front_handler(&StreamSession::OnWrite, shared_from_this()));
+}
+
+void StreamSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    const StateFramePtr frame = std::move(writing_frame_);
+    writing_frame_.reset();
+    if (ec) {
+        closed_ = true;
+        pending_frame_.reset();
+        return http_server::ReportError(ec, "websocket write"sv);
+    }
+
+    StreamStats& stats = state_stream_.GetStats();
+    stats.frames_sent.fetch_add(1, std::memory_order_relaxed);
+    stats.delivery.Record(StateFrame::Clock::now() - frame->GetPublishTime());
+    last_sent_tick_ = frame->GetTick();
+
+    if (pending_frame_ && !closed_) {
+        WriteNextFrame();
+    }
+}
+
+}  // namespace app
@@ -0,0 +1,59 @@
+#pragma once
+#include "http_server.h"
+//
+#include <boost/beast/websocket.hpp>
+#include <memory>
+#include <optional>
+
+#include "state_stream.h"
+
+namespace app {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+
+/*
+ * WebSocket-соединение, по которому клиенту отправляется состояние игровой сессии
+ * после каждого тика.
+ *
+ * Одновременно отправляется не больше одного кадра. Кадр, пришедший во время отправки,
+ * ждёт своей очереди, а если до начала его отправки придёт следующий, ожидающий кадр
+ * отбрасывается. Поэтому медленный клиент получает только последнее состояние и не
+ * накапливает очередь. Клиент, пропустивший кадр, вместо изменений получает полное
+ * состояние. Сообщения клиента читаются только для того, чтобы обнаружить закрытие
+ * соединения, и игнорируются.
+ */
+class StreamSession : public StreamSubscriber, public std::enable_shared_from_this<StreamSession> {
+public:
+    // slot - место соединения в контроле допуска, освобождаемое вместе с сессией
+    StreamSession(beast::tcp_stream&& stream, StateStream& state_stream,
+                  http_server::ConnectionSlot&& slot = {});
+
+    // Завершает рукопожатие WebSocket и подписывает соединение на состояние сессии.
+    // Запрос используется только до возврата из метода
+    void Run(const http_server::Request& request);
+
+    void Push(StateFramePtr frame) override;
+
+private:
+    void OnAccept(beast::error_code ec);
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void OnFrame(StateFramePtr frame);
+    void WriteNextFrame();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+
+    websocket::stream<beast::tcp_stream> ws_;
+    StateStream& state_stream_;
+    http_server::ConnectionSlot slot_;
+    beast::flat_buffer read_buffer_;
+    // Кадр, который отправляется в данный момент, и кадр, ожидающий отправки
+    StateFramePtr writing_frame_;
+    StateFramePtr pending_frame_;
+    // Тик последнего отправленного клиенту кадра
+    std::optional<std::uint64_t> last_sent_tick_;
+    bool closed_ = false;
+};
+
+}  // namespace app
@@ -0,0 +1,217 @@
+#include "tick_scheduler.h"
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace app {
+
+namespace sys = boost::system;
+
+class TickScheduler::SessionTicker : public std::enable_shared_from_this<SessionTicker> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SessionTicker(net::io_context& ioc, model::GameSession& session,
+                  const TickSchedulerOptions& options)
+        : session_{session}
+        , strand_{net::make_strand(ioc)}
+        , timer_{strand_}
+        , period_{options.period}
+        , max_catch_up_ticks_{std::max(1u, options.max_catch_up_ticks)}
+        , journal_{options.period} {
+    }
+
+    const model::GameSession& GetSession() const noexcept {
+        return session_;
+    }
+
+    const TickStats& GetStats() const noexcept {
+        return stats_;
+    }
+
+    const StateJournal& GetJournal() const noexcept {
+        return journal_;
+    }
+
+    StateStream& GetStream() noexcept {
+        return stream_;
+    }
+
+    Strand GetStrand() const {
+        return strand_;
+    }
+
+    void Start() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            self->stopped_ = false;
+            // Состояние до первого тика доступно клиентам сразу после запуска
+            self->journal_.RecordChanges(self->session_);
+            self->journal_.RecordState(self->session_);
+            self->next_tick_ = Clock::now() + self->period_;
+            self->ScheduleTick();
+        });
+    }
+
+    template <typename Fn>
+    void AddDog(geom::Point2D position, Fn&& on_added) {
+        net::dispatch(strand_, [self = shared_from_this(), position,
+                                on_added = std::forward<Fn>(on_added)]() mutable {
+            // После остановки тиков сессию читают другие потоки, например, при сохранении
+            if (self->stopped_) {
+                return on_added(std::nullopt);
+            }
+            on_added(self->session_.AddDog(position));
+        });
+    }
+
+    template <typename Fn>
+    void Stop(Fn&& on_stopped) {
+        net::dispatch(strand_, [self = shared_from_this(),
+                                on_stopped = std::forward<Fn>(on_stopped)]() mutable {
+            self->stopped_ = true;
+            self->timer_.cancel();
+            on_stopped();
+        });
+    }
+
+private:
+    void ScheduleTick() {
+        timer_.expires_at(next_tick_);
+        timer_.async_wait(net::bind_executor(
+            strand_, [self = shared_from_this()](sys::error_code ec) {
+                self->OnTimer(ec);
+            }));
+    }
+
+    void OnTimer(sys::error_code ec) {
+        if (ec || stopped_) {
+            return;
+        }
+
+        // Количество периодов, наступивших к текущему моменту
+        const auto now = Clock::now();
+        const auto due_ticks = static_cast<std::uint64_t>(1 + (now - next_tick_) / period_);
+        if (due_ticks > 1) {
+            stats_.late_ticks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const std::uint64_t ticks = std::min<std::uint64_t>(due_ticks, max_catch_up_ticks_);
+        for (std::uint64_t i = 0; i < ticks; ++i) {
+            const auto start = Clock::now();
+            session_.Tick(period_);
+            stats_.durations.Record(Clock::now() - start);
+            // Запись журнала не входит в длительность тика
+            journal_.RecordChanges(session_);
+        }
+        stats_.ticks.fetch_add(ticks, std::memory_order_relaxed);
+        // Полное состояние копируется один раз на срабатывание таймера, а не на каждый тик
+        journal_.RecordState(session_);
+        // Подписчикам отправляется одно состояние на срабатывание таймера,
+        // даже если сессия догоняла реальное время несколькими тиками
+        stream_.Publish(journal_);
+        if (due_ticks > ticks) {
+            stats_.skipped_ticks.fetch_add(due_ticks - ticks, std::memory_order_relaxed);
+        }
+
+        next_tick_ += period_ * due_ticks;
+        ScheduleTick();
+    }
+
+    model::GameSession& session_;
+    Strand strand_;
+    net::steady_timer timer_;
+    std::chrono::milliseconds period_;
+    unsigned max_catch_up_ticks_;
+    Clock::time_point next_tick_;
+    bool stopped_ = true;
+    TickStats stats_;
+    StateJournal journal_;
+    StateStream stream_;
+};
+
+TickScheduler::TickScheduler(net::io_context& ioc, TickSchedulerOptions options)
+    : ioc_{ioc}
+    , options_{options} {
+    if (options_.period <= std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("Tick period must be positive");
+    }
+}
+
+TickScheduler::~TickScheduler() = default;
+
+TickScheduler::Strand TickScheduler::AddSession(model::GameSession& session) {
+    const auto& ticker =
+        tickers_.emplace_back(std::make_shared<SessionTicker>(ioc_, session, options_));
+    return ticker->GetStrand();
+}
+
+void TickScheduler::Start() {
+    for (const auto& ticker : tickers_) {
+        ticker->Start();
+    }
+}
+
+void TickScheduler::Stop(std::function<void()> on_stopped) {
+    if (!on_stopped) {
+        for (const auto& ticker : tickers_) {
+            ticker->Stop([] {});
+        }
+        return;
+    }
+    if (tickers_.empty()) {
+        return on_stopped();
+    }
+    // Последняя остановившаяся сессия вызывает on_stopped
+    auto remaining = std::make_shared<std::atomic<size_t>>(tickers_.size());
+    auto callback = std::make_shared<std::function<void()>>(std::move(on_stopped));
+    for (const auto& ticker : tickers_) {
+        ticker->Stop([remaining, callback] {
+            if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                (*callback)();
+            }
+        });
+    }
+}
+
+const StateJournal* TickScheduler::FindJournal(const model::Map& map) const noexcept {
+    for (const auto& ticker : tickers_) {
+        if (&ticker->GetSession().GetMap() == &map) {
+            return &ticker->GetJournal();
+        }
+    }
+    return nullptr;
+}
+
+StateStream* TickScheduler::FindStream(const model::Map& map) const noexcept {
+    for (const auto& ticker : tickers_) {
+        if (&ticker->GetSession().GetMap() == &map) {
+            return &ticker->GetStream();
+        }
+    }
+    return nullptr;
+}
+
+bool TickScheduler::AddDog(const model::Map& map, geom::Point2D position,
+                           std::function<void(std::optional<size_t> dog)> on_added) const {
+    for (const auto& ticker : tickers_) {
+        if (&ticker->GetSession().GetMap() == &map) {
+            ticker->AddDog(position, std::move(on_added));
+            return true;
+        }
+    }
+    return false;
+}
+
+const model::GameSession& TickScheduler::GetSession(const SessionTicker& ticker) noexcept {
+    return ticker.GetSession();
+}
+
+const TickStats& TickScheduler::GetStats(const SessionTicker& ticker) noexcept {
+    return ticker.GetStats();
+}
+
+}  // namespace app
@@ -0,0 +1,114 @@
+#pragma once
+#include "sdk.h"
+//
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "duration_histogram.h"
+#include "game_session.h"
+#include "state_journal.h"
+#include "state_stream.h"
+
+namespace app {
+
+namespace net = boost::asio;
+
+// Статистика тиков одной игровой сессии
+struct TickStats {
+    // Длительности GameSession::Tick без записи состояния в журнал
+    DurationHistogram durations;
+    // Выполненные тики
+    std::atomic<std::uint64_t> ticks{0};
+    // Срабатывания таймера, опоздавшие больше чем на период
+    std::atomic<std::uint64_t> late_ticks{0};
+    // Тики, пропущенные из-за отставания от реального времени
+    std::atomic<std::uint64_t> skipped_ticks{0};
+};
+
+struct TickSchedulerOptions {
+    // Период тиков. Каждый тик продвигает игровое время ровно на period
+    std::chrono::milliseconds period{50};
+    // Максимальное количество тиков, выполняемых за одно срабатывание таймера, когда сессия
+    // отстала от реального времени. Остальные тики пропускаются и учитываются в skipped_ticks
+    unsigned max_catch_up_ticks = 4;
+};
+
+/*
+ * Планировщик тиков с фиксированной частотой.
+ * Каждой игровой сессии выделяется собственный strand и таймер, поэтому сессии на разных
+ * картах обновляются параллельно потоками, обслуживающими io_context, а тики одной
+ * сессии никогда не выполняются одновременно. Время следующего тика отсчитывается
+ * от запланированного времени предыдущего, а не от момента его окончания, так что
+ * длительность тика не накапливает отставание.
+ */
+class TickScheduler {
+public:
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    TickScheduler(net::io_context& ioc, TickSchedulerOptions options);
+
+    TickScheduler(const TickScheduler&) = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+
+    ~TickScheduler();
+
+    // Регистрирует сессию и возвращает её strand. Все обращения к сессии
+    // после запуска планировщика должны выполняться через этот strand.
+    // Сессия должна существовать, пока существует планировщик
+    Strand AddSession(model::GameSession& session);
+
+    // Запускает тики всех зарегистрированных сессий
+    void Start();
+
+    // Останавливает тики. Тик, выполняющийся в момент вызова, будет завершён.
+    // on_stopped, если задан, вызывается в strand одной из сессий, когда тики всех сессий
+    // завершены и новых не будет: после этого сессии можно читать из любого потока
+    void Stop(std::function<void()> on_stopped = {});
+
+    // Вызывает fn(const model::GameSession&, const TickStats&) для каждой сессии.
+    // Статистику можно читать из любого потока
+    template <typename Fn>
+    void ForEachStats(Fn&& fn) const {
+        for (const auto& ticker : tickers_) {
+            fn(GetSession(*ticker), GetStats(*ticker));
+        }
+    }
+
+    // Возвращает журнал состояний сессии на карте map или nullptr, если такой сессии нет.
+    // Журнал можно читать из любого потока
+    const StateJournal* FindJournal(const model::Map& map) const noexcept;
+
+    // Возвращает рассылку состояния сессии на карте map или nullptr, если такой сессии нет.
+    // Подписываться на рассылку можно из любого потока
+    StateStream* FindStream(const model::Map& map) const noexcept;
+
+    // Добавляет неподвижную собаку в точку position сессии на карте map. Собака добавляется
+    // в strand сессии, и там же вызывается on_added с номером собаки или std::nullopt,
+    // если тики сессии уже остановлены. Возвращает false, если сессии на карте map нет.
+    // Метод можно вызывать из любого потока
+    bool AddDog(const model::Map& map, geom::Point2D position,
+                std::function<void(std::optional<size_t> dog)> on_added) const;
+
+    const TickSchedulerOptions& GetOptions() const noexcept {
+        return options_;
+    }
+
+private:
+    class SessionTicker;
+
+    static const model::GameSession& GetSession(const SessionTicker& ticker) noexcept;
+    static const TickStats& GetStats(const SessionTicker& ticker) noexcept;
+
+    net::io_context& ioc_;
+    TickSchedulerOptions options_;
+    std::vector<std::shared_ptr<SessionTicker>> tickers_;
+};
+
+}  // namespace app
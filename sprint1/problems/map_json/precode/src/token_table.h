@@ -0,0 +1,397 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace app {
+
+/*
+ * Токен авторизации игрока: 128-битное число, которое передаётся клиенту
+ * в виде 32 шестнадцатеричных цифр.
+ */
+struct Token {
+    constexpr static size_t HEX_SIZE = 32;
+
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+
+    bool operator==(const Token&) const = default;
+
+    // Разбирает строку из 32 шестнадцатеричных цифр в любом регистре, не выделяя память.
+    // Возвращает std::nullopt, если строка имеет другой формат
+    static std::optional<Token> Parse(std::string_view hex) noexcept {
+        if (hex.size() != HEX_SIZE) {
+            return std::nullopt;
+        }
+        const auto hi = ParseHalf(hex.data());
+        const auto lo = ParseHalf(hex.data() + HEX_SIZE / 2);
+        if (!hi || !lo) {
+            return std::nullopt;
+        }
+        return Token{*hi, *lo};
+    }
+
+    // Извлекает токен из значения заголовка Authorization вида "Bearer <token>"
+    static std::optional<Token> ParseBearer(std::string_view authorization) noexcept {
+        constexpr std::string_view BEARER = "Bearer ";
+        if (!authorization.starts_with(BEARER)) {
+            return std::nullopt;
+        }
+        return Parse(authorization.substr(BEARER.size()));
+    }
+
+    // Записывает 32 шестнадцатеричные цифры в нижнем регистре
+    std::array<char, HEX_SIZE> ToHex() const noexcept {
+        constexpr std::string_view DIGITS = "0123456789abcdef";
+        std::array<char, HEX_SIZE> result;
+        for (size_t i = 0; i < HEX_SIZE / 2; ++i) {
+            const unsigned shift = 60 - 4 * static_cast<unsigned>(i);
+            result[i] = DIGITS[(hi >> shift) & 0xF];
+            result[i + HEX_SIZE / 2] = DIGITS[(lo >> shift) & 0xF];
+        }
+        return result;
+    }
+
+    std::string ToString() const {
+        const auto hex = ToHex();
+        return {hex.data(), hex.size()};
+    }
+
+private:
+    // Значения шестнадцатеричных цифр по коду символа, INVALID_DIGIT для остальных символов
+    constexpr static std::uint8_t INVALID_DIGIT = 0xFF;
+    constexpr static std::array<std::uint8_t, 256> HEX_DIGITS = [] {
+        std::array<std::uint8_t, 256> digits{};
+        digits.fill(INVALID_DIGIT);
+        for (int i = 0; i < 10; ++i) {
+            digits['0' + i] = static_cast<std::uint8_t>(i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            digits['a' + i] = digits['A' + i] = static_cast<std::uint8_t>(10 + i);
+        }
+        return digits;
+    }();
+
+    // Разбирает 16 цифр. Проверка цифр объединена в одну, чтобы цикл не содержал ветвлений
+    static std::optional<std::uint64_t> ParseHalf(const char* hex) noexcept {
+        std::uint64_t value = 0;
+        std::uint8_t invalid = 0;
+        for (size_t i = 0; i < HEX_SIZE / 2; ++i) {
+            const std::uint8_t digit = HEX_DIGITS[static_cast<unsigned char>(hex[i])];
+            invalid |= digit;
+            value = (value << 4) | (digit & 0xF);
+        }
+        if (invalid & 0xF0) {
+            return std::nullopt;
+        }
+        return value;
+    }
+};
+
+// Генератор случайных токенов. Не потокобезопасен
+class TokenGenerator {
+public:
+    Token Generate() {
+        return {generator1_(), generator2_()};
+    }
+
+private:
+    std::random_device random_device_;
+    std::mt19937_64 generator1_{[this] {
+        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
+        return dist(random_device_);
+    }()};
+    std::mt19937_64 generator2_{[this] {
+        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
+        return dist(random_device_);
+    }()};
+};
+
+/*
+ * Таблица "токен -> объект" для частых проверок токена при редких изменениях.
+ *
+ * Хеш-таблица с открытой адресацией и линейным пробированием. Изменения (Insert, Remove)
+ * выполняются под мьютексом, а поиск (Find) не берёт блокировок: он защищён
+ * счётчиком версий (seqlock). Писатель делает счётчик нечётным на время изменения,
+ * а читатель повторяет поиск, если счётчик был нечётным или изменился за время поиска.
+ * Поэтому множество потоков, обслуживающих запросы состояния игры, не мешают друг другу
+ * и лишь изредка повторяют поиск, когда в игру входит новый игрок.
+ *
+ * При увеличении таблицы старый массив ячеек не освобождается до уничтожения объекта:
+ * читатель мог начать поиск в нём. Ёмкость удваивается, поэтому старые массивы вместе
+ * занимают не больше памяти, чем текущий. Если место занято в основном удалёнными
+ * ячейками, новый массив не создаётся: ячейки текущего перестраиваются на месте под
+ * счётчиком версий, поэтому добавление и удаление токенов без роста таблицы не
+ * увеличивает занятую память.
+ * Объекты, на которые указывают значения, таблицей не владеет.
+ */
+template <typename T>
+class TokenTable {
+public:
+    explicit TokenTable(size_t initial_capacity = 64) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < initial_capacity) {
+            capacity *= 2;
+        }
+        Publish(std::make_unique<Slots>(capacity));
+    }
+
+    TokenTable(const TokenTable&) = delete;
+    TokenTable& operator=(const TokenTable&) = delete;
+
+    // Возвращает значение, связанное с токеном, или nullptr. Не берёт блокировок
+    T* Find(const Token& token) const noexcept {
+        for (;;) {
+            const std::uint64_t version = version_.load(std::memory_order_acquire);
+            if (version % 2 == 0) {
+                const Slots& slots = *slots_.load(std::memory_order_acquire);
+                T* value = FindIn(slots, token);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version_.load(std::memory_order_relaxed) == version) {
+                    return value;
+                }
+            }
+        }
+    }
+
+    // Связывает токен со значением value. Возвращает false, если токен уже есть в таблице
+    bool Insert(const Token& token, T* value) {
+        std::lock_guard lock{mutex_};
+        if (FindIn(*slots_.load(std::memory_order_relaxed), token)) {
+            return false;
+        }
+        if ((size_ + tombstones_ + 1) * 2 > slots_.load(std::memory_order_relaxed)->capacity) {
+            Grow();
+        }
+        Write([&](Slots& current) {
+            Slot& slot = current.At(ProbeFree(current, token));
+            if (slot.state.load(std::memory_order_relaxed) == DELETED) {
+                --tombstones_;
+            }
+            slot.hi.store(token.hi, std::memory_order_relaxed);
+            slot.lo.store(token.lo, std::memory_order_relaxed);
+            slot.value.store(value, std::memory_order_relaxed);
+            slot.state.store(FULL, std::memory_order_relaxed);
+        });
+        ++size_;
+        return true;
+    }
+
+    // Удаляет токен из таблицы. Возвращает false, если токена в таблице не было
+    bool Remove(const Token& token) {
+        std::lock_guard lock{mutex_};
+        Slots& slots = *slots_.load(std::memory_order_relaxed);
+        const size_t index = ProbeFull(slots, token);
+        if (index == NOT_FOUND) {
+            return false;
+        }
+        Write([&](Slots& current) {
+            Slot& slot = current.At(index);
+            slot.state.store(DELETED, std::memory_order_relaxed);
+            slot.value.store(nullptr, std::memory_order_relaxed);
+        });
+        --size_;
+        ++tombstones_;
+        return true;
+    }
+
+    size_t GetSize() const {
+        std::lock_guard lock{mutex_};
+        return size_;
+    }
+
+    // Возвращает ёмкость текущего массива ячеек
+    size_t GetCapacity() const {
+        std::lock_guard lock{mutex_};
+        return slots_.load(std::memory_order_relaxed)->capacity;
+    }
+
+    // Возвращает суммарную ёмкость текущего и всех прежних массивов ячеек
+    size_t GetRetainedCapacity() const {
+        std::lock_guard lock{mutex_};
+        size_t capacity = 0;
+        for (const auto& slots : all_slots_) {
+            capacity += slots->capacity;
+        }
+        return capacity;
+    }
+
+private:
+    constexpr static size_t MIN_CAPACITY = 16;
+    constexpr static size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    enum State : std::uint8_t {
+        EMPTY,
+        FULL,
+        // Удалённая ячейка. Не прерывает пробирование, но может быть занята заново
+        DELETED,
+    };
+
+    // Поля ячейки атомарны, потому что читатели обращаются к ним одновременно с писателем.
+    // Согласованность полей между собой обеспечивает счётчик версий
+    struct Slot {
+        std::atomic<std::uint64_t> hi{0};
+        std::atomic<std::uint64_t> lo{0};
+        std::atomic<T*> value{nullptr};
+        std::atomic<std::uint8_t> state{EMPTY};
+    };
+
+    struct Slots {
+        explicit Slots(size_t capacity)
+            : capacity{capacity}
+            , slots{std::make_unique<Slot[]>(capacity)} {
+        }
+
+        Slot& At(size_t index) noexcept {
+            return slots[index];
+        }
+
+        const Slot& At(size_t index) const noexcept {
+            return slots[index];
+        }
+
+        const size_t capacity;
+        const std::unique_ptr<Slot[]> slots;
+    };
+
+    static size_t Hash(const Token& token) noexcept {
+        // Токены случайны, но ключ поиска приходит от клиента, поэтому биты перемешиваются
+        return static_cast<size_t>((token.hi ^ (token.lo * 0x9E3779B97F4A7C15)) >> 7);
+    }
+
+    static bool Matches(const Slot& slot, const Token& token) noexcept {
+        return slot.hi.load(std::memory_order_relaxed) == token.hi
+               && slot.lo.load(std::memory_order_relaxed) == token.lo;
+    }
+
+    // Возвращает индекс занятой ячейки с токеном или NOT_FOUND.
+    // Во время поиска без блокировки содержимое ячеек может меняться, поэтому число
+    // шагов ограничено ёмкостью таблицы
+    static size_t ProbeFull(const Slots& slots, const Token& token) noexcept {
+        const size_t mask = slots.capacity - 1;
+        size_t index = Hash(token) & mask;
+        for (size_t step = 0; step < slots.capacity; ++step, index = (index + 1) & mask) {
+            const Slot& slot = slots.At(index);
+            const auto state = slot.state.load(std::memory_order_relaxed);
+            if (state == EMPTY) {
+                return NOT_FOUND;
+            }
+            if (state == FULL && Matches(slot, token)) {
+                return index;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    static T* FindIn(const Slots& slots, const Token& token) noexcept {
+        const size_t index = ProbeFull(slots, token);
+        return index == NOT_FOUND ? nullptr
+                                  : slots.At(index).value.load(std::memory_order_relaxed);
+    }
+
+    // Возвращает индекс первой свободной или удалённой ячейки на пути пробирования
+    static size_t ProbeFree(const Slots& slots, const Token& token) noexcept {
+        const size_t mask = slots.capacity - 1;
+        size_t index = Hash(token) & mask;
+        while (slots.At(index).state.load(std::memory_order_relaxed) == FULL) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    // Изменяет ячейки текущего массива, делая счётчик версий нечётным на время изменения
+    template <typename Fn>
+    void Write(Fn&& fn) {
+        const std::uint64_t version = version_.load(std::memory_order_relaxed);
+        version_.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fn(*slots_.load(std::memory_order_relaxed));
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+    // Переносит занятые ячейки в массив вдвое большей ёмкости и публикует его.
+    // Если место занято в основном удалёнными ячейками, перестраивает текущий массив
+    void Grow() {
+        const Slots& old_slots = *slots_.load(std::memory_order_relaxed);
+        if (size_ * 4 <= old_slots.capacity) {
+            return RemoveTombstones();
+        }
+        auto new_slots = std::make_unique<Slots>(old_slots.capacity * 2);
+        for (size_t i = 0; i < old_slots.capacity; ++i) {
+            const Slot& slot = old_slots.At(i);
+            if (slot.state.load(std::memory_order_relaxed) != FULL) {
+                continue;
+            }
+            const Token token{slot.hi.load(std::memory_order_relaxed),
+                              slot.lo.load(std::memory_order_relaxed)};
+            Place(*new_slots, token, slot.value.load(std::memory_order_relaxed));
+        }
+        tombstones_ = 0;
+        Publish(std::move(new_slots));
+    }
+
+    // Заново размещает занятые ячейки текущего массива, очищая удалённые.
+    // Читатели, которые ищут во время перестройки, повторят поиск из-за счётчика версий,
+    // а поля ячеек атомарны, поэтому одновременное чтение не приводит к гонке
+    void RemoveTombstones() {
+        std::vector<std::pair<Token, T*>> entries;
+        entries.reserve(size_);
+        const Slots& slots = *slots_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < slots.capacity; ++i) {
+            const Slot& slot = slots.At(i);
+            if (slot.state.load(std::memory_order_relaxed) == FULL) {
+                entries.emplace_back(Token{slot.hi.load(std::memory_order_relaxed),
+                                           slot.lo.load(std::memory_order_relaxed)},
+                                     slot.value.load(std::memory_order_relaxed));
+            }
+        }
+        Write([&](Slots& current) {
+            for (size_t i = 0; i < current.capacity; ++i) {
+                current.At(i).state.store(EMPTY, std::memory_order_relaxed);
+                current.At(i).value.store(nullptr, std::memory_order_relaxed);
+            }
+            for (const auto& [token, value] : entries) {
+                Place(current, token, value);
+            }
+        });
+        tombstones_ = 0;
+    }
+
+    static void Place(Slots& slots, const Token& token, T* value) noexcept {
+        Slot& slot = slots.At(ProbeFree(slots, token));
+        slot.hi.store(token.hi, std::memory_order_relaxed);
+        slot.lo.store(token.lo, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.state.store(FULL, std::memory_order_relaxed);
+    }
+
+    // Новый массив заполнен до публикации, поэтому читатель, получивший указатель на него,
+    // видит все ячейки. Счётчик версий заставляет повторить поиск тех, кто начал его
+    // в старом массиве
+    void Publish(std::unique_ptr<Slots> slots) {
+        all_slots_.push_back(std::move(slots));
+        const std::uint64_t version = version_.load(std::memory_order_relaxed);
+        version_.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slots_.store(all_slots_.back().get(), std::memory_order_release);
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+    mutable std::mutex mutex_;
+    std::atomic<std::uint64_t> version_{0};
+    std::atomic<Slots*> slots_{nullptr};
+    // Текущий и все прежние массивы ячеек
+    std::vector<std::unique_ptr<Slots>> all_slots_;
+    size_t size_ = 0;
+    size_t tombstones_ = 0;
+};
+
+}  // namespace app
@@ -0,0 +1,287 @@
+#include "world_image.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace world_image {
+
+namespace bip = boost::interprocess;
+using namespace std::literals;
+
+static_assert(std::endian::native == std::endian::little,
+              "World image is stored in little-endian byte order");
+static_assert(std::is_trivially_copyable_v<RoadView> && sizeof(RoadView) == 16);
+static_assert(std::is_trivially_copyable_v<BuildingView> && sizeof(BuildingView) == 16);
+static_assert(std::is_trivially_copyable_v<OfficeView> && sizeof(OfficeView) == 32);
+static_assert(sizeof(detail::Header) == 40 && sizeof(detail::MapRecord) == 80);
+
+namespace {
+
+constexpr char MAGIC[8] = {'G', 'S', 'W', 'O', 'R', 'L', 'D', '\0'};
+constexpr size_t ALIGN = 8;
+
+size_t AlignUp(size_t size) noexcept {
+    return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+// Контрольная сумма в духе FNV-1a, обрабатывающая данные словами по 8 байт.
+// Служит для обнаружения повреждённых и недописанных файлов
+std::uint64_t Checksum(const char* data, size_t size) noexcept {
+    constexpr std::uint64_t PRIME = 0x100000001b3;
+    std::uint64_t hash = 0xcbf29ce484222325;
+    size_t pos = 0;
+    for (; pos + sizeof(std::uint64_t) <= size; pos += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        hash = std::rotl((hash ^ word) * PRIME, 31);
+    }
+    for (; pos < size; ++pos) {
+        hash = (hash ^ static_cast<unsigned char>(data[pos])) * PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+bool IsArrayInBounds(std::uint64_t offset, std::uint64_t count, size_t file_size) noexcept {
+    return offset % alignof(T) == 0 && offset <= file_size
+        && count <= (file_size - offset) / sizeof(T);
+}
+
+bool IsStringInBounds(const detail::StringRef& ref, size_t file_size) noexcept {
+    return IsArrayInBounds<char>(ref.offset, ref.size, file_size);
+}
+
+}  // namespace
+
+/*
+ * Формирует образ мира в памяти. Сначала собирает все строки, чтобы знать
+ * их смещения, затем раскладывает разделы: заголовок, таблица карт, строки, массивы.
+ */
+class WorldWriter {
+public:
+    explicit WorldWriter(const model::Game& game)
+        : game_{game} {
+    }
+
+    std::string Write() {
+        const auto& maps = game_.GetMaps();
+        std::vector<detail::MapRecord> records(maps.size());
+        std::vector<std::vector<OfficeView>> offices(maps.size());
+
+        const size_t maps_offset = AlignUp(sizeof(detail::Header));
+        strings_offset_ = AlignUp(maps_offset + sizeof(detail::MapRecord) * maps.size());
+        for (size_t i = 0; i < maps.size(); ++i) {
+            const model::Map& map = maps[i];
+            records[i].id = AddString(map.GetId()->GetView());
+            records[i].name = AddString(map.GetName());
+            offices[i].reserve(map.GetOffices().size());
+            for (const auto& office : map.GetOffices()) {
+                offices[i].push_back(MakeOffice(office, AddString(office.GetId()->GetView())));
+            }
+        }
+
+        image_.resize(AlignUp(strings_offset_ + strings_.size()));
+        std::memcpy(image_.data() + strings_offset_, strings_.data(), strings_.size());
+
+        for (size_t i = 0; i < maps.size(); ++i) {
+            const model::Map& map = maps[i];
+            records[i].roads = AppendArray(map.GetRoads(), &MakeRoad);
+            records[i].buildings = AppendArray(map.GetBuildings(), &MakeBuilding);
+            records[i].offices = AppendArray(offices[i], [](const OfficeView& office) {
+                return office;
+            });
+        }
+        if (!records.empty()) {
+            std::memcpy(image_.data() + maps_offset, records.data(),
+                        sizeof(detail::MapRecord) * records.size());
+        }
+
+        detail::Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.map_count = static_cast<std::uint32_t>(maps.size());
+        header.file_size = image_.size();
+        header.checksum = Checksum(image_.data() + sizeof(header), image_.size() - sizeof(header));
+        header.maps_offset = maps_offset;
+        std::memcpy(image_.data(), &header, sizeof(header));
+
+        return std::move(image_);
+    }
+
+private:
+    static RoadView MakeRoad(const model::Road& road) noexcept {
+        RoadView view;
+        view.x0_ = road.GetStart().x;
+        view.y0_ = road.GetStart().y;
+        view.x1_ = road.GetEnd().x;
+        view.y1_ = road.GetEnd().y;
+        return view;
+    }
+
+    static BuildingView MakeBuilding(const model::Building& building) noexcept {
+        const auto& bounds = building.GetBounds();
+        BuildingView view;
+        view.x_ = bounds.position.x;
+        view.y_ = bounds.position.y;
+        view.width_ = bounds.size.width;
+        view.height_ = bounds.size.height;
+        return view;
+    }
+
+    static OfficeView MakeOffice(const model::Office& office, detail::StringRef id) noexcept {
+        OfficeView view;
+        view.id_ = id;
+        view.x_ = office.GetPosition().x;
+        view.y_ = office.GetPosition().y;
+        view.dx_ = office.GetOffset().dx;
+        view.dy_ = office.GetOffset().dy;
+        return view;
+    }
+
+    detail::StringRef AddString(std::string_view str) {
+        const detail::StringRef ref{strings_offset_ + strings_.size(), str.size()};
+        strings_.append(str);
+        return ref;
+    }
+
+    template <typename Items, typename Convert>
+    detail::ArrayRef AppendArray(const Items& items, Convert convert) {
+        const size_t offset = image_.size();
+        image_.resize(AlignUp(offset + sizeof(decltype(convert(items[0]))) * items.size()));
+        char* out = image_.data() + offset;
+        for (const auto& item : items) {
+            const auto record = convert(item);
+            std::memcpy(out, &record, sizeof(record));
+            out += sizeof(record);
+        }
+        return {offset, items.size()};
+    }
+
+    const model::Game& game_;
+    size_t strings_offset_ = 0;
+    std::string strings_;
+    std::string image_;
+};
+
+model::Map MapView::ToMap() const {
+    model::Map map{model::Map::Id{util::InternedString{GetId()}}, std::string{GetName()}};
+    for (const auto& road : GetRoads()) {
+        if (road.IsHorizontal()) {
+            map.AddRoad({model::Road::HORIZONTAL, road.GetStart(), road.GetEnd().x});
+        } else {
+            map.AddRoad({model::Road::VERTICAL, road.GetStart(), road.GetEnd().y});
+        }
+    }
+    for (const auto& building : GetBuildings()) {
+        map.AddBuilding(model::Building{building.GetBounds()});
+    }
+    for (const auto& office : GetOffices()) {
+        map.AddOffice({model::Office::Id{util::InternedString{GetOfficeId(office)}}, office.GetPosition(),
+                       office.GetOffset()});
+    }
+    return map;
+}
+
+WorldImage::WorldImage(const std::filesystem::path& path) {
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to open file "s + path.string());
+    }
+    if (file_size < sizeof(detail::Header)) {
+        throw std::runtime_error("World image "s + path.string() + " is truncated"s);
+    }
+    file_ = bip::file_mapping{path.string().c_str(), bip::read_only};
+    region_ = bip::mapped_region{file_, bip::read_only};
+    base_ = static_cast<const char*>(region_.get_address());
+    Validate(path);
+
+    detail::Header header;
+    std::memcpy(&header, base_, sizeof(header));
+    maps_ = {reinterpret_cast<const detail::MapRecord*>(base_ + header.maps_offset),
+             header.map_count};
+}
+
+void WorldImage::Validate(const std::filesystem::path& path) const {
+    const auto fail = [&path](std::string_view reason) {
+        throw std::runtime_error("Invalid world image "s + path.string() + ": "s
+                                 + std::string{reason});
+    };
+
+    const size_t size = region_.get_size();
+    detail::Header header;
+    std::memcpy(&header, base_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        fail("bad signature"sv);
+    }
+    if (header.version != FORMAT_VERSION) {
+        fail("unsupported version "s + std::to_string(header.version));
+    }
+    if (header.file_size != size) {
+        fail("file size mismatch"sv);
+    }
+    if (header.checksum != Checksum(base_ + sizeof(header), size - sizeof(header))) {
+        fail("checksum mismatch"sv);
+    }
+    if (!IsArrayInBounds<detail::MapRecord>(header.maps_offset, header.map_count, size)) {
+        fail("map table is out of bounds"sv);
+    }
+
+    const auto* records = reinterpret_cast<const detail::MapRecord*>(base_ + header.maps_offset);
+    for (const auto& record : std::span{records, header.map_count}) {
+        if (!IsStringInBounds(record.id, size) || !IsStringInBounds(record.name, size)
+            || !IsArrayInBounds<RoadView>(record.roads.offset, record.roads.count, size)
+            || !IsArrayInBounds<BuildingView>(record.buildings.offset, record.buildings.count,
+                                              size)
+            || !IsArrayInBounds<OfficeView>(record.offices.offset, record.offices.count, size)) {
+            fail("map record is out of bounds"sv);
+        }
+        const MapView map{base_, record};
+        for (const auto& road : map.GetRoads()) {
+            if (!road.IsHorizontal() && !road.IsVertical()) {
+                fail("road is neither horizontal nor vertical"sv);
+            }
+        }
+        for (const auto& office : map.GetOffices()) {
+            if (!IsStringInBounds(office.id_, size)) {
+                fail("office id is out of bounds"sv);
+            }
+        }
+    }
+}
+
+model::Game WorldImage::ToGame() const {
+    model::Game game;
+    for (size_t i = 0; i < GetMapCount(); ++i) {
+        game.AddMap(GetMap(i).ToMap());
+    }
+    return game;
+}
+
+bool IsWorldImage(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    char magic[sizeof(MAGIC)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void WriteWorldImage(const model::Game& game, const std::filesystem::path& path) {
+    const std::string image = WorldWriter{game}.Write();
+
+    auto tmp_path = path;
+    tmp_path += ".tmp"sv;
+    {
+        std::ofstream out{tmp_path, std::ios::binary | std::ios::trunc};
+        if (!out.write(image.data(), static_cast<std::streamsize>(image.size())) || !out.flush()) {
+            throw std::runtime_error("Failed to write world image "s + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+}  // namespace world_image
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+#include "model.h"
+
+/*
+ * Двоичный образ мира игры (world.bin).
+ *
+ * Образ создаётся из конфигурации командой game_server --compile-config и при запуске
+ * сервера отображается в память без разбора JSON. Все ссылки внутри образа задаются
+ * смещениями от начала файла, поэтому образ не зависит от адреса, по которому он
+ * отображён. Числа хранятся в порядке байтов little-endian.
+ *
+ * Структура файла:
+ *  - заголовок Header;
+ *  - таблица карт из Header::map_count записей MapRecord;
+ *  - строки: идентификаторы и названия карт, идентификаторы офисов;
+ *  - массивы дорог, зданий и офисов всех карт.
+ * Каждый раздел выровнен на 8 байт. Контрольная сумма охватывает всё содержимое
+ * файла после заголовка.
+ */
+namespace world_image {
+
+constexpr std::uint32_t FORMAT_VERSION = 1;
+
+namespace detail {
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t map_count;
+    std::uint64_t file_size;
+    std::uint64_t checksum;
+    std::uint64_t maps_offset;
+};
+
+// Строка в разделе строк образа
+struct StringRef {
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+// Массив записей фиксированного размера
+struct ArrayRef {
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct MapRecord {
+    StringRef id;
+    StringRef name;
+    ArrayRef roads;
+    ArrayRef buildings;
+    ArrayRef offices;
+};
+
+}  // namespace detail
+
+// Дорога в образе. Расположение полей совпадает с форматом файла
+class RoadView {
+public:
+    model::Point GetStart() const noexcept {
+        return {x0_, y0_};
+    }
+
+    model::Point GetEnd() const noexcept {
+        return {x1_, y1_};
+    }
+
+    bool IsHorizontal() const noexcept {
+        return y0_ == y1_;
+    }
+
+    bool IsVertical() const noexcept {
+        return x0_ == x1_;
+    }
+
+private:
+    friend class WorldWriter;
+
+    std::int32_t x0_, y0_, x1_, y1_;
+};
+
+// Здание в образе
+class BuildingView {
+public:
+    model::Rectangle GetBounds() const noexcept {
+        return {{x_, y_}, {width_, height_}};
+    }
+
+private:
+    friend class WorldWriter;
+
+    std::int32_t x_, y_, width_, height_;
+};
+
+// Офис в образе. Идентификатор хранится в разделе строк, поэтому получить его можно
+// только через MapView::GetOfficeId
+class OfficeView {
+public:
+    model::Point GetPosition() const noexcept {
+        return {x_, y_};
+    }
+
+    model::Offset GetOffset() const noexcept {
+        return {dx_, dy_};
+    }
+
+private:
+    friend class MapView;
+    friend class WorldImage;
+    friend class WorldWriter;
+
+    detail::StringRef id_;
+    std::int32_t x_, y_, dx_, dy_;
+};
+
+/*
+ * Карта в отображённом в память образе. Не владеет данными: строки и массивы
+ * ссылаются на память образа и действительны, пока существует WorldImage.
+ */
+class MapView {
+public:
+    MapView(const char* base, const detail::MapRecord& record) noexcept
+        : base_{base}
+        , record_{&record} {
+    }
+
+    std::string_view GetId() const noexcept {
+        return GetString(record_->id);
+    }
+
+    std::string_view GetName() const noexcept {
+        return GetString(record_->name);
+    }
+
+    std::span<const RoadView> GetRoads() const noexcept {
+        return GetArray<RoadView>(record_->roads);
+    }
+
+    std::span<const BuildingView> GetBuildings() const noexcept {
+        return GetArray<BuildingView>(record_->buildings);
+    }
+
+    std::span<const OfficeView> GetOffices() const noexcept {
+        return GetArray<OfficeView>(record_->offices);
+    }
+
+    std::string_view GetOfficeId(const OfficeView& office) const noexcept {
+        return GetString(office.id_);
+    }
+
+    // Создаёт объект модели с копией данных карты
+    model::Map ToMap() const;
+
+private:
+    std::string_view GetString(const detail::StringRef& ref) const noexcept {
+        return {base_ + ref.offset, static_cast<size_t>(ref.size)};
+    }
+
+    template <typename T>
+    std::span<const T> GetArray(const detail::ArrayRef& ref) const noexcept {
+        return {reinterpret_cast<const T*>(base_ + ref.offset), static_cast<size_t>(ref.count)};
+    }
+
+    const char* base_;
+    const detail::MapRecord* record_;
+};
+
+/*
+ * Образ мира, отображённый в память только для чтения.
+ * При открытии проверяются сигнатура, версия формата, размер файла, контрольная сумма
+ * и то, что все смещения указывают внутрь файла. В случае ошибки конструктор
+ * выбрасывает std::runtime_error.
+ */
+class WorldImage {
+public:
+    explicit WorldImage(const std::filesystem::path& path);
+
+    WorldImage(const WorldImage&) = delete;
+    WorldImage& operator=(const WorldImage&) = delete;
+
+    size_t GetMapCount() const noexcept {
+        return maps_.size();
+    }
+
+    MapView GetMap(size_t index) const noexcept {
+        return {base_, maps_[index]};
+    }
+
+    // Создаёт модель игры с копией данных всех карт
+    model::Game ToGame() const;
+
+private:
+    void Validate(const std::filesystem::path& path) const;
+
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+    const char* base_ = nullptr;
+    std::span<const detail::MapRecord> maps_;
+};
+
+// Проверяет, начинается ли файл с сигнатуры образа мира
+bool IsWorldImage(const std::filesystem::path& path);
+
+// Записывает образ мира game в файл path. Образ сначала записывается во временный
+// файл рядом с path, который затем переименовывается, поэтому работающие с path
+// процессы никогда не увидят недописанный образ
+void WriteWorldImage(const model::Game& game, const std::filesystem::path& path);
+
+}  // namespace world_image
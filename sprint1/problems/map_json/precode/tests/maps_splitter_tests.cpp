@@ -0,0 +1,60 @@
+// Проверяет разделение конфигурационного файла на скелет и тексты карт
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/maps_splitter.h"
+
+using namespace std::literals;
+using namespace json_loader;
+
+TEST_CASE("Maps are cut out of the document", "[SplitMaps]") {
+    const auto document = R"({"defaultDogSpeed": 3.0, "maps": [ {"id": "a", "roads": [[1], {}]} ,
+{"id": "b]}\"", "name": "{"}], "extra": {"maps": [1]}})"sv;
+    const auto layout = SplitMaps(document);
+    REQUIRE(layout);
+    CHECK(layout->maps
+          == std::vector{R"({"id": "a", "roads": [[1], {}]})"sv,
+                         R"({"id": "b]}\"", "name": "{"})"sv});
+    CHECK(layout->skeleton
+          == R"({"defaultDogSpeed": 3.0, "maps": [ 0 ,
+1], "extra": {"maps": [1]}})"s);
+    // Тексты карт ссылаются на исходный документ, а не на копию
+    CHECK(layout->maps.front().data() == document.data() + document.find("{\"id\""sv));
+}
+
+TEST_CASE("Empty maps array is kept as is", "[SplitMaps]") {
+    const auto document = R"( { "maps" : [ ] } )"sv;
+    const auto layout = SplitMaps(document);
+    REQUIRE(layout);
+    CHECK(layout->maps.empty());
+    CHECK(layout->skeleton == document);
+}
+
+TEST_CASE("Scalar elements are cut out too", "[SplitMaps]") {
+    // Текст 1 разберётся отдельно и будет отвергнут как элемент, не являющийся объектом
+    const auto layout = SplitMaps(R"({"maps": [1, "x", {}]})"sv);
+    REQUIRE(layout);
+    CHECK(layout->maps == std::vector{"1"sv, R"("x")"sv, "{}"sv});
+    CHECK(layout->skeleton == R"({"maps": [0, 1, 2]})"s);
+}
+
+TEST_CASE("Documents without a recognizable maps array are parsed whole", "[SplitMaps]") {
+    for (const auto document : {
+             ""sv,
+             "[]"sv,
+             R"({})"sv,
+             R"({"maps": {}})"sv,
+             R"({"other": [1], "nested": {"maps": []}})"sv,
+             R"({"maps": [{}, ]})"sv,
+             R"({"maps": [{} {}]})"sv,
+             R"({"maps": [{"id": "a"})"sv,
+             R"({"maps": [{"id": "a}])"sv,
+             R"({"maps" [{}]})"sv,
+             R"({"a": "b)"sv,
+         }) {
+        INFO("Document: " << document);
+        CHECK_FALSE(SplitMaps(document));
+    }
+}
@@ -0,0 +1,34 @@
+// Проверяет app::Players: выданный при входе токен находит игрока, а чужой - нет
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+#include "../src/players.h"
+
+using namespace std::literals;
+
+TEST_CASE("Issued tokens find their players", "[Players]") {
+    const model::Map map1{model::Map::Id{util::InternedString{"map1"s}}, "Map 1"s};
+    const model::Map map2{model::Map::Id{util::InternedString{"map2"s}}, "Map 2"s};
+    app::Players players;
+
+    const app::Token token1 = players.Add(map1, 0);
+    const app::Token token2 = players.Add(map2, 0);
+    const app::Token token3 = players.Add(map1, 1);
+    CHECK(token1 != token2);
+    CHECK(token1 != token3);
+
+    const app::Player* player = players.FindByToken(token3);
+    REQUIRE(player);
+    CHECK(player->map == &map1);
+    CHECK(player->dog_id == 1);
+    REQUIRE(players.FindByToken(token2));
+    CHECK(players.FindByToken(token2)->map == &map2);
+
+    // Токен, разобранный из заголовка Authorization, находит того же игрока
+    const auto header = "Bearer "s + token1.ToString();
+    const auto parsed = app::Token::ParseBearer(header);
+    REQUIRE(parsed);
+    CHECK(players.FindByToken(*parsed) == players.FindByToken(token1));
+
+    CHECK_FALSE(players.FindByToken(app::Token{token1.hi ^ 1, token1.lo}));
+}
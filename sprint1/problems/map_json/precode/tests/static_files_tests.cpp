@@ -0,0 +1,124 @@
+// Проверяет разбор заголовков запроса статических файлов: Range, Accept-Encoding
+// и URL-декодирование пути, в том числе на некорректных данных
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "../src/static_files.h"
+
+using namespace std::literals;
+using namespace http_handler;
+
+namespace {
+
+RangeParseResult ParseRangeResult(std::string_view header, std::uint64_t file_size) {
+    ByteRange range{};
+    return ParseRange(header, file_size, range);
+}
+
+// Возвращает границы диапазона или std::nullopt, если заголовок не задаёт диапазон
+std::optional<std::pair<std::uint64_t, std::uint64_t>> ParseRangeBounds(
+    std::string_view header, std::uint64_t file_size) {
+    ByteRange range{};
+    if (ParseRange(header, file_size, range) != RangeParseResult::RANGE) {
+        return std::nullopt;
+    }
+    return std::pair{range.first, range.last};
+}
+
+std::optional<std::string_view> Decode(std::string_view encoded, std::array<char, 64>& buffer,
+                                       std::size_t buffer_size = 64) {
+    return UrlDecode(encoded, std::span{buffer.data(), buffer_size});
+}
+
+}  // namespace
+
+TEST_CASE("Single byte ranges", "[ParseRange]") {
+    using Bounds = std::pair<std::uint64_t, std::uint64_t>;
+    CHECK(ParseRangeBounds("bytes=0-4"sv, 10) == Bounds{0, 4});
+    CHECK(ParseRangeBounds("bytes=5-"sv, 10) == Bounds{5, 9});
+    CHECK(ParseRangeBounds("bytes=-3"sv, 10) == Bounds{7, 9});
+    CHECK(ParseRangeBounds(" bytes=1-2 "sv, 10) == Bounds{1, 2});
+    CHECK(ParseRangeBounds("bytes= 1 - 2"sv, 10) == Bounds{1, 2});
+
+    // Суффикс длиннее файла и конец за пределами файла ограничиваются размером файла
+    CHECK(ParseRangeBounds("bytes=-20"sv, 10) == Bounds{0, 9});
+    CHECK(ParseRangeBounds("bytes=3-100"sv, 10) == Bounds{3, 9});
+}
+
+TEST_CASE("Unsatisfiable byte ranges", "[ParseRange]") {
+    CHECK(ParseRangeResult("bytes=10-"sv, 10) == RangeParseResult::UNSATISFIABLE);
+    CHECK(ParseRangeResult("bytes=10-20"sv, 10) == RangeParseResult::UNSATISFIABLE);
+    CHECK(ParseRangeResult("bytes=-0"sv, 10) == RangeParseResult::UNSATISFIABLE);
+    CHECK(ParseRangeResult("bytes=0-"sv, 0) == RangeParseResult::UNSATISFIABLE);
+    CHECK(ParseRangeResult("bytes=-5"sv, 0) == RangeParseResult::UNSATISFIABLE);
+}
+
+TEST_CASE("Multiple ranges are served as the whole file", "[ParseRange]") {
+    CHECK(ParseRangeResult("bytes=0-1,3-4"sv, 10) == RangeParseResult::NONE);
+    CHECK(ParseRangeResult("bytes=0-1, 100-200"sv, 10) == RangeParseResult::NONE);
+}
+
+TEST_CASE("Malformed Range headers are ignored", "[ParseRange]") {
+    for (const auto header : {""sv, "bytes="sv, "bytes=-"sv, "bytes=5"sv, "bytes=abc-"sv,
+                              "bytes=1-x"sv, "bytes=5-2"sv, "bytes=1-2-3"sv, "bytes=--1"sv,
+                              "bytes=+1-2"sv, "items=0-1"sv, "Bytes=0-1"sv,
+                              "bytes=99999999999999999999-"sv}) {
+        INFO("Range: " << header);
+        CHECK(ParseRangeResult(header, 10) == RangeParseResult::NONE);
+    }
+}
+
+TEST_CASE("Best available encoding is chosen", "[ChooseEncoding]") {
+    CHECK(ChooseEncoding("gzip, br"sv, true, true) == ContentEncoding::BROTLI);
+    CHECK(ChooseEncoding("gzip, br"sv, true, false) == ContentEncoding::GZIP);
+    CHECK(ChooseEncoding("gzip, br"sv, false, false) == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding("br"sv, true, false) == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding(""sv, true, true) == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding("GZip"sv, true, false) == ContentEncoding::GZIP);
+    CHECK(ChooseEncoding(" gzip ;q=0.5 "sv, true, false) == ContentEncoding::GZIP);
+}
+
+TEST_CASE("Zero quality forbids an encoding", "[ChooseEncoding]") {
+    CHECK(ChooseEncoding("br;q=0, gzip"sv, true, true) == ContentEncoding::GZIP);
+    CHECK(ChooseEncoding("gzip;q=0"sv, true, false) == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding("gzip; Q=0.000"sv, true, false) == ContentEncoding::IDENTITY);
+}
+
+TEST_CASE("Malformed and unknown codings are skipped", "[ChooseEncoding]") {
+    CHECK(ChooseEncoding(",,;"sv, true, true) == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding("x-gzip, identity, deflate"sv, true, true)
+          == ContentEncoding::IDENTITY);
+    CHECK(ChooseEncoding("gzip;q="sv, true, false) == ContentEncoding::GZIP);
+    CHECK(ChooseEncoding(";q=0, gzip"sv, true, false) == ContentEncoding::GZIP);
+}
+
+TEST_CASE("Percent-encoded paths are decoded", "[UrlDecode]") {
+    std::array<char, 64> buffer;
+    CHECK(Decode("/index.html"sv, buffer) == "/index.html"sv);
+    CHECK(Decode(""sv, buffer) == ""sv);
+    CHECK(Decode("/a%20b"sv, buffer) == "/a b"sv);
+    CHECK(Decode("%2Fx%2f"sv, buffer) == "/x/"sv);
+    CHECK(Decode("%41"sv, buffer) == "A"sv);
+    // '+' в пути не означает пробел
+    CHECK(Decode("/a+b"sv, buffer) == "/a+b"sv);
+    CHECK(Decode("%00"sv, buffer) == "\0"sv);
+}
+
+TEST_CASE("Malformed percent sequences are rejected", "[UrlDecode]") {
+    std::array<char, 64> buffer;
+    for (const auto encoded : {"%"sv, "/a%"sv, "/a%4"sv, "/a%zz"sv, "/a%4g"sv, "%%41"sv}) {
+        INFO("Path: " << encoded);
+        CHECK_FALSE(Decode(encoded, buffer));
+    }
+}
+
+TEST_CASE("Decoded path must fit the buffer", "[UrlDecode]") {
+    std::array<char, 64> buffer;
+    CHECK(Decode("/abc"sv, buffer, 4) == "/abc"sv);
+    CHECK_FALSE(Decode("/abcd"sv, buffer, 4));
+    CHECK(Decode("%41%42"sv, buffer, 2) == "AB"sv);
+    CHECK_FALSE(Decode("/x"sv, buffer, 0));
+}
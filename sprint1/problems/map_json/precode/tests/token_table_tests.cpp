@@ -0,0 +1,72 @@
+// Проверяет app::TokenTable: поиск после добавления и удаления токенов, а также то,
+// что добавление и удаление токенов при постоянном количестве игроков не увеличивает
+// занятую таблицей память
+#include <catch2/catch_test_macros.hpp>
+#include <deque>
+#include <vector>
+
+#include "../src/token_table.h"
+
+namespace {
+
+struct Player {
+    int id;
+};
+
+}  // namespace
+
+TEST_CASE("Tokens are found after inserts and removals", "[TokenTable]") {
+    app::TokenTable<Player> table;
+    app::TokenGenerator generator;
+    std::vector<Player> players(1000);
+    std::vector<app::Token> tokens;
+    for (size_t i = 0; i < players.size(); ++i) {
+        players[i].id = static_cast<int>(i);
+        tokens.push_back(generator.Generate());
+        CHECK(table.Insert(tokens.back(), &players[i]));
+    }
+    CHECK_FALSE(table.Insert(tokens.front(), &players.back()));
+    CHECK(table.GetSize() == players.size());
+
+    for (size_t i = 0; i < tokens.size(); i += 2) {
+        CHECK(table.Remove(tokens[i]));
+    }
+    CHECK_FALSE(table.Remove(tokens.front()));
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        CHECK(table.Find(tokens[i]) == (i % 2 == 0 ? nullptr : &players[i]));
+    }
+}
+
+// Удалённые ячейки вызывают перестройку таблицы. Она не должна оставлять прежние массивы
+TEST_CASE("Token churn does not retain memory", "[TokenTable]") {
+    constexpr size_t LIVE_TOKENS = 32;
+    constexpr int CYCLES = 200'000;
+
+    app::TokenTable<Player> table;
+    app::TokenGenerator generator;
+    Player player{0};
+    std::deque<app::Token> live;
+    for (size_t i = 0; i < LIVE_TOKENS; ++i) {
+        live.push_back(generator.Generate());
+        table.Insert(live.back(), &player);
+    }
+    size_t failed_inserts = 0;
+    size_t failed_removals = 0;
+    for (int i = 0; i < CYCLES; ++i) {
+        live.push_back(generator.Generate());
+        failed_inserts += !table.Insert(live.back(), &player);
+        failed_removals += !table.Remove(live.front());
+        live.pop_front();
+    }
+    CHECK(failed_inserts == 0);
+    CHECK(failed_removals == 0);
+
+    CHECK(table.GetSize() == LIVE_TOKENS);
+    // Таблица вырастает не больше чем до нескольких ёмкостей, нужных живым токенам,
+    // а прежние массивы вместе не больше текущего
+    CHECK(table.GetCapacity() <= LIVE_TOKENS * 8);
+    CHECK(table.GetRetainedCapacity() < table.GetCapacity() * 2);
+    for (const auto& token : live) {
+        CHECK(table.Find(token) == &player);
+    }
+}
@@ -0,0 +1,120 @@
+// Сравнивает выполнение заказов цепочкой обработчиков (Restaurant::MakeHamburger)
+// и сопрограммами-поварами (Restaurant::MakeHamburgerCoroutine). Таймеры срабатывают сразу,
+// поэтому измеряются накладные расходы самих заказов и количество выделений памяти на заказ.
+// Одновременно выполняется in_flight заказов: выполненный заказ сразу заменяется новым
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#include "../src/restaurant.h"
+
+namespace {
+
+// Количество обращений программы к operator new
+std::atomic<size_t> allocations{0};
+
+struct RunResult {
+    double orders_per_second = 0;
+    double allocations_per_order = 0;
+};
+
+// Выполняет num_orders заказов методом make_order ресторана, заказы с луком и без
+// чередуются
+RunResult Run(int num_orders, int in_flight, const CookingTimes& times,
+              int (Restaurant::*make_order)(bool, OrderHandler)) {
+    net::io_context io{1};
+    Restaurant restaurant{io, times};
+
+    struct State {
+        Restaurant& restaurant;
+        int (Restaurant::*make_order)(bool, OrderHandler);
+        int num_orders;
+        int started = 0;
+        int completed = 0;
+
+        void MakeOrder() {
+            const bool with_onion = started++ % 2 == 0;
+            // Обработчик хранит один указатель и помещается в std::function без выделения памяти
+            (restaurant.*make_order)(with_onion, [this](sys::error_code ec, int /*id*/,
+                                                        Hamburger* hamburger) {
+                OnReady(ec, hamburger);
+            });
+        }
+
+        void OnReady(sys::error_code ec, Hamburger* hamburger) {
+            if (ec || !hamburger->IsPacked()) {
+                std::cerr << "Order failed: "sv << ec.message() << std::endl;
+                std::abort();
+            }
+            ++completed;
+            if (started < num_orders) {
+                MakeOrder();
+            }
+        }
+    } state{restaurant, make_order, num_orders};
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t allocations_before = allocations.load(std::memory_order_relaxed);
+    // Заказы делаются внутри io, как в обработчиках настоящего ресторана
+    net::post(io, [&state, in_flight] {
+        while (state.started < std::min(in_flight, state.num_orders)) {
+            state.MakeOrder();
+        }
+    });
+    io.run();
+    const size_t order_allocations =
+        allocations.load(std::memory_order_relaxed) - allocations_before;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return {state.completed / elapsed.count(),
+            static_cast<double>(order_allocations) / state.completed};
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+// Память, выделенная заменённым operator new, получена от std::malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main(int argc, const char* argv[]) {
+    const int num_orders = argc > 1 ? std::atoi(argv[1]) : 1'000'000;
+    const int in_flight = argc > 2 ? std::atoi(argv[2]) : 64;
+    const CookingTimes instant{Timer::duration::zero(), Timer::duration::zero()};
+
+    const RunResult callbacks = Run(num_orders, in_flight, instant, &Restaurant::MakeHamburger);
+    const RunResult coroutines =
+        Run(num_orders, in_flight, instant, &Restaurant::MakeHamburgerCoroutine);
+
+    std::cout << "orders: "sv << num_orders << ", in flight: "sv << in_flight << '\n';
+    for (const auto& [name, result] : {std::pair{"callbacks"sv, callbacks},
+                                       std::pair{"coroutines"sv, coroutines}}) {
+        std::cout << name << ": "sv << result.orders_per_second << " orders/s, "sv
+                  << result.allocations_per_order << " allocations per order"sv << std::endl;
+    }
+}
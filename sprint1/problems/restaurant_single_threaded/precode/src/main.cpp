@@ -2,7 +2,7 @@
 #include <sdkddkver.h>
 #endif
 
-#include <boost/asio.hpp>
+#include <cassert>
 #include <chrono>
 #include <iostream>
 #include <mutex>
@@ -10,63 +10,10 @@
 #include <syncstream>
 #include <unordered_map>
 
-namespace net = boost::asio;
-namespace sys = boost::system;
+#include "restaurant.h"
+
 namespace ph = std::placeholders;
 using namespace std::chrono;
-using namespace std::literals;
-using Timer = net::steady_timer;
-
-class Hamburger {
-public:
-    [[nodiscard]] bool IsCutletRoasted() const {
-        return cutlet_roasted_;
-    }
-    void SetCutletRoasted() {
-        if (IsCutletRoasted()) {  // Котлету можно жарить только один раз
-            throw std::logic_error("Cutlet has been roasted already"s);
-        }
-        cutlet_roasted_ = true;
-    }
-
-    [[nodiscard]] bool HasOnion() const {
-        return has_onion_;
-    }
-    // Добавляем лук
-    void AddOnion() {
-        if (IsPacked()) {  // Если гамбургер упакован, класть лук в него нельзя
-            throw std::logic_error("Hamburger has been packed already"s);
-        }
-        AssureCutletRoasted();  // Лук разрешается класть лишь после прожаривания котлеты
-        has_onion_ = true;
-    }
-
-    [[nodiscard]] bool IsPacked() const {
-        return is_packed_;
-    }
-    void Pack() {
-        AssureCutletRoasted();  // Нельзя упаковывать гамбургер, если котлета не прожарена
-        is_packed_ = true;
-    }
-
-private:
-    // Убеждаемся, что котлета прожарена
-    void AssureCutletRoasted() const {
-        if (!cutlet_roasted_) {
-            throw std::logic_error("Bread has not been roasted yet"s);
-        }
-    }
-
-    bool cutlet_roasted_ = false;  // Обжарена ли котлета?
-    bool has_onion_ = false;       // Есть ли лук?
-    bool is_packed_ = false;       // Упакован ли гамбургер?
-};
-
-std::ostream& operator<<(std::ostream& os, const Hamburger& h) {
-    return os << "Hamburger: "sv << (h.IsCutletRoasted() ? "roasted cutlet"sv : " raw cutlet"sv)
-              << (h.HasOnion() ? ", onion"sv : ""sv)
-              << (h.IsPacked() ? ", packed"sv : ", not packed"sv);
-}
 
 class Logger {
 public:
@@ -85,26 +32,6 @@ private:
     steady_clock::time_point start_time_{steady_clock::now()};
 };
 
-// Функция, которая будет вызвана по окончании обработки заказа
-using OrderHandler = std::function<void(sys::error_code ec, int id, Hamburger* hamburger)>;
-
-class Restaurant {
-public:
-    explicit Restaurant(net::io_context& io)
-        : io_(io) {
-    }
-
-    int MakeHamburger(bool with_onion, OrderHandler handler) {
-        const int order_id = ++next_order_id_;
-        /* Напишите недостающий код */
-        return order_id;
-    }
-
-private:
-    net::io_context& io_;
-    int next_order_id_ = 0;
-};
-
 int main() {
     net::io_context io;
 
@@ -147,4 +74,27 @@ int main() {
         assert(o.hamburger.IsPacked());
         assert(o.hamburger.HasOnion());
     }
+
+    // Те же заказы, выполняемые сопрограммами
+    const int id3 = restaurant.MakeHamburgerCoroutine(false, handle_result);
+    const int id4 = restaurant.MakeHamburgerCoroutine(true, handle_result);
+    assert(orders.size() == 2u);
+    io.restart();
+    io.run();
+
+    assert(orders.size() == 4u);
+    {
+        const auto& o = orders.at(id3);
+        assert(!o.ec);
+        assert(o.hamburger.IsCutletRoasted());
+        assert(o.hamburger.IsPacked());
+        assert(!o.hamburger.HasOnion());
+    }
+    {
+        const auto& o = orders.at(id4);
+        assert(!o.ec);
+        assert(o.hamburger.IsCutletRoasted());
+        assert(o.hamburger.IsPacked());
+        assert(o.hamburger.HasOnion());
+    }
 }
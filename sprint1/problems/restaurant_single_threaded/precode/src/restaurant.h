@@ -0,0 +1,303 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <ostream>
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using namespace std::literals;
+using Timer = net::steady_timer;
+
+class Hamburger {
+public:
+    [[nodiscard]] bool IsCutletRoasted() const {
+        return cutlet_roasted_;
+    }
+    void SetCutletRoasted() {
+        if (IsCutletRoasted()) {  // Котлету можно жарить только один раз
+            throw std::logic_error("Cutlet has been roasted already"s);
+        }
+        cutlet_roasted_ = true;
+    }
+
+    [[nodiscard]] bool HasOnion() const {
+        return has_onion_;
+    }
+    // Добавляем лук
+    void AddOnion() {
+        if (IsPacked()) {  // Если гамбургер упакован, класть лук в него нельзя
+            throw std::logic_error("Hamburger has been packed already"s);
+        }
+        AssureCutletRoasted();  // Лук разрешается класть лишь после прожаривания котлеты
+        has_onion_ = true;
+    }
+
+    [[nodiscard]] bool IsPacked() const {
+        return is_packed_;
+    }
+    void Pack() {
+        AssureCutletRoasted();  // Нельзя упаковывать гамбургер, если котлета не прожарена
+        is_packed_ = true;
+    }
+
+private:
+    // Убеждаемся, что котлета прожарена
+    void AssureCutletRoasted() const {
+        if (!cutlet_roasted_) {
+            throw std::logic_error("Bread has not been roasted yet"s);
+        }
+    }
+
+    bool cutlet_roasted_ = false;  // Обжарена ли котлета?
+    bool has_onion_ = false;       // Есть ли лук?
+    bool is_packed_ = false;       // Упакован ли гамбургер?
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Hamburger& h) {
+    return os << "Hamburger: "sv << (h.IsCutletRoasted() ? "roasted cutlet"sv : " raw cutlet"sv)
+              << (h.HasOnion() ? ", onion"sv : ""sv)
+              << (h.IsPacked() ? ", packed"sv : ", not packed"sv);
+}
+
+// Функция, которая будет вызвана по окончании обработки заказа
+using OrderHandler = std::function<void(sys::error_code ec, int id, Hamburger* hamburger)>;
+
+// Продолжительность этапов приготовления гамбургера
+struct CookingTimes {
+    Timer::duration roast = std::chrono::seconds{1};
+    Timer::duration marinade = std::chrono::seconds{2};
+};
+
+// Заказ, выполняемый цепочкой обработчиков таймеров
+class Order : public std::enable_shared_from_this<Order> {
+public:
+    Order(net::io_context& io, int id, bool with_onion, CookingTimes times,
+          OrderHandler handler)
+        : io_{io}
+        , id_{id}
+        , with_onion_{with_onion}
+        , times_{times}
+        , handler_{std::move(handler)} {
+    }
+
+    // Запускает асинхронное выполнение заказа
+    void Execute() {
+        RoastCutlet();
+        if (with_onion_) {
+            MarinadeOnion();
+        }
+    }
+
+private:
+    void RoastCutlet() {
+        roast_timer_.expires_after(times_.roast);
+        roast_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            self->OnRoasted(ec);
+        });
+    }
+
+    void OnRoasted(sys::error_code ec) {
+        if (!ec) {
+            hamburger_.SetCutletRoasted();
+        }
+        CheckReadiness(ec);
+    }
+
+    // Лук маринуется, пока жарится котлета
+    void MarinadeOnion() {
+        marinade_timer_.expires_after(times_.marinade);
+        marinade_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            self->OnOnionMarinaded(ec);
+        });
+    }
+
+    void OnOnionMarinaded(sys::error_code ec) {
+        onion_marinaded_ = !ec;
+        CheckReadiness(ec);
+    }
+
+    void CheckReadiness(sys::error_code ec) {
+        if (delivered_) {
+            return;
+        }
+        if (ec) {
+            return Deliver(ec);
+        }
+        if (!hamburger_.IsCutletRoasted() || (with_onion_ && !onion_marinaded_)) {
+            return;
+        }
+        if (with_onion_) {
+            hamburger_.AddOnion();
+        }
+        hamburger_.Pack();
+        Deliver({});
+    }
+
+    void Deliver(sys::error_code ec) {
+        delivered_ = true;
+        // Заказ, выполнение которого прервано ошибкой, не ждёт второго таймера
+        roast_timer_.cancel();
+        marinade_timer_.cancel();
+        handler_(ec, id_, ec ? nullptr : &hamburger_);
+    }
+
+    net::io_context& io_;
+    int id_;
+    bool with_onion_;
+    CookingTimes times_;
+    OrderHandler handler_;
+    Timer roast_timer_{io_};
+    Timer marinade_timer_{io_};
+    Hamburger hamburger_;
+    bool onion_marinaded_ = false;
+    bool delivered_ = false;
+};
+
+/*
+ * Ресторан готовит гамбургеры в однопоточном io_context, поэтому обработчики заказов
+ * не требуют синхронизации.
+ * Заказ можно сделать двумя способами: MakeHamburger выполняет его цепочкой обработчиков
+ * таймеров, а MakeHamburgerCoroutine - сопрограммами-поварами. Сопрограмма CookHamburger
+ * позволяет ожидать гамбургер через co_await из другой сопрограммы.
+ */
+class Restaurant {
+public:
+    explicit Restaurant(net::io_context& io, CookingTimes times = {})
+        : io_(io)
+        , times_{times} {
+    }
+
+    Restaurant(const Restaurant&) = delete;
+    Restaurant& operator=(const Restaurant&) = delete;
+
+    int MakeHamburger(bool with_onion, OrderHandler handler) {
+        const int order_id = ++next_order_id_;
+        std::make_shared<Order>(io_, order_id, with_onion, times_, std::move(handler))
+            ->Execute();
+        return order_id;
+    }
+
+    /*
+     * Выполняет заказ так же, как MakeHamburger, но сопрограммой-поваром.
+     * Заказ встаёт в очередь, а новый повар запускается, только если очередь не разберут
+     * уже работающие повара. Повар, выполнивший заказ, сразу берёт следующий, поэтому
+     * пока заказы поступают, кадры сопрограмм поваров и их таймеры используются повторно,
+     * и заказ не выделяет память под свой кадр сопрограммы
+     */
+    int MakeHamburgerCoroutine(bool with_onion, OrderHandler handler) {
+        const int order_id = ++next_order_id_;
+        pending_orders_.push_back({order_id, with_onion, std::move(handler)});
+        if (pending_orders_.size() > ready_cooks_) {
+            ++ready_cooks_;
+            net::co_spawn(io_.get_executor(), RunCook(), [](std::exception_ptr error) {
+                // Исключение, выброшенное обработчиком заказа, покидает io.run(),
+                // как и в MakeHamburger
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            });
+        }
+        return order_id;
+    }
+
+    /*
+     * Готовит гамбургер в сопрограмме:
+     *
+     * Hamburger hamburger = co_await restaurant.CookHamburger(true);
+     *
+     * Ошибка ожидания таймера выбрасывается в виде исключения sys::system_error
+     */
+    net::awaitable<Hamburger> CookHamburger(bool with_onion) {
+        const auto executor = co_await net::this_coro::executor;
+        Hamburger hamburger;
+
+        // Таймер маринования запускается сразу, поэтому лук маринуется, пока жарится котлета
+        Timer marinade_timer{executor, times_.marinade};
+
+        Timer roast_timer{executor, times_.roast};
+        co_await roast_timer.async_wait(net::use_awaitable);
+        hamburger.SetCutletRoasted();
+
+        if (with_onion) {
+            if (marinade_timer.expiry() > Timer::clock_type::now()) {
+                co_await marinade_timer.async_wait(net::use_awaitable);
+            }
+            hamburger.AddOnion();
+        }
+
+        hamburger.Pack();
+        co_return hamburger;
+    }
+
+private:
+    struct PendingOrder {
+        int id;
+        bool with_onion;
+        OrderHandler handler;
+    };
+
+    // Повар работает с io_context напрямую, без стирания типа исполнителя в any_io_executor
+    using CookExecutor = net::io_context::executor_type;
+    using CookTimer =
+        net::basic_waitable_timer<Timer::clock_type, Timer::traits_type, CookExecutor>;
+
+    // Повар выполняет заказы из очереди, пока она не опустеет. Шаги заказа ожидаются прямо
+    // в кадре повара, а не во вложенной сопрограмме CookHamburger, чтобы заказ не создавал
+    // новый кадр
+    net::awaitable<void, CookExecutor> RunCook() {
+        constexpr net::use_awaitable_t<CookExecutor> use_awaitable;
+        const CookExecutor executor = co_await net::this_coro::executor;
+        CookTimer roast_timer{executor};
+        CookTimer marinade_timer{executor};
+
+        while (!pending_orders_.empty()) {
+            PendingOrder order = std::move(pending_orders_.front());
+            pending_orders_.pop_front();
+            --ready_cooks_;
+
+            Hamburger hamburger;
+            sys::error_code ec;
+            marinade_timer.expires_after(times_.marinade);
+            roast_timer.expires_after(times_.roast);
+            co_await roast_timer.async_wait(net::redirect_error(use_awaitable, ec));
+            if (!ec) {
+                hamburger.SetCutletRoasted();
+                // Лук, замаринованный раньше котлеты, не требует лишнего ожидания
+                if (order.with_onion && marinade_timer.expiry() > Timer::clock_type::now()) {
+                    co_await marinade_timer.async_wait(net::redirect_error(use_awaitable, ec));
+                }
+            }
+            if (!ec) {
+                if (order.with_onion) {
+                    hamburger.AddOnion();
+                }
+                hamburger.Pack();
+            }
+
+            // Повар, сообщающий о готовности заказа, возьмёт и заказ, сделанный обработчиком
+            ++ready_cooks_;
+            try {
+                order.handler(ec, order.id, ec ? nullptr : &hamburger);
+            } catch (...) {
+                --ready_cooks_;
+                throw;
+            }
+        }
+        --ready_cooks_;
+    }
+
+    net::io_context& io_;
+    CookingTimes times_;
+    int next_order_id_ = 0;
+    std::deque<PendingOrder> pending_orders_;
+    // Количество поваров, которые возьмут заказ из очереди, не дожидаясь таймеров
+    size_t ready_cooks_ = 0;
+};
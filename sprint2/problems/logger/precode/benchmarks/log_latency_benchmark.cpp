@@ -0,0 +1,96 @@
+// Измеряет задержку каждого вызова LOG в синхронном и асинхронном режимах логгера,
+// когда несколько потоков логируют одновременно, и выводит её перцентили
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../my_logger.h"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Каждый поток измеряет свои вызовы и сохраняет их длительности в наносекундах
+std::vector<std::int64_t> MeasureCalls(unsigned num_threads, int calls) {
+    std::vector<std::vector<std::int64_t>> latencies(num_threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&latencies, t, calls] {
+            auto& thread_latencies = latencies[t];
+            thread_latencies.reserve(calls);
+            // Первый вызов в потоке регистрирует его буфер и не измеряется
+            LOG("Warm up "sv, t);
+            for (int i = 0; i < calls; ++i) {
+                const auto start = Clock::now();
+                LOG("Logging attempt "sv, i, ". "sv, "I Love it"sv);
+                const auto finish = Clock::now();
+                thread_latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<std::int64_t> all;
+    all.reserve(static_cast<size_t>(calls) * num_threads);
+    for (const auto& thread_latencies : latencies) {
+        all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    return all;
+}
+
+std::int64_t Percentile(const std::vector<std::int64_t>& sorted, double fraction) {
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size()));
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void PrintLatencies(std::string_view mode, const std::vector<std::int64_t>& sorted) {
+    std::cout << mode << ": p50 "sv << Percentile(sorted, 0.5) << " ns, p99 "sv
+              << Percentile(sorted, 0.99) << " ns, p999 "sv << Percentile(sorted, 0.999)
+              << " ns, max "sv << sorted.back() << " ns"sv << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const unsigned num_threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int calls = argc > 2 ? std::atoi(argv[2]) : 100'000;
+    if (num_threads == 0 || calls <= 0) {
+        std::cerr << "Usage: log_latency_benchmark [threads] [calls per thread]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Пустой интервал показывает, сколько стоит само измерение времени
+    {
+        std::vector<std::int64_t> clock_overhead(calls);
+        for (auto& latency : clock_overhead) {
+            const auto start = Clock::now();
+            latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start)
+                          .count();
+        }
+        std::sort(clock_overhead.begin(), clock_overhead.end());
+        std::cout << "threads: "sv << num_threads << ", calls per thread: "sv << calls << '\n';
+        PrintLatencies("clock"sv, clock_overhead);
+    }
+
+    auto& logger = Logger::GetInstance();
+    PrintLatencies("sync"sv, MeasureCalls(num_threads, calls));
+
+    logger.EnableAsync();
+    PrintLatencies("async"sv, MeasureCalls(num_threads, calls));
+    logger.Flush();
+    const LogStats stats = logger.GetStats();
+    std::cout << "written: "sv << stats.written << ", dropped: "sv << stats.dropped
+              << ", blocked: "sv << stats.blocked << std::endl;
+    logger.StopAsync();
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+/*
+ * Кольцевой буфер записей переменной длины для одного писателя и одного читателя
+ * (single producer, single consumer). Не использует блокировок: писатель и читатель
+ * синхронизируются только через атомарные позиции head_ и tail_.
+ *
+ * Каждая запись хранится как 4-байтовая длина и следующие за ней данные, выровненные
+ * на RECORD_ALIGN байт. Если запись не помещается в конец буфера, остаток буфера
+ * заполняется записью-заглушкой, а сама запись размещается с начала буфера.
+ */
+class LogRing {
+public:
+    constexpr static size_t RECORD_ALIGN = 8;
+
+    // capacity округляется вверх до степени двойки
+    explicit LogRing(size_t capacity)
+        : capacity_{RoundUpToPowerOfTwo(capacity)}
+        , buffer_{std::make_unique<char[]>(capacity_)} {
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Максимальный размер записи, которую можно поместить в буфер
+    size_t MaxRecordSize() const noexcept {
+        return capacity_ / 2 - sizeof(Header);
+    }
+
+    // Помещает запись в буфер. Возвращает false, если в буфере нет места.
+    // Вызывается только потоком-писателем
+    bool TryPush(std::string_view record) noexcept {
+        if (record.size() > MaxRecordSize()) {
+            return false;
+        }
+        const size_t size = AlignUp(sizeof(Header) + record.size());
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+
+        size_t offset = head & (capacity_ - 1);
+        const size_t contiguous = capacity_ - offset;
+        const size_t needed = contiguous < size ? contiguous + size : size;
+        if (capacity_ - (head - tail) < needed) {
+            return false;
+        }
+
+        if (contiguous < size) {
+            WriteHeader(offset, PADDING);
+            head += contiguous;
+            offset = 0;
+        }
+        WriteHeader(offset, static_cast<Header>(record.size()));
+        std::memcpy(buffer_.get() + offset + sizeof(Header), record.data(), record.size());
+        head_.store(head + size, std::memory_order_release);
+        return true;
+    }
+
+    // Вызывает fn(std::string_view) для каждой записи буфера и освобождает занятое ими место.
+    // Запись действительна только во время вызова fn. Возвращает количество записей.
+    // Вызывается только потоком-читателем
+    template <typename Fn>
+    size_t ConsumeAll(Fn&& fn) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (tail != head) {
+            const size_t offset = tail & (capacity_ - 1);
+            const Header length = ReadHeader(offset);
+            if (length == PADDING) {
+                tail += capacity_ - offset;
+                continue;
+            }
+            fn(std::string_view{buffer_.get() + offset + sizeof(Header), length});
+            tail += AlignUp(sizeof(Header) + length);
+            ++count;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    bool Empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    using Header = std::uint32_t;
+    constexpr static Header PADDING = ~Header{0};
+
+    static size_t RoundUpToPowerOfTwo(size_t value) noexcept {
+        size_t result = RECORD_ALIGN * 2;
+        while (result < value) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    static size_t AlignUp(size_t size) noexcept {
+        return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    }
+
+    void WriteHeader(size_t offset, Header header) noexcept {
+        std::memcpy(buffer_.get() + offset, &header, sizeof(header));
+    }
+
+    Header ReadHeader(size_t offset) const noexcept {
+        Header header;
+        std::memcpy(&header, buffer_.get() + offset, sizeof(header));
+        return header;
+    }
+
+    const size_t capacity_;
+    const std::unique_ptr<char[]> buffer_;
+    // Позиции монотонно растут, смещение в буфере получается по модулю capacity_.
+    // Позиции лежат в разных кеш-линиях, чтобы писатель и читатель не мешали друг другу
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
@@ -1,11 +1,18 @@
 #include "my_logger.h"
 
+#include <iostream>
 #include <string_view>
 #include <thread>
 
 using namespace std::literals;
 
-int main() {
+int main(int argc, const char* argv[]) {
+    // С ключом --async сообщения записываются в файл отдельным потоком
+    const bool async = argc > 1 && argv[1] == "--async"sv;
+    if (async) {
+        Logger::GetInstance().EnableAsync();
+    }
+
     // Будем устанавливать моменты времени в секундах от начала эпохи.
     // Конкретные значения не так важны, главное, что часы идут монотонно.
     Logger::GetInstance().SetTimestamp(std::chrono::system_clock::time_point{1000000s});
@@ -29,4 +36,11 @@ int main() {
 
         LOG("Logging attempt ", i, ". ", "I Love it");
     }
+
+    if (async) {
+        Logger::GetInstance().Flush();
+        const LogStats stats = Logger::GetInstance().GetStats();
+        std::cout << "written: "sv << stats.written << ", dropped: "sv << stats.dropped
+                  << ", blocked: "sv << stats.blocked << std::endl;
+    }
 }
@@ -1,40 +1,108 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <iomanip>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <optional>
 #include <mutex>
 #include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "log_ring.h"
 
 using namespace std::literals;
 
 #define LOG(...) Logger::GetInstance().Log(__VA_ARGS__)
 
+// Параметры асинхронного режима логгера
+struct AsyncLogOptions {
+    // Что делать, если кольцевой буфер потока переполнен
+    enum class OverflowPolicy {
+        // Ждать, пока поток записи освободит место
+        BLOCK,
+        // Отбросить сообщение
+        DROP,
+    };
+
+    // Размер кольцевого буфера каждого потока, вызывающего Log
+    size_t ring_size = 1 << 20;
+    OverflowPolicy overflow_policy = OverflowPolicy::BLOCK;
+    // Пауза потока записи, когда все буферы пусты
+    std::chrono::microseconds idle_sleep{500};
+    // Размер блока, который поток записи накапливает перед записью в файл
+    size_t write_batch_size = 64 * 1024;
+};
+
+// Счётчики сообщений асинхронного режима
+struct LogStats {
+    // Сообщения, записанные в файл
+    std::uint64_t written = 0;
+    // Сообщения, отброшенные из-за переполнения буфера
+    std::uint64_t dropped = 0;
+    // Вызовы Log, которым пришлось ждать освобождения места в буфере
+    std::uint64_t blocked = 0;
+};
+
 class Logger {
+    using Clock = std::chrono::system_clock;
+
+    // Значение manual_ts_, означающее, что время не задано вручную
+    constexpr static Clock::rep NO_MANUAL_TS = std::numeric_limits<Clock::rep>::min();
+
     auto GetTime() const {
-        if (manual_ts_) {
-            return *manual_ts_;
+        if (const auto manual_ts = manual_ts_.load(std::memory_order_acquire);
+            manual_ts != NO_MANUAL_TS) {
+            return Clock::time_point{Clock::duration{manual_ts}};
         }
 
-        return std::chrono::system_clock::now();
+        return Clock::now();
     }
 
-    auto GetTimeStamp() const {
-        const auto now = GetTime();
-        const auto t_c = std::chrono::system_clock::to_time_t(now);
-        return std::put_time(std::localtime(&t_c), "%F %T");
+    static std::tm ToLocalTime(Clock::time_point time) {
+        const auto t_c = Clock::to_time_t(time);
+        std::tm tm{};
+        localtime_r(&t_c, &tm);
+        return tm;
+    }
+
+    static std::string FormatTime(Clock::time_point time, const char* format) {
+        const std::tm tm = ToLocalTime(time);
+        char buffer[32];
+        const size_t size = std::strftime(buffer, sizeof(buffer), format, &tm);
+        return {buffer, size};
+    }
+
+    auto GetTimeStamp(Clock::time_point time) const {
+        return FormatTime(time, "%F %T");
     }
 
     // Для имени файла возьмите дату с форматом "%Y_%m_%d"
-    std::string GetFileTimeStamp() const;
+    std::string GetFileTimeStamp() const {
+        return GetFileTimeStamp(GetTime());
+    }
+
+    static std::string GetFileTimeStamp(Clock::time_point time) {
+        return FormatTime(time, "%Y_%m_%d");
+    }
 
     Logger() = default;
     Logger(const Logger&) = delete;
 
+    ~Logger() {
+        StopAsync();
+    }
+
 public:
     static Logger& GetInstance() {
         static Logger obj;
@@ -43,13 +111,373 @@ public:
 
     // Выведите в поток все аргументы.
     template<class... Ts>
-    void Log(const Ts&... args);
+    void Log(const Ts&... args) {
+        if (async_.load(std::memory_order_acquire) && LogAsync(args...)) {
+            return;
+        }
+
+        const auto now = GetTime();
+        std::lock_guard lock{file_mutex_};
+        OpenFileFor(now);
+        log_file_ << GetTimeStamp(now) << ": "sv;
+        ((log_file_ << args), ...);
+        log_file_ << std::endl;
+    }
 
     // Установите manual_ts_. Учтите, что эта операция может выполняться
-    // параллельно с выводом в поток, вам нужно предусмотреть 
+    // параллельно с выводом в поток, вам нужно предусмотреть
     // синхронизацию.
-    void SetTimestamp(std::chrono::system_clock::time_point ts);
+    void SetTimestamp(std::chrono::system_clock::time_point ts) {
+        manual_ts_.store(ts.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    /*
+     * Включает асинхронный режим. Log сериализует аргументы в кольцевой буфер
+     * вызывающего потока и сразу возвращает управление, а форматирование времени,
+     * выбор файла по дате и запись в файл выполняет отдельный поток.
+     * Сообщения одного потока записываются в порядке вызова Log, сообщения разных
+     * потоков могут чередоваться.
+     * Режим нужно включать до того, как Log начнут вызывать из нескольких потоков.
+     */
+    void EnableAsync(AsyncLogOptions options = {}) {
+        std::lock_guard lock{rings_mutex_};
+        if (async_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        async_options_ = options;
+        writer_ = std::jthread([this](std::stop_token stop_token) {
+            WriterLoop(stop_token);
+        });
+        async_.store(true, std::memory_order_release);
+    }
+
+    // Дожидается записи в файл всех сообщений, переданных в Log до вызова Flush
+    void Flush() {
+        if (!async_.load(std::memory_order_acquire)) {
+            std::lock_guard lock{file_mutex_};
+            log_file_.flush();
+            return;
+        }
+        const auto pushed = pushed_.load(std::memory_order_acquire);
+        while (written_.load(std::memory_order_acquire) < pushed) {
+            std::this_thread::sleep_for(async_options_.idle_sleep);
+        }
+    }
+
+    // Возвращает логгер в синхронный режим, записывает оставшиеся сообщения и останавливает
+    // поток записи. Можно вызывать одновременно с Log: вызовы, начатые после переключения
+    // режима, пишут в файл синхронно, а поток записи останавливается только после того,
+    // как начатые раньше вызовы поместят свои сообщения в буферы
+    void StopAsync() {
+        if (!async_.exchange(false, std::memory_order_seq_cst)) {
+            return;
+        }
+        std::vector<std::shared_ptr<Producer>> producers;
+        {
+            std::lock_guard lock{rings_mutex_};
+            producers = producers_;
+        }
+        // Поток записи продолжает освобождать буферы, поэтому ожидающие места
+        // в режиме BLOCK вызовы Log завершатся
+        for (const auto& producer : producers) {
+            while (producer->active.load(std::memory_order_seq_cst)) {
+                std::this_thread::yield();
+            }
+        }
+        writer_.request_stop();
+        writer_.join();
+    }
+
+    LogStats GetStats() const {
+        return {written_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed),
+                blocked_.load(std::memory_order_relaxed)};
+    }
 
 private:
-    std::optional<std::chrono::system_clock::time_point> manual_ts_;
+    // Тип сериализованного аргумента
+    enum class ArgType : char {
+        INT,
+        UINT,
+        DOUBLE,
+        BOOL,
+        CHAR,
+        STRING,
+    };
+
+    template <typename T>
+    static void AppendRaw(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    static T ReadRaw(std::string_view& in) {
+        T value;
+        std::memcpy(&value, in.data(), sizeof(value));
+        in.remove_prefix(sizeof(value));
+        return value;
+    }
+
+    static void AppendString(std::string& out, std::string_view str) {
+        out.push_back(static_cast<char>(ArgType::STRING));
+        AppendRaw(out, static_cast<std::uint32_t>(str.size()));
+        out.append(str);
+    }
+
+    // Сериализует аргумент. Числа и строки копируются как есть, остальные типы
+    // форматируются оператором << в вызывающем потоке
+    template <typename T>
+    static void AppendArg(std::string& out, const T& arg) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out.push_back(static_cast<char>(ArgType::BOOL));
+            out.push_back(arg ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char>
+                             || std::is_same_v<T, unsigned char>) {
+            out.push_back(static_cast<char>(ArgType::CHAR));
+            out.push_back(static_cast<char>(arg));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            out.push_back(static_cast<char>(ArgType::INT));
+            AppendRaw(out, static_cast<std::int64_t>(arg));
+        } else if constexpr (std::is_integral_v<T>) {
+            out.push_back(static_cast<char>(ArgType::UINT));
+            AppendRaw(out, static_cast<std::uint64_t>(arg));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            out.push_back(static_cast<char>(ArgType::DOUBLE));
+            AppendRaw(out, static_cast<double>(arg));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            AppendString(out, std::string_view{arg});
+        } else {
+            thread_local std::ostringstream strm;
+            strm.str({});
+            strm << arg;
+            AppendString(out, strm.view());
+        }
+    }
+
+    // Кольцевой буфер потока, вызывающего Log
+    struct Producer {
+        explicit Producer(size_t ring_size)
+            : ring{ring_size} {
+        }
+
+        LogRing ring;
+        // Поток помещает сообщение в буфер. StopAsync ждёт, пока флаг не будет сброшен
+        std::atomic<bool> active{false};
+    };
+
+    // Помещает сообщение в буфер потока. Возвращает false, если асинхронный режим
+    // выключен, и сообщение нужно записать синхронно
+    template <class... Ts>
+    bool LogAsync(const Ts&... args) {
+        Producer* producer = GetThreadProducer();
+
+        // Флаг устанавливается до повторной проверки режима. Поэтому StopAsync, выключив
+        // режим, либо увидит флаг и дождётся вызова, либо вызов увидит выключенный режим
+        producer->active.store(true, std::memory_order_seq_cst);
+        if (!async_.load(std::memory_order_seq_cst)) {
+            producer->active.store(false, std::memory_order_release);
+            return false;
+        }
+        PushRecord(producer->ring, args...);
+        producer->active.store(false, std::memory_order_release);
+        return true;
+    }
+
+    template <class... Ts>
+    void PushRecord(LogRing& ring, const Ts&... args) {
+        // Буфер сериализации создаётся один раз для каждого потока
+        thread_local std::string record;
+        record.clear();
+        AppendRaw(record, GetTime().time_since_epoch().count());
+        (AppendArg(record, args), ...);
+
+        if (ring.TryPush(record)) {
+            pushed_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        if (async_options_.overflow_policy == AsyncLogOptions::OverflowPolicy::DROP
+            || record.size() > ring.MaxRecordSize()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        blocked_.fetch_add(1, std::memory_order_relaxed);
+        while (!ring.TryPush(record)) {
+            std::this_thread::yield();
+        }
+        pushed_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Возвращает буфер вызывающего потока. Функция не шаблонная, поэтому буфер
+    // один на поток независимо от типов аргументов Log
+    Producer* GetThreadProducer() {
+        thread_local std::shared_ptr<Producer> producer = RegisterProducer();
+        return producer.get();
+    }
+
+    std::shared_ptr<Producer> RegisterProducer() {
+        auto producer = std::make_shared<Producer>(async_options_.ring_size);
+        std::lock_guard lock{rings_mutex_};
+        producers_.push_back(producer);
+        return producer;
+    }
+
+    // Открывает файл, соответствующий дате time, если открыт файл за другую дату.
+    // Вызывается под file_mutex_
+    void OpenFileFor(Clock::time_point time) {
+        std::string file_date = GetFileTimeStamp(time);
+        if (log_file_.is_open() && file_date == file_date_) {
+            return;
+        }
+        log_file_.close();
+        log_file_.open("/var/log/sample_log_"s + file_date + ".log"s, std::ios::app);
+        file_date_ = std::move(file_date);
+    }
+
+    // Поток записи: забирает записи из буферов потоков, форматирует их и записывает
+    // в файл блоками
+    void WriterLoop(std::stop_token stop_token) {
+        std::string batch;
+        batch.reserve(async_options_.write_batch_size * 2);
+        while (true) {
+            // Условие остановки проверяется до прохода по буферам, чтобы сообщения,
+            // записанные перед остановкой, не потерялись
+            const bool stop = stop_token.stop_requested();
+            const size_t count = DrainRings(batch);
+            if (count == 0) {
+                if (stop) {
+                    break;
+                }
+                std::this_thread::sleep_for(async_options_.idle_sleep);
+            }
+        }
+        std::lock_guard lock{file_mutex_};
+        log_file_.flush();
+    }
+
+    size_t DrainRings(std::string& batch) {
+        {
+            // Список копируется под блокировкой, чтобы RegisterProducer в новом потоке
+            // не ждал записи в файл. Буферы завершившихся потоков удаляются, когда
+            // из них прочитаны все сообщения
+            std::lock_guard lock{rings_mutex_};
+            std::erase_if(producers_, [](const std::shared_ptr<Producer>& producer) {
+                return producer.use_count() == 1 && producer->ring.Empty();
+            });
+            drained_producers_ = producers_;
+        }
+        size_t count = 0;
+        for (const auto& producer : drained_producers_) {
+            count += producer->ring.ConsumeAll([this, &batch](std::string_view record) {
+                FormatRecord(record, batch);
+                if (batch.size() >= async_options_.write_batch_size) {
+                    WriteBatch(batch);
+                }
+            });
+        }
+        drained_producers_.clear();
+        WriteBatch(batch);
+        if (count > 0) {
+            std::lock_guard lock{file_mutex_};
+            log_file_.flush();
+            written_.fetch_add(count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Записывает накопленные сообщения в файл за дату batch_time_. Файл выбирается
+    // под file_mutex_, так как в StopAsync синхронные вызовы Log могут открыть другой
+    void WriteBatch(std::string& batch) {
+        if (batch.empty()) {
+            return;
+        }
+        std::lock_guard lock{file_mutex_};
+        OpenFileFor(batch_time_);
+        log_file_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        batch.clear();
+    }
+
+    void FormatRecord(std::string_view record, std::string& batch) {
+        const Clock::time_point time{Clock::duration{ReadRaw<Clock::rep>(record)}};
+
+        // Время форматируется заново, только когда меняется секунда
+        const auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+        if (seconds != formatted_second_ || time_stamp_.empty()) {
+            std::string file_date = GetFileTimeStamp(time);
+            if (file_date != batch_date_) {
+                // Сообщения за прежнюю дату записываются в прежний файл
+                WriteBatch(batch);
+                batch_date_ = std::move(file_date);
+                batch_time_ = time;
+            }
+            time_stamp_ = GetTimeStamp(time);
+            formatted_second_ = seconds;
+        }
+
+        batch.append(time_stamp_).append(": "sv);
+        while (!record.empty()) {
+            const auto type = static_cast<ArgType>(record.front());
+            record.remove_prefix(1);
+            switch (type) {
+                case ArgType::INT:
+                    AppendNumber(batch, ReadRaw<std::int64_t>(record));
+                    break;
+                case ArgType::UINT:
+                    AppendNumber(batch, ReadRaw<std::uint64_t>(record));
+                    break;
+                case ArgType::DOUBLE:
+                    // Вещественные числа форматируются так же, как в синхронном режиме
+                    double_strm_.str({});
+                    double_strm_ << ReadRaw<double>(record);
+                    batch.append(double_strm_.view());
+                    break;
+                case ArgType::BOOL:
+                    batch.push_back(record.front() ? '1' : '0');
+                    record.remove_prefix(1);
+                    break;
+                case ArgType::CHAR:
+                    batch.push_back(record.front());
+                    record.remove_prefix(1);
+                    break;
+                case ArgType::STRING: {
+                    const auto size = ReadRaw<std::uint32_t>(record);
+                    batch.append(record.substr(0, size));
+                    record.remove_prefix(size);
+                    break;
+                }
+            }
+        }
+        batch.push_back('\n');
+    }
+
+    template <typename T>
+    static void AppendNumber(std::string& out, T value) {
+        char buffer[24];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    std::atomic<Clock::rep> manual_ts_{NO_MANUAL_TS};
+
+    // Файл и его дата используются только под file_mutex_
+    std::mutex file_mutex_;
+    std::ofstream log_file_;
+    std::string file_date_;
+
+    std::atomic<bool> async_{false};
+    AsyncLogOptions async_options_;
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Producer>> producers_;
+    std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> blocked_{0};
+
+    // Состояние потока записи
+    std::vector<std::shared_ptr<Producer>> drained_producers_;
+    // Дата сообщений, накопленных в блоке, и время одного из них
+    std::string batch_date_;
+    Clock::time_point batch_time_;
+    std::chrono::sys_seconds formatted_second_;
+    std::string time_stamp_;
+    std::ostringstream double_strm_;
+    std::jthread writer_;
 };
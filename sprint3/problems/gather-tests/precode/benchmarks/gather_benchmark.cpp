@@ -0,0 +1,138 @@
+// Сравнивает FindGatherEventsBroadPhase с перебором всех пар предмет-собиратель
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/collision_detector.h"
+
+using namespace std::literals;
+using namespace collision_detector;
+
+namespace {
+
+class VectorItemGathererProvider : public ItemGathererProvider {
+public:
+    VectorItemGathererProvider(std::vector<Item> items, std::vector<Gatherer> gatherers)
+        : items_(std::move(items))
+        , gatherers_(std::move(gatherers)) {
+    }
+
+    size_t ItemsCount() const override {
+        return items_.size();
+    }
+
+    Item GetItem(size_t idx) const override {
+        return items_[idx];
+    }
+
+    size_t GatherersCount() const override {
+        return gatherers_.size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const override {
+        return gatherers_[idx];
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Gatherer> gatherers_;
+};
+
+// Предметы и собаки размещаются на карте size x size. За тик собака проходит не больше
+// 0.5 вдоль одной из осей, ширина собаки 0.6, ширина предмета 0
+VectorItemGathererProvider MakeProvider(size_t items_count, size_t gatherers_count,
+                                        double size, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord{0.0, size};
+    std::uniform_real_distribution<double> step{-0.5, 0.5};
+    std::bernoulli_distribution horizontal;
+
+    std::vector<Item> items(items_count);
+    for (auto& item : items) {
+        item = {{coord(rng), coord(rng)}, 0.0};
+    }
+    std::vector<Gatherer> gatherers(gatherers_count);
+    for (auto& gatherer : gatherers) {
+        const geom::Point2D start{coord(rng), coord(rng)};
+        geom::Point2D end = start;
+        (horizontal(rng) ? end.x : end.y) += step(rng);
+        gatherer = {start, end, 0.6};
+    }
+    return {std::move(items), std::move(gatherers)};
+}
+
+// Проверяет, что события и их порядок в точности совпадают
+bool SameEvents(const std::vector<GatheringEvent>& lhs, const std::vector<GatheringEvent>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                      [](const GatheringEvent& a, const GatheringEvent& b) {
+                          return a.item_id == b.item_id && a.gatherer_id == b.gatherer_id
+                                 && a.sq_distance == b.sq_distance && a.time == b.time;
+                      });
+}
+
+template <typename Fn>
+double MeasureMicroseconds(int repeat, Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        fn();
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeat;
+}
+
+// Сравнивает пакетную проверку точек с поточечной
+void RunKernelBenchmark(std::mt19937& rng) {
+    constexpr size_t POINTS_COUNT = 4'096;
+    constexpr int REPEAT = 2'000;
+    std::uniform_real_distribution<double> coord{0.0, 100.0};
+    std::vector<double> xs(POINTS_COUNT);
+    std::vector<double> ys(POINTS_COUNT);
+    for (size_t i = 0; i < POINTS_COUNT; ++i) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+    }
+    std::vector<CollectionResult> results(POINTS_COUNT);
+    const geom::Point2D a{10.0, 20.0};
+    const geom::Point2D b{10.5, 20.0};
+
+    const double scalar_us = MeasureMicroseconds(REPEAT, [&] {
+        TryCollectPointsScalar(a, b, xs, ys, results);
+    });
+    const double batch_us = MeasureMicroseconds(REPEAT, [&] {
+        TryCollectPoints(a, b, xs, ys, results);
+    });
+    std::cout << "TryCollectPoints ("sv << (IsAvx2Supported() ? "AVX2"sv : "scalar"sv)
+              << "): "sv << batch_us * 1'000 / POINTS_COUNT << " ns/point, scalar: "sv
+              << scalar_us * 1'000 / POINTS_COUNT << " ns/point"sv << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng{42};
+    RunKernelBenchmark(rng);
+    for (size_t items_count : {100, 1'000, 10'000}) {
+        for (size_t gatherers_count : {10, 100, 1'000}) {
+            const auto provider = MakeProvider(items_count, gatherers_count, 1'000.0, rng);
+            if (!SameEvents(FindGatherEventsBroadPhase(provider),
+                            FindGatherEventsBruteForce(provider))) {
+                std::cerr << "Results differ for "sv << items_count << " items and "sv
+                          << gatherers_count << " gatherers"sv << std::endl;
+                return EXIT_FAILURE;
+            }
+            const int repeat = items_count * gatherers_count > 1'000'000 ? 5 : 50;
+            const double brute_force_us = MeasureMicroseconds(repeat, [&provider] {
+                return FindGatherEventsBruteForce(provider);
+            });
+            const double broad_phase_us = MeasureMicroseconds(repeat, [&provider] {
+                return FindGatherEventsBroadPhase(provider);
+            });
+            std::cout << "items: "sv << items_count << ", gatherers: "sv << gatherers_count
+                      << ", brute force: "sv << brute_force_us << " us, broad phase: "sv
+                      << broad_phase_us << " us"sv << std::endl;
+        }
+    }
+}
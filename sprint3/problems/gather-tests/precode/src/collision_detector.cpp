@@ -1,32 +1,233 @@
-#include "collision_detector.h"
-#include <cassert>
-
-namespace collision_detector {
-
-CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
-    // Проверим, что перемещение ненулевое.
-    // Тут приходится использовать строгое равенство, а не приближённое,
-    // пскольку при сборе заказов придётся учитывать перемещение даже на небольшое
-    // расстояние.
-    assert(b.x != a.x || b.y != a.y);
-    const double u_x = c.x - a.x;
-    const double u_y = c.y - a.y;
-    const double v_x = b.x - a.x;
-    const double v_y = b.y - a.y;
-    const double u_dot_v = u_x * v_x + u_y * v_y;
-    const double u_len2 = u_x * u_x + u_y * u_y;
-    const double v_len2 = v_x * v_x + v_y * v_y;
-    const double proj_ratio = u_dot_v / v_len2;
-    const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / v_len2;
-
-    return CollectionResult(sq_distance, proj_ratio);
-}
-
-// В задании на разработку тестов реализовывать следующую функцию не нужно -
-// она будет линковаться извне.
-/*
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-}
-*/
-
+#include "collision_detector.h"
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define COLLISION_DETECTOR_HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace collision_detector {
+
+CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
+    // Проверим, что перемещение ненулевое.
+    // Тут приходится использовать строгое равенство, а не приближённое,
+    // пскольку при сборе заказов придётся учитывать перемещение даже на небольшое
+    // расстояние.
+    assert(b.x != a.x || b.y != a.y);
+    const double u_x = c.x - a.x;
+    const double u_y = c.y - a.y;
+    const double v_x = b.x - a.x;
+    const double v_y = b.y - a.y;
+    const double u_dot_v = u_x * v_x + u_y * v_y;
+    const double u_len2 = u_x * u_x + u_y * u_y;
+    const double v_len2 = v_x * v_x + v_y * v_y;
+    const double proj_ratio = u_dot_v / v_len2;
+    const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / v_len2;
+
+    return CollectionResult(sq_distance, proj_ratio);
+}
+
+void TryCollectPointsScalar(geom::Point2D a, geom::Point2D b, std::span<const double> xs,
+                            std::span<const double> ys, std::span<CollectionResult> results) {
+    assert(xs.size() == ys.size() && xs.size() == results.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        results[i] = TryCollectPoint(a, b, {xs[i], ys[i]});
+    }
+}
+
+namespace {
+
+#ifdef COLLISION_DETECTOR_HAS_AVX2_KERNEL
+
+// Результаты записываются в массив CollectionResult как в массив double
+static_assert(sizeof(CollectionResult) == 2 * sizeof(double));
+
+// Выполняет те же операции, что и TryCollectPoint, в том же порядке, поэтому результаты
+// совпадают до бита. Для этого компилятору запрещено объединять умножение и сложение
+// в FMA (см. -ffp-contract=off в CMakeLists.txt)
+__attribute__((target("avx2"))) void TryCollectPointsAvx2(geom::Point2D a, geom::Point2D b,
+                                                          std::span<const double> xs,
+                                                          std::span<const double> ys,
+                                                          std::span<CollectionResult> results) {
+    assert(b.x != a.x || b.y != a.y);
+    const double v_x = b.x - a.x;
+    const double v_y = b.y - a.y;
+    const double v_len2 = v_x * v_x + v_y * v_y;
+
+    const __m256d a_x4 = _mm256_set1_pd(a.x);
+    const __m256d a_y4 = _mm256_set1_pd(a.y);
+    const __m256d v_x4 = _mm256_set1_pd(v_x);
+    const __m256d v_y4 = _mm256_set1_pd(v_y);
+    const __m256d v_len2_4 = _mm256_set1_pd(v_len2);
+
+    const size_t size = xs.size();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(xs.data() + i), a_x4);
+        const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(ys.data() + i), a_y4);
+        const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, v_x4), _mm256_mul_pd(u_y, v_y4));
+        const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+        const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2_4);
+        const __m256d sq_distance =
+            _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2_4));
+
+        // CollectionResult хранит пары {sq_distance, proj_ratio}: чередуем элементы векторов
+        const __m256d lo = _mm256_unpacklo_pd(sq_distance, proj_ratio);
+        const __m256d hi = _mm256_unpackhi_pd(sq_distance, proj_ratio);
+        double* out = &results[i].sq_distance;
+        _mm256_storeu_pd(out, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+    for (; i < size; ++i) {
+        results[i] = TryCollectPoint(a, b, {xs[i], ys[i]});
+    }
+}
+
+#endif
+
+using TryCollectPointsFn = void (*)(geom::Point2D, geom::Point2D, std::span<const double>,
+                                    std::span<const double>, std::span<CollectionResult>);
+
+TryCollectPointsFn ChooseTryCollectPoints() {
+#ifdef COLLISION_DETECTOR_HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) {
+        return TryCollectPointsAvx2;
+    }
+#endif
+    return TryCollectPointsScalar;
+}
+
+// Запас, на который дополнительно расширяется прямоугольник вокруг пути собирателя.
+// Покрывает погрешность вычисления sq_distance, чтобы отсечение по прямоугольнику
+// не отбрасывало пары, которые TryCollectPoint посчитала бы собранными
+constexpr double BOUNDS_EPSILON = 1e-6;
+
+bool IsMoving(const Gatherer& gatherer) {
+    return gatherer.start_pos.x != gatherer.end_pos.x || gatherer.start_pos.y != gatherer.end_pos.y;
+}
+
+// Проверяет пару предмет-собиратель и добавляет событие, если предмет собран
+void TryAddEvent(const Gatherer& gatherer, size_t gatherer_id, const Item& item, size_t item_id,
+                 std::vector<GatheringEvent>& events) {
+    const auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+    if (result.IsCollected(gatherer.width + item.width)) {
+        events.push_back({item_id, gatherer_id, result.sq_distance, result.proj_ratio});
+    }
+}
+
+void SortEvents(std::vector<GatheringEvent>& events) {
+    std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
+        if (lhs.time != rhs.time) {
+            return lhs.time < rhs.time;
+        }
+        if (lhs.gatherer_id != rhs.gatherer_id) {
+            return lhs.gatherer_id < rhs.gatherer_id;
+        }
+        return lhs.item_id < rhs.item_id;
+    });
+}
+
+}  // namespace
+
+bool IsAvx2Supported() {
+#ifdef COLLISION_DETECTOR_HAS_AVX2_KERNEL
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void TryCollectPoints(geom::Point2D a, geom::Point2D b, std::span<const double> xs,
+                      std::span<const double> ys, std::span<CollectionResult> results) {
+    assert(xs.size() == ys.size() && xs.size() == results.size());
+    // Реализация выбирается один раз, при первом вызове
+    static const TryCollectPointsFn try_collect_points = ChooseTryCollectPoints();
+    try_collect_points(a, b, xs, ys, results);
+}
+
+std::vector<GatheringEvent> FindGatherEventsBroadPhase(const ItemGathererProvider& provider) {
+    const size_t items_count = provider.ItemsCount();
+    const size_t gatherers_count = provider.GatherersCount();
+    std::vector<GatheringEvent> events;
+    if (items_count == 0 || gatherers_count == 0) {
+        return events;
+    }
+
+    std::vector<Item> items;
+    items.reserve(items_count);
+    double max_item_width = 0.0;
+    for (size_t i = 0; i < items_count; ++i) {
+        const Item& item = items.emplace_back(provider.GetItem(i));
+        max_item_width = std::max(max_item_width, item.width);
+    }
+
+    // Номера предметов, упорядоченные по координате x
+    std::vector<size_t> order(items_count);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::sort(order.begin(), order.end(), [&items](size_t lhs, size_t rhs) {
+        return items[lhs].position.x < items[rhs].position.x;
+    });
+    // Координаты и ширины предметов в порядке order, чтобы предметы, попавшие в полосу
+    // вокруг пути собирателя, лежали в памяти подряд и проверялись пакетом
+    std::vector<double> sorted_x(items_count);
+    std::vector<double> sorted_y(items_count);
+    std::vector<double> sorted_width(items_count);
+    for (size_t i = 0; i < items_count; ++i) {
+        const Item& item = items[order[i]];
+        sorted_x[i] = item.position.x;
+        sorted_y[i] = item.position.y;
+        sorted_width[i] = item.width;
+    }
+
+    std::vector<CollectionResult> results;
+    for (size_t g = 0; g < gatherers_count; ++g) {
+        const Gatherer gatherer = provider.GetGatherer(g);
+        if (!IsMoving(gatherer)) {
+            continue;
+        }
+        const double reach = gatherer.width + max_item_width + BOUNDS_EPSILON;
+        const auto [min_x, max_x] = std::minmax(gatherer.start_pos.x, gatherer.end_pos.x);
+
+        const auto first = std::lower_bound(sorted_x.begin(), sorted_x.end(), min_x - reach);
+        const auto last = std::upper_bound(first, sorted_x.end(), max_x + reach);
+        const size_t offset = first - sorted_x.begin();
+        const size_t count = last - first;
+        if (count == 0) {
+            continue;
+        }
+
+        results.resize(count);
+        TryCollectPoints(gatherer.start_pos, gatherer.end_pos,
+                         std::span{sorted_x}.subspan(offset, count),
+                         std::span{sorted_y}.subspan(offset, count), results);
+        for (size_t i = 0; i < count; ++i) {
+            if (results[i].IsCollected(gatherer.width + sorted_width[offset + i])) {
+                events.push_back(
+                    {order[offset + i], g, results[i].sq_distance, results[i].proj_ratio});
+            }
+        }
+    }
+
+    SortEvents(events);
+    return events;
+}
+
+std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider& provider) {
+    std::vector<GatheringEvent> events;
+    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+        const Gatherer gatherer = provider.GetGatherer(g);
+        if (!IsMoving(gatherer)) {
+            continue;
+        }
+        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+            TryAddEvent(gatherer, g, provider.GetItem(i), i, events);
+        }
+    }
+
+    SortEvents(events);
+    return events;
+}
+
 }  // namespace collision_detector
\ No newline at end of file
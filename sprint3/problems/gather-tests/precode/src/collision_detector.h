@@ -1,59 +1,88 @@
-#pragma once
-
-#include "geom.h"
-
-#include <algorithm>
-#include <vector>
-
-namespace collision_detector {
-
-struct CollectionResult {
-    bool IsCollected(double collect_radius) const {
-        return proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= collect_radius * collect_radius;
-    }
-
-    // квадрат расстояния до точки
-    double sq_distance;
-
-    // доля пройденного отрезка
-    double proj_ratio;
-};
-
-// Движемся из точки a в точку b и пытаемся подобрать точку c.
-// Эта функция реализована в уроке.
-CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c);
-
-struct Item {
-    geom::Point2D position;
-    double width;
-};
-
-struct Gatherer {
-    geom::Point2D start_pos;
-    geom::Point2D end_pos;
-    double width;
-};
-
-class ItemGathererProvider {
-protected:
-    ~ItemGathererProvider() = default;
-
-public:
-    virtual size_t ItemsCount() const = 0;
-    virtual Item GetItem(size_t idx) const = 0;
-    virtual size_t GatherersCount() const = 0;
-    virtual Gatherer GetGatherer(size_t idx) const = 0;
-};
-
-struct GatheringEvent {
-    size_t item_id;
-    size_t gatherer_id;
-    double sq_distance;
-    double time;
-};
-
-// Эту функцию вам нужно будет реализовать в соответствующем задании.
-// При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
-
+#pragma once
+
+#include "geom.h"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace collision_detector {
+
+struct CollectionResult {
+    bool IsCollected(double collect_radius) const {
+        return proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= collect_radius * collect_radius;
+    }
+
+    // квадрат расстояния до точки
+    double sq_distance;
+
+    // доля пройденного отрезка
+    double proj_ratio;
+};
+
+// Движемся из точки a в точку b и пытаемся подобрать точку c.
+// Эта функция реализована в уроке.
+CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c);
+
+// Пакетный вариант TryCollectPoint: движемся из точки a в точку b и пытаемся подобрать
+// точки {xs[i], ys[i]}. Результат для i-й точки записывается в results[i].
+// Размеры xs, ys и results должны совпадать.
+// Если процессор поддерживает AVX2, точки обрабатываются по 4 за раз, иначе используется
+// TryCollectPointsScalar. Результаты обоих вариантов в точности совпадают с TryCollectPoint
+void TryCollectPoints(geom::Point2D a, geom::Point2D b, std::span<const double> xs,
+                      std::span<const double> ys, std::span<CollectionResult> results);
+
+// Вариант TryCollectPoints без векторных инструкций
+void TryCollectPointsScalar(geom::Point2D a, geom::Point2D b, std::span<const double> xs,
+                            std::span<const double> ys, std::span<CollectionResult> results);
+
+// Проверяет, будет ли TryCollectPoints использовать AVX2 на этом процессоре
+bool IsAvx2Supported();
+
+struct Item {
+    geom::Point2D position;
+    double width;
+};
+
+struct Gatherer {
+    geom::Point2D start_pos;
+    geom::Point2D end_pos;
+    double width;
+};
+
+class ItemGathererProvider {
+protected:
+    ~ItemGathererProvider() = default;
+
+public:
+    virtual size_t ItemsCount() const = 0;
+    virtual Item GetItem(size_t idx) const = 0;
+    virtual size_t GatherersCount() const = 0;
+    virtual Gatherer GetGatherer(size_t idx) const = 0;
+};
+
+struct GatheringEvent {
+    size_t item_id;
+    size_t gatherer_id;
+    double sq_distance;
+    double time;
+};
+
+// Эту функцию вам нужно будет реализовать в соответствующем задании.
+// При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
+// Локально тесты линкуются с reference_find_gather_events.cpp, где она вызывает
+// FindGatherEventsBruteForce
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
+
+// Находит все события сбора предметов собирателями, проверяя все пары предмет-собиратель.
+// События упорядочены по времени, события с одинаковым временем - по номеру собирателя,
+// а затем по номеру предмета. Собиратели, не сдвинувшиеся с места, предметов не собирают
+std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider& provider);
+
+// Находит те же события, что и FindGatherEventsBruteForce, в том же порядке.
+// Чтобы не проверять каждую пару предмет-собиратель, предметы сортируются по x, и для
+// каждого собирателя с помощью TryCollectPoints проверяются только предметы, попадающие
+// в полосу вокруг его пути, расширенную на сумму ширин собирателя и самого широкого предмета.
+std::vector<GatheringEvent> FindGatherEventsBroadPhase(const ItemGathererProvider& provider);
+
 }  // namespace collision_detector
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "collision_detector.h"
+
+namespace collision_detector {
+
+// При проверке тестов FindGatherEvents линкуется снаружи. Этот файл собирается
+// в отдельную статическую библиотеку: компоновщик берёт из неё объектный файл, только
+// если FindGatherEvents больше нигде не определена, поэтому внешняя реализация
+// не конфликтует с этой
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    return FindGatherEventsBruteForce(provider);
+}
+
+}  // namespace collision_detector
@@ -1,5 +1,201 @@
-#define _USE_MATH_DEFINES
-
-#include "../src/collision_detector.h"
-
-// Напишите здесь тесты для функции collision_detector::FindGatherEvents
\ No newline at end of file
+#define _USE_MATH_DEFINES
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include "../src/collision_detector.h"
+
+using namespace collision_detector;
+using Catch::Matchers::WithinAbs;
+
+namespace {
+
+class VectorItemGathererProvider : public ItemGathererProvider {
+public:
+    VectorItemGathererProvider(std::vector<Item> items, std::vector<Gatherer> gatherers)
+        : items_(std::move(items))
+        , gatherers_(std::move(gatherers)) {
+    }
+
+    size_t ItemsCount() const override {
+        return items_.size();
+    }
+
+    Item GetItem(size_t idx) const override {
+        return items_[idx];
+    }
+
+    size_t GatherersCount() const override {
+        return gatherers_.size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const override {
+        return gatherers_[idx];
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Gatherer> gatherers_;
+};
+
+// Сравнивает события точно. Оператор == для GatheringEvent не определяется, чтобы
+// не конфликтовать с определениями, которые линкуются вместе с FindGatherEvents
+bool SameEvent(const GatheringEvent& lhs, const GatheringEvent& rhs) {
+    return lhs.item_id == rhs.item_id && lhs.gatherer_id == rhs.gatherer_id
+           && lhs.sq_distance == rhs.sq_distance && lhs.time == rhs.time;
+}
+
+}  // namespace
+
+namespace collision_detector {
+
+std::ostream& operator<<(std::ostream& out, const GatheringEvent& event) {
+    return out << "{item: " << event.item_id << ", gatherer: " << event.gatherer_id
+               << ", sq_distance: " << event.sq_distance << ", time: " << event.time << '}';
+}
+
+}  // namespace collision_detector
+
+SCENARIO("Gather events") {
+    GIVEN("a gatherer moving along the x axis") {
+        const std::vector<Gatherer> gatherers{{{0, 0}, {10, 0}, 0.6}};
+
+        WHEN("items lie near the path, behind it and too far from it") {
+            const VectorItemGathererProvider provider{{{{5, 0.5}, 0.0},
+                                                       {{-1, 0}, 0.0},
+                                                       {{2, 0}, 0.0},
+                                                       {{7, 1.0}, 0.5},
+                                                       {{3, 2.0}, 0.5}},
+                                                      gatherers};
+            const auto events = FindGatherEvents(provider);
+
+            THEN("only items within reach are gathered in order of time") {
+                REQUIRE(events.size() == 3);
+                CHECK(events[0].item_id == 2);
+                CHECK_THAT(events[0].time, WithinAbs(0.2, 1e-10));
+                CHECK_THAT(events[0].sq_distance, WithinAbs(0.0, 1e-10));
+                CHECK(events[1].item_id == 0);
+                CHECK_THAT(events[1].time, WithinAbs(0.5, 1e-10));
+                CHECK_THAT(events[1].sq_distance, WithinAbs(0.25, 1e-10));
+                CHECK(events[2].item_id == 3);
+                CHECK_THAT(events[2].time, WithinAbs(0.7, 1e-10));
+                for (const auto& event : events) {
+                    CHECK(event.gatherer_id == 0);
+                }
+            }
+        }
+    }
+
+    GIVEN("a gatherer that does not move") {
+        const VectorItemGathererProvider provider{{{{1, 1}, 1.0}}, {{{1, 1}, {1, 1}, 1.0}}};
+
+        THEN("it gathers nothing") {
+            CHECK(FindGatherEvents(provider).empty());
+        }
+    }
+
+    GIVEN("two gatherers reaching the same item at the same time") {
+        const VectorItemGathererProvider provider{
+            {{{5, 0}, 0.0}}, {{{0, 0.1}, {10, 0.1}, 0.5}, {{0, -0.1}, {10, -0.1}, 0.5}}};
+
+        THEN("events are ordered by gatherer id") {
+            const auto events = FindGatherEvents(provider);
+            REQUIRE(events.size() == 2);
+            CHECK(events[0].gatherer_id == 0);
+            CHECK(events[1].gatherer_id == 1);
+        }
+    }
+}
+
+SCENARIO("Broad phase finds the same events as brute force") {
+    std::mt19937 rng{GENERATE(1u, 2u, 3u, 4u, 5u)};
+    std::uniform_real_distribution<double> coord{0.0, 50.0};
+    std::uniform_real_distribution<double> step{-3.0, 3.0};
+    std::uniform_real_distribution<double> width{0.0, 1.0};
+    std::uniform_int_distribution<int> axis{0, 2};
+
+    std::vector<Item> items(500);
+    for (auto& item : items) {
+        item = {{coord(rng), coord(rng)}, width(rng)};
+    }
+    std::vector<Gatherer> gatherers(200);
+    for (auto& gatherer : gatherers) {
+        const geom::Point2D start{coord(rng), coord(rng)};
+        geom::Point2D end = start;
+        // Собаки движутся вдоль осей, но проверяем и произвольные направления
+        switch (axis(rng)) {
+            case 0:
+                end.x += step(rng);
+                break;
+            case 1:
+                end.y += step(rng);
+                break;
+            default:
+                end.x += step(rng);
+                end.y += step(rng);
+                break;
+        }
+        gatherer = {start, end, width(rng)};
+    }
+    // Несколько предметов лежат точно на концах путей собирателей
+    for (size_t i = 0; i < 20; ++i) {
+        items[i].position = gatherers[i].end_pos;
+    }
+
+    const VectorItemGathererProvider provider{items, gatherers};
+    const auto expected = FindGatherEventsBruteForce(provider);
+    const auto actual = FindGatherEventsBroadPhase(provider);
+    CHECK_FALSE(expected.empty());
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        INFO("actual: " << actual[i] << ", expected: " << expected[i]);
+        CHECK(SameEvent(actual[i], expected[i]));
+    }
+}
+
+SCENARIO("Batch point collection") {
+    GIVEN("a segment and points that do not fill whole vector registers") {
+        std::mt19937 rng{42};
+        std::uniform_real_distribution<double> coord{-10.0, 10.0};
+        const geom::Point2D a{coord(rng), coord(rng)};
+        const geom::Point2D b{coord(rng), coord(rng)};
+
+        std::vector<double> xs(37);
+        std::vector<double> ys(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            xs[i] = coord(rng);
+            ys[i] = coord(rng);
+        }
+        // Концы отрезка и его середина
+        xs[0] = a.x;
+        ys[0] = a.y;
+        xs[1] = b.x;
+        ys[1] = b.y;
+        xs[2] = (a.x + b.x) / 2;
+        ys[2] = (a.y + b.y) / 2;
+
+        WHEN("points are checked in a batch") {
+            std::vector<CollectionResult> batch(xs.size());
+            std::vector<CollectionResult> scalar(xs.size());
+            TryCollectPoints(a, b, xs, ys, batch);
+            TryCollectPointsScalar(a, b, xs, ys, scalar);
+
+            THEN("results are equal to TryCollectPoint results") {
+                for (size_t i = 0; i < xs.size(); ++i) {
+                    const auto expected = TryCollectPoint(a, b, {xs[i], ys[i]});
+                    CHECK(batch[i].sq_distance == expected.sq_distance);
+                    CHECK(batch[i].proj_ratio == expected.proj_ratio);
+                    CHECK(scalar[i].sq_distance == expected.sq_distance);
+                    CHECK(scalar[i].proj_ratio == expected.proj_ratio);
+                }
+                CHECK(batch[0].IsCollected(0.0));
+                CHECK(batch[1].IsCollected(0.0));
+                CHECK(batch[2].IsCollected(1e-6));
+            }
+        }
+    }
+}
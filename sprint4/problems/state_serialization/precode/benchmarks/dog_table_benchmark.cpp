@@ -0,0 +1,72 @@
+// Сравнивает перемещение собак, хранящихся в shared_ptr<Dog>, и собак в DogTable
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t NUM_DOGS = 10'000;
+constexpr int NUM_TICKS = 1'000;
+constexpr double TICK_SECONDS = 0.05;
+
+model::Dog MakeDog(uint32_t id, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord{0.0, 100.0};
+    std::uniform_real_distribution<double> speed{-3.0, 3.0};
+    model::Dog dog{model::Dog::Id{id}, "Dog #"s + std::to_string(id), {coord(rng), coord(rng)}, 3};
+    dog.SetSpeed({speed(rng), speed(rng)});
+    return dog;
+}
+
+template <typename Fn>
+double MeasureNsPerDog(Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_TICKS; ++i) {
+        fn();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / NUM_TICKS / NUM_DOGS;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng{42};
+    std::vector<model::DogPtr> dogs;
+    model::DogTable table;
+    for (uint32_t id = 0; id < NUM_DOGS; ++id) {
+        const auto dog = MakeDog(id, rng);
+        dogs.push_back(std::make_shared<model::Dog>(dog));
+        table.Add(dog);
+    }
+    // Перемешиваем указатели, как это происходит при добавлении и удалении собак в игре
+    std::shuffle(dogs.begin(), dogs.end(), rng);
+
+    const double objects_ns = MeasureNsPerDog([&dogs] {
+        for (const auto& dog : dogs) {
+            dog->SetPosition(dog->GetPosition() + dog->GetSpeed() * TICK_SECONDS);
+        }
+    });
+    const double table_ns = MeasureNsPerDog([&table] {
+        table.AdvancePositions(TICK_SECONDS);
+    });
+
+    // Результаты обоих способов должны совпадать
+    for (const auto& dog : dogs) {
+        const auto index = *table.FindIndex(dog->GetId());
+        if (dog->GetPosition() != table.GetPositions()[index]) {
+            std::cerr << "Positions differ for dog "sv << *dog->GetId() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "dogs: "sv << NUM_DOGS << "\n  shared_ptr<Dog>: "sv << objects_ns
+              << " ns/dog\n  DogTable: "sv << table_ns << " ns/dog"sv << std::endl;
+}
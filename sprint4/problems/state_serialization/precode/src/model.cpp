@@ -1,3 +1,103 @@
 #include "model.h"
 
-namespace model {}  // namespace model
+#include <stdexcept>
+
+namespace model {
+using namespace std::literals;
+
+namespace {
+
+// Уменьшение размера вектора не выделяет память и не выбрасывает исключений
+template <typename T>
+void TruncateColumn(std::vector<T>& column, size_t size) noexcept {
+    if (column.size() > size) {
+        column.erase(column.begin() + size, column.end());
+    }
+}
+
+}  // namespace
+
+DogTable::Index DogTable::Add(const Dog& dog) {
+    const Index index = Size();
+    if (auto [it, inserted] = id_to_index_.emplace(dog.GetId(), index); !inserted) {
+        throw std::invalid_argument("Dog with id "s + std::to_string(*dog.GetId())
+                                    + " already exists"s);
+    }
+    try {
+        ids_.push_back(dog.GetId());
+        names_.push_back(dog.GetName());
+        positions_.push_back(dog.GetPosition());
+        prev_positions_.push_back(dog.GetPosition());
+        speeds_.push_back(dog.GetSpeed());
+        directions_.push_back(dog.GetDirection());
+        bag_capacities_.push_back(dog.GetBagCapacity());
+        bags_.push_back(dog.GetBagContent());
+        bags_.back().reserve(dog.GetBagCapacity());
+        scores_.push_back(dog.GetScore());
+    } catch (...) {
+        // Возвращаем таблицу в исходное состояние, если не удалось добавить собаку
+        Truncate(index);
+        id_to_index_.erase(dog.GetId());
+        throw;
+    }
+    return index;
+}
+
+bool DogTable::Remove(Dog::Id id) {
+    const auto it = id_to_index_.find(id);
+    if (it == id_to_index_.end()) {
+        return false;
+    }
+    const Index index = it->second;
+    const Index last = Size() - 1;
+    id_to_index_.erase(it);
+
+    if (index != last) {
+        // Переносим последнюю собаку на место удаляемой, чтобы индексы остались плотными
+        ids_[index] = ids_[last];
+        names_[index] = std::move(names_[last]);
+        positions_[index] = positions_[last];
+        prev_positions_[index] = prev_positions_[last];
+        speeds_[index] = speeds_[last];
+        directions_[index] = directions_[last];
+        bag_capacities_[index] = bag_capacities_[last];
+        bags_[index] = std::move(bags_[last]);
+        scores_[index] = scores_[last];
+        id_to_index_[ids_[index]] = index;
+    }
+    Truncate(last);
+    return true;
+}
+
+Dog DogTable::GetDog(Index index) const {
+    Dog dog{ids_.at(index), names_[index], positions_[index], bag_capacities_[index]};
+    dog.SetSpeed(speeds_[index]);
+    dog.SetDirection(directions_[index]);
+    dog.AddScore(scores_[index]);
+    for (const auto& item : bags_[index]) {
+        [[maybe_unused]] const bool put = dog.PutToBag(item);
+    }
+    return dog;
+}
+
+void DogTable::AdvancePositions(double dt) noexcept {
+    const size_t size = Size();
+    for (Index i = 0; i < size; ++i) {
+        prev_positions_[i] = positions_[i];
+        positions_[i] += speeds_[i] * dt;
+    }
+}
+
+void DogTable::Truncate(size_t size) noexcept {
+    TruncateColumn(ids_, size);
+    TruncateColumn(names_, size);
+    TruncateColumn(positions_, size);
+    TruncateColumn(prev_positions_, size);
+    TruncateColumn(speeds_, size);
+    TruncateColumn(directions_, size);
+    TruncateColumn(bag_capacities_, size);
+    TruncateColumn(bags_, size);
+    TruncateColumn(scores_, size);
+}
+
+}  // namespace model
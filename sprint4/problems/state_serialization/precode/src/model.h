@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "geom.h"
@@ -135,4 +137,135 @@ private:
 using DogPtr = std::shared_ptr<Dog>;
 using ConstDogPtr = std::shared_ptr<const Dog>;
 
+/*
+ * Таблица собак, хранящая каждое поле собаки в отдельном массиве (structure of arrays).
+ * Собака занимает в каждом массиве элемент с одним и тем же индексом. Индексы плотные:
+ * при удалении собаки на её место переносится последняя собака таблицы, поэтому индекс
+ * собаки может меняться, а её Dog::Id - нет.
+ *
+ * Перемещение собак и поиск событий сбора предметов обращаются только к массивам
+ * позиций и скоростей, не загружая в кеш имена, рюкзаки и очки.
+ */
+class DogTable {
+public:
+    using Index = size_t;
+
+    DogTable() = default;
+
+    size_t Size() const noexcept {
+        return ids_.size();
+    }
+
+    bool Empty() const noexcept {
+        return ids_.empty();
+    }
+
+    // Добавляет собаку в конец таблицы и возвращает её индекс.
+    // Выбрасывает std::invalid_argument, если собака с таким id уже есть
+    Index Add(const Dog& dog);
+
+    // Удаляет собаку. Возвращает false, если собаки с таким id нет
+    bool Remove(Dog::Id id);
+
+    std::optional<Index> FindIndex(Dog::Id id) const noexcept {
+        if (auto it = id_to_index_.find(id); it != id_to_index_.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    // Собирает объект Dog из полей собаки с индексом index
+    Dog GetDog(Index index) const;
+
+    // Сдвигает всех собак на speed * dt. Прежние позиции сохраняются и доступны через
+    // GetPrevPositions, чтобы по паре массивов можно было искать события сбора предметов
+    void AdvancePositions(double dt) noexcept;
+
+    const std::vector<Dog::Id>& GetIds() const noexcept {
+        return ids_;
+    }
+
+    const std::vector<std::string>& GetNames() const noexcept {
+        return names_;
+    }
+
+    const std::vector<geom::Point2D>& GetPositions() const noexcept {
+        return positions_;
+    }
+
+    std::vector<geom::Point2D>& GetPositions() noexcept {
+        return positions_;
+    }
+
+    // Позиции собак до последнего перемещения
+    const std::vector<geom::Point2D>& GetPrevPositions() const noexcept {
+        return prev_positions_;
+    }
+
+    const std::vector<geom::Vec2D>& GetSpeeds() const noexcept {
+        return speeds_;
+    }
+
+    std::vector<geom::Vec2D>& GetSpeeds() noexcept {
+        return speeds_;
+    }
+
+    const std::vector<Direction>& GetDirections() const noexcept {
+        return directions_;
+    }
+
+    std::vector<Direction>& GetDirections() noexcept {
+        return directions_;
+    }
+
+    const std::vector<size_t>& GetBagCapacities() const noexcept {
+        return bag_capacities_;
+    }
+
+    const std::vector<Dog::BagContent>& GetBags() const noexcept {
+        return bags_;
+    }
+
+    const std::vector<Score>& GetScores() const noexcept {
+        return scores_;
+    }
+
+    [[nodiscard]] bool PutToBag(Index index, FoundObject item) {
+        auto& bag = bags_.at(index);
+        if (bag.size() >= bag_capacities_[index]) {
+            return false;
+        }
+        bag.push_back(item);
+        return true;
+    }
+
+    size_t EmptyBag(Index index) noexcept {
+        const size_t size = bags_[index].size();
+        bags_[index].clear();
+        return size;
+    }
+
+    void AddScore(Index index, Score score) noexcept {
+        scores_[index] += score;
+    }
+
+private:
+    using DogIdHasher = util::TaggedHasher<Dog::Id>;
+    using DogIdToIndex = std::unordered_map<Dog::Id, Index, DogIdHasher>;
+
+    // Приводит все массивы к длине size, отбрасывая лишние элементы
+    void Truncate(size_t size) noexcept;
+
+    std::vector<Dog::Id> ids_;
+    std::vector<std::string> names_;
+    std::vector<geom::Point2D> positions_;
+    std::vector<geom::Point2D> prev_positions_;
+    std::vector<geom::Vec2D> speeds_;
+    std::vector<Direction> directions_;
+    std::vector<size_t> bag_capacities_;
+    std::vector<Dog::BagContent> bags_;
+    std::vector<Score> scores_;
+    DogIdToIndex id_to_index_;
+};
+
 }  // namespace model
@@ -1,4 +1,6 @@
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
+#include <stdexcept>
 
 #include "model.h"
 
@@ -82,6 +84,73 @@ private:
     model::Dog::BagContent bag_content_;
 };
 
+// DogTableRepr - сериализованное представление таблицы собак.
+// Массивы таблицы сохраняются целиком, без создания DogRepr для каждой собаки
+class DogTableRepr {
+public:
+    DogTableRepr() = default;
+
+    explicit DogTableRepr(const model::DogTable& table)
+        : names_(table.GetNames())
+        , positions_(table.GetPositions())
+        , bag_capacities_(table.GetBagCapacities())
+        , speeds_(table.GetSpeeds())
+        , directions_(table.GetDirections())
+        , scores_(table.GetScores())
+        , bags_(table.GetBags()) {
+        ids_.reserve(table.Size());
+        for (const auto& id : table.GetIds()) {
+            ids_.push_back(*id);
+        }
+    }
+
+    [[nodiscard]] model::DogTable Restore() const {
+        const size_t size = ids_.size();
+        if (names_.size() != size || positions_.size() != size || bag_capacities_.size() != size
+            || speeds_.size() != size || directions_.size() != size || scores_.size() != size
+            || bags_.size() != size) {
+            throw std::runtime_error("Inconsistent dog table");
+        }
+
+        model::DogTable table;
+        for (size_t i = 0; i < size; ++i) {
+            model::Dog dog{model::Dog::Id{ids_[i]}, names_[i], positions_[i], bag_capacities_[i]};
+            dog.SetSpeed(speeds_[i]);
+            dog.SetDirection(directions_[i]);
+            dog.AddScore(scores_[i]);
+            for (const auto& item : bags_[i]) {
+                if (!dog.PutToBag(item)) {
+                    throw std::runtime_error("Failed to put bag content");
+                }
+            }
+            table.Add(dog);
+        }
+        return table;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+        ar& ids_;
+        ar& names_;
+        ar& positions_;
+        ar& bag_capacities_;
+        ar& speeds_;
+        ar& directions_;
+        ar& scores_;
+        ar& bags_;
+    }
+
+private:
+    std::vector<uint32_t> ids_;
+    std::vector<std::string> names_;
+    std::vector<geom::Point2D> positions_;
+    std::vector<size_t> bag_capacities_;
+    std::vector<geom::Vec2D> speeds_;
+    std::vector<model::Direction> directions_;
+    std::vector<model::Score> scores_;
+    std::vector<model::Dog::BagContent> bags_;
+};
+
 /* Другие классы модели сериализуются и десериализуются похожим образом */
 
 }  // namespace serialization
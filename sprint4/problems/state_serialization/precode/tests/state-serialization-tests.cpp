@@ -69,3 +69,92 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+SCENARIO("Dog table") {
+    GIVEN("a dog table with three dogs") {
+        DogTable table;
+        for (uint32_t id : {1u, 2u, 3u}) {
+            table.Add(Dog{Dog::Id{id}, "Dog"s + std::to_string(id), {1.0 * id, 0.0}, 2});
+        }
+
+        WHEN("a dog with the same id is added") {
+            THEN("an exception is thrown") {
+                CHECK_THROWS_AS(table.Add(Dog{Dog::Id{2u}, "Copy"s, {}, 1}), std::invalid_argument);
+                CHECK(table.Size() == 3);
+            }
+        }
+
+        WHEN("a dog in the middle is removed") {
+            REQUIRE(table.Remove(Dog::Id{1u}));
+
+            THEN("remaining dogs keep their ids and fields") {
+                CHECK(table.Size() == 2);
+                CHECK_FALSE(table.FindIndex(Dog::Id{1u}).has_value());
+                for (uint32_t id : {2u, 3u}) {
+                    const auto index = table.FindIndex(Dog::Id{id});
+                    REQUIRE(index.has_value());
+                    CHECK(table.GetIds()[*index] == Dog::Id{id});
+                    CHECK(table.GetNames()[*index] == "Dog"s + std::to_string(id));
+                    CHECK(table.GetPositions()[*index] == geom::Point2D{1.0 * id, 0.0});
+                }
+                CHECK_FALSE(table.Remove(Dog::Id{1u}));
+            }
+        }
+
+        WHEN("dogs are moved") {
+            const auto index = *table.FindIndex(Dog::Id{2u});
+            table.GetSpeeds()[index] = {1.0, -2.0};
+            table.AdvancePositions(0.5);
+
+            THEN("only moving dogs change their position") {
+                CHECK(table.GetPrevPositions()[index] == geom::Point2D{2.0, 0.0});
+                CHECK(table.GetPositions()[index] == geom::Point2D{2.5, -1.0});
+                const auto other = *table.FindIndex(Dog::Id{3u});
+                CHECK(table.GetPositions()[other] == table.GetPrevPositions()[other]);
+            }
+        }
+    }
+}
+
+SCENARIO_METHOD(Fixture, "Dog table serialization") {
+    GIVEN("a dog table") {
+        DogTable table;
+        for (uint32_t id : {7u, 3u}) {
+            Dog dog{Dog::Id{id}, "Dog"s + std::to_string(id), {0.5 * id, 1.5}, 3};
+            dog.AddScore(id * 10);
+            dog.SetSpeed({0.0, 1.0 * id});
+            dog.SetDirection(Direction::SOUTH);
+            CHECK(dog.PutToBag({FoundObject::Id{id}, 1u}));
+            table.Add(dog);
+        }
+
+        WHEN("table is serialized") {
+            {
+                serialization::DogTableRepr repr{table};
+                output_archive << repr;
+            }
+
+            THEN("it can be deserialized") {
+                InputArchive input_archive{strm};
+                serialization::DogTableRepr repr;
+                input_archive >> repr;
+                const auto restored = repr.Restore();
+
+                REQUIRE(restored.Size() == table.Size());
+                for (DogTable::Index i = 0; i < table.Size(); ++i) {
+                    const auto index = restored.FindIndex(table.GetIds()[i]);
+                    REQUIRE(index.has_value());
+                    const Dog dog = table.GetDog(i);
+                    const Dog restored_dog = restored.GetDog(*index);
+                    CHECK(dog.GetName() == restored_dog.GetName());
+                    CHECK(dog.GetPosition() == restored_dog.GetPosition());
+                    CHECK(dog.GetSpeed() == restored_dog.GetSpeed());
+                    CHECK(dog.GetDirection() == restored_dog.GetDirection());
+                    CHECK(dog.GetScore() == restored_dog.GetScore());
+                    CHECK(dog.GetBagCapacity() == restored_dog.GetBagCapacity());
+                    CHECK(dog.GetBagContent() == restored_dog.GetBagContent());
+                }
+            }
+        }
+    }
+}